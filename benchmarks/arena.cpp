@@ -0,0 +1,49 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/arena.hpp>
+
+#include <benchmark/benchmark.h>
+
+namespace
+{
+void arena_allocate(benchmark::State& state)
+{
+    auto size  = std::size_t(state.range(0));
+    auto count = std::size_t(state.range(1));
+
+    dryad::arena<> arena;
+    for (auto _ : state)
+    {
+        for (auto i = std::size_t(0); i != count; ++i)
+            benchmark::DoNotOptimize(arena.allocate(size, alignof(void*)));
+        arena.clear();
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * count));
+    state.SetBytesProcessed(std::int64_t(state.iterations() * count * size));
+}
+BENCHMARK(arena_allocate)->ArgsProduct({{8, 24, 64, 256}, {1 << 10, 1 << 16, 1 << 20}});
+
+// Same as above, but a fresh arena every time, so it includes the cost of allocating blocks.
+void arena_allocate_cold(benchmark::State& state)
+{
+    auto size   = std::size_t(state.range(0));
+    auto count  = std::size_t(state.range(1));
+    auto growth = state.range(2) != 0 ? dryad::arena_growth::geometric
+                                      : dryad::arena_growth::constant;
+
+    for (auto _ : state)
+    {
+        dryad::arena<> arena(dryad::arena<>::default_block_size, growth);
+        for (auto i = std::size_t(0); i != count; ++i)
+            benchmark::DoNotOptimize(arena.allocate(size, alignof(void*)));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * count));
+    state.SetBytesProcessed(std::int64_t(state.iterations() * count * size));
+}
+BENCHMARK(arena_allocate_cold)
+    ->ArgsProduct({{8, 24, 64, 256}, {1 << 10, 1 << 16, 1 << 20}, {0, 1}})
+    ->ArgNames({"size", "count", "geometric"});
+} // namespace
@@ -0,0 +1,125 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_BENCHMARKS_AST_HPP_INCLUDED
+#define DRYAD_BENCHMARKS_AST_HPP_INCLUDED
+
+#include <algorithm>
+#include <cstdint>
+#include <dryad/tree.hpp>
+#include <random>
+#include <vector>
+
+// A synthetic AST used by the tree benchmarks.
+namespace bench
+{
+enum class node_kind
+{
+    literal,
+    identifier,
+    call,
+    block,
+};
+
+using node = dryad::node<node_kind>;
+
+struct literal : dryad::basic_node<node_kind::literal>
+{
+    std::uint64_t value;
+
+    literal(dryad::node_ctor ctor, std::uint64_t value) : node_base(ctor), value(value) {}
+};
+
+struct identifier : dryad::basic_node<node_kind::identifier>
+{
+    DRYAD_NODE_CTOR(identifier);
+};
+
+struct call : dryad::basic_node<node_kind::call, dryad::container_node<node>>
+{
+    DRYAD_NODE_CTOR(call);
+
+    void set_children(dryad::unlinked_node_list<node> children)
+    {
+        insert_child_list_after(nullptr, children);
+    }
+};
+
+struct block : dryad::basic_node<node_kind::block, dryad::container_node<node>>
+{
+    DRYAD_NODE_CTOR(block);
+
+    void set_children(dryad::unlinked_node_list<node> children)
+    {
+        insert_child_list_after(nullptr, children);
+    }
+};
+
+using tree = dryad::tree<block>;
+
+// Builds a tree of (roughly) the given number of nodes bottom-up.
+// Each container has between one and `max_fan_out` children, chosen randomly but deterministic.
+// If `scatter` is set, the leaves are shuffled, so siblings aren't next to each other in memory,
+// like in a tree that has been edited a lot.
+inline void build_ast(tree& result, std::size_t node_count, unsigned max_fan_out = 8,
+                      bool scatter = false)
+{
+    std::mt19937_64                         rng(node_count);
+    std::uniform_int_distribution<unsigned> fan_out(1, max_fan_out);
+
+    // Create the leaves, roughly 3/4 of all nodes for the default fan out.
+    std::vector<node*> level;
+    auto               leaf_count = node_count - node_count / (max_fan_out / 2 + 1);
+    for (auto i = std::size_t(0); i != leaf_count; ++i)
+    {
+        if (rng() % 2 == 0)
+            level.push_back(result.create<literal>(i));
+        else
+            level.push_back(result.create<identifier>());
+    }
+    if (scatter)
+        std::shuffle(level.begin(), level.end(), rng);
+
+    // Group them into containers until only a single root remains.
+    std::vector<node*> next_level;
+    while (level.size() > 1)
+    {
+        next_level.clear();
+        for (auto i = std::size_t(0); i < level.size();)
+        {
+            dryad::unlinked_node_list<node> children;
+            for (auto n = fan_out(rng); n > 0 && i < level.size(); --n, ++i)
+                children.push_back(level[i]);
+
+            if (rng() % 4 == 0)
+            {
+                auto container = result.create<block>();
+                container->set_children(children);
+                next_level.push_back(container);
+            }
+            else
+            {
+                auto container = result.create<call>();
+                container->set_children(children);
+                next_level.push_back(container);
+            }
+        }
+        level.swap(next_level);
+    }
+
+    auto root = result.create<block>();
+    root->set_children(level.front());
+    result.set_root(root);
+}
+
+inline std::size_t count_nodes(const tree& t)
+{
+    auto count = std::size_t(0);
+    for (auto [ev, n] : dryad::traverse(t))
+        if (ev != dryad::traverse_event::exit)
+            ++count;
+    return count;
+}
+} // namespace bench
+
+#endif // DRYAD_BENCHMARKS_AST_HPP_INCLUDED
@@ -0,0 +1,71 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/concurrent_symbol_interner.hpp>
+
+#include "identifiers.hpp"
+#include <benchmark/benchmark.h>
+#include <mutex>
+
+namespace
+{
+using concurrent_interner = dryad::concurrent_symbol_interner<struct bench_id>;
+using interner            = dryad::symbol_interner<struct bench_id>;
+
+const auto identifiers = bench::make_identifiers(10 * 1000);
+
+// Every string has already been interned, so it never locks.
+void concurrent_symbol_interner_intern_hit(benchmark::State& state)
+{
+    static concurrent_interner symbols;
+    if (state.thread_index() == 0)
+        for (auto& str : identifiers)
+            symbols.intern(str.c_str(), str.size());
+
+    for (auto _ : state)
+    {
+        for (auto& str : identifiers)
+            benchmark::DoNotOptimize(symbols.intern(str.c_str(), str.size()));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * identifiers.size()));
+}
+BENCHMARK(concurrent_symbol_interner_intern_hit)->ThreadRange(1, 8)->UseRealTime();
+
+// The alternative: a global lock around a regular interner.
+void locked_symbol_interner_intern_hit(benchmark::State& state)
+{
+    static interner   symbols;
+    static std::mutex mutex;
+    if (state.thread_index() == 0)
+        for (auto& str : identifiers)
+            symbols.intern(str.c_str(), str.size());
+
+    for (auto _ : state)
+    {
+        for (auto& str : identifiers)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            benchmark::DoNotOptimize(symbols.intern(str.c_str(), str.size()));
+        }
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * identifiers.size()));
+}
+BENCHMARK(locked_symbol_interner_intern_hit)->ThreadRange(1, 8)->UseRealTime();
+
+// Every string is new to the interner.
+void concurrent_symbol_interner_intern_miss(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        concurrent_interner symbols;
+        for (auto& str : identifiers)
+            benchmark::DoNotOptimize(symbols.intern(str.c_str(), str.size()));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * identifiers.size()));
+}
+BENCHMARK(concurrent_symbol_interner_intern_miss);
+} // namespace
+
@@ -0,0 +1,251 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/hash_forest.hpp>
+
+#include <benchmark/benchmark.h>
+#include <random>
+#include <vector>
+
+namespace
+{
+// A type system where types are interned.
+enum class type_kind
+{
+    builtin,
+    pointer,
+    function,
+};
+
+using type_node = dryad::node<type_kind>;
+
+struct builtin_type : dryad::basic_node<type_kind::builtin>
+{
+    unsigned id;
+
+    builtin_type(dryad::node_ctor ctor, unsigned id) : node_base(ctor), id(id) {}
+};
+
+struct pointer_type : dryad::basic_node<type_kind::pointer, dryad::container_node<type_node>>
+{
+    pointer_type(dryad::node_ctor ctor, type_node* pointee) : node_base(ctor)
+    {
+        insert_child_after(nullptr, pointee);
+    }
+};
+
+struct function_type : dryad::basic_node<type_kind::function, dryad::container_node<type_node>>
+{
+    function_type(dryad::node_ctor ctor, dryad::unlinked_node_list<type_node> signature)
+    : node_base(ctor)
+    {
+        insert_child_list_after(nullptr, signature);
+    }
+};
+
+struct type_hasher
+: dryad::node_hasher_base<type_hasher, builtin_type, pointer_type, function_type>
+{
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, const builtin_type* n)
+    {
+        hasher.hash_scalar(n->id);
+    }
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm&, const pointer_type*)
+    {}
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm&, const function_type*)
+    {}
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, unsigned id)
+    {
+        hasher.hash_scalar(id);
+    }
+
+    static bool is_equal(const builtin_type* lhs, const builtin_type* rhs)
+    {
+        return lhs->id == rhs->id;
+    }
+    static bool is_equal(const pointer_type*, const pointer_type*)
+    {
+        return true;
+    }
+    static bool is_equal(const function_type*, const function_type*)
+    {
+        return true;
+    }
+    static bool is_equal(const builtin_type* entry, unsigned id)
+    {
+        return entry->id == id;
+    }
+};
+
+using forest       = dryad::hash_forest<type_node, type_hasher>;
+using node_creator = forest::node_creator;
+template <typename Probing>
+using probing_forest
+    = dryad::hash_forest<type_node, type_hasher, void, dryad::default_hash_algorithm, Probing>;
+
+type_node* build_type(node_creator creator, unsigned seed, unsigned depth)
+{
+    if (depth == 0)
+        return creator.create<builtin_type>(seed % 16);
+    else if (seed % 3 == 0)
+        return creator.create<pointer_type>(build_type(creator, seed / 3, depth - 1));
+
+    dryad::unlinked_node_list<type_node> signature;
+    for (auto i = 0u; i != seed % 4 + 1; ++i)
+        signature.push_back(build_type(creator, seed / 4 + i, depth - 1));
+    return creator.create<function_type>(signature);
+}
+
+// Builds `count` function types, `1 / duplicate_ratio` of them are unique.
+template <typename Probing>
+void hash_forest_build(benchmark::State& state)
+{
+    auto count           = unsigned(state.range(0));
+    auto duplicate_ratio = unsigned(state.range(1));
+
+    for (auto _ : state)
+    {
+        probing_forest<Probing> types;
+        for (auto i = 0u; i != count; ++i)
+        {
+            auto seed = i / duplicate_ratio;
+            benchmark::DoNotOptimize(
+                types.build([&](node_creator creator) { return build_type(creator, seed, 3); }));
+        }
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * count));
+}
+BENCHMARK_TEMPLATE(hash_forest_build, dryad::linear_probing)
+    ->ArgsProduct({{1000, 10 * 1000, 100 * 1000}, {1, 4}});
+BENCHMARK_TEMPLATE(hash_forest_build, dryad::group_probing)
+    ->ArgsProduct({{1000, 10 * 1000, 100 * 1000}, {1, 4}});
+
+template <typename Probing>
+void hash_forest_lookup_or_create(benchmark::State& state)
+{
+    auto count = unsigned(state.range(0));
+
+    std::mt19937                            rng(count);
+    std::uniform_int_distribution<unsigned> dist(0, count - 1);
+    std::vector<unsigned>                   ids;
+    for (auto i = 0u; i != count; ++i)
+        ids.push_back(dist(rng));
+
+    probing_forest<Probing> types;
+    for (auto _ : state)
+    {
+        for (auto id : ids)
+            benchmark::DoNotOptimize(types.template lookup_or_create<builtin_type>(id));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * count));
+}
+BENCHMARK_TEMPLATE(hash_forest_lookup_or_create, dryad::linear_probing)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+BENCHMARK_TEMPLATE(hash_forest_lookup_or_create, dryad::group_probing)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+
+// A pointer type that refers to its interned pointee instead of owning a copy of it,
+// so the types form a DAG.
+struct dag_pointer_type : dryad::basic_node<type_kind::pointer>
+{
+    const type_node* pointee;
+
+    dag_pointer_type(dryad::node_ctor ctor, const type_node* pointee)
+    : node_base(ctor), pointee(pointee)
+    {}
+};
+
+struct dag_type_hasher : dryad::node_hasher_base<dag_type_hasher, builtin_type, dag_pointer_type>
+{
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, const builtin_type* n)
+    {
+        hasher.hash_scalar(n->id);
+    }
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, const dag_pointer_type* n)
+    {
+        hasher.hash_scalar(n->pointee);
+    }
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, unsigned id)
+    {
+        hasher.hash_scalar(id);
+    }
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, const type_node* pointee)
+    {
+        hasher.hash_scalar(pointee);
+    }
+
+    static bool is_equal(const builtin_type* lhs, const builtin_type* rhs)
+    {
+        return lhs->id == rhs->id;
+    }
+    static bool is_equal(const dag_pointer_type* lhs, const dag_pointer_type* rhs)
+    {
+        return lhs->pointee == rhs->pointee;
+    }
+    static bool is_equal(const builtin_type* entry, unsigned id)
+    {
+        return entry->id == id;
+    }
+    static bool is_equal(const dag_pointer_type* entry, const type_node* pointee)
+    {
+        return entry->pointee == pointee;
+    }
+};
+
+// Interns pointer types nested `depth` levels deep, once as trees and once as a DAG.
+void hash_forest_nested_pointer_tree(benchmark::State& state)
+{
+    auto depth = unsigned(state.range(0));
+
+    for (auto _ : state)
+    {
+        forest types;
+        for (auto id = 0u; id != 256; ++id)
+            for (auto d = 1u; d <= depth; ++d)
+                benchmark::DoNotOptimize(types.build([&](node_creator creator) {
+                    type_node* cur = creator.create<builtin_type>(id);
+                    for (auto i = 0u; i != d; ++i)
+                        cur = creator.create<pointer_type>(cur);
+                    return cur;
+                }));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * 256 * depth));
+}
+BENCHMARK(hash_forest_nested_pointer_tree)->RangeMultiplier(4)->Range(1, 64);
+
+void hash_forest_nested_pointer_dag(benchmark::State& state)
+{
+    auto depth = unsigned(state.range(0));
+
+    for (auto _ : state)
+    {
+        dryad::hash_forest<type_node, dag_type_hasher> types;
+        for (auto id = 0u; id != 256; ++id)
+        {
+            const type_node* cur = types.lookup_or_create<builtin_type>(id);
+            for (auto d = 1u; d <= depth; ++d)
+            {
+                cur = types.lookup_or_create<dag_pointer_type>(cur);
+                benchmark::DoNotOptimize(cur);
+            }
+        }
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * 256 * depth));
+}
+BENCHMARK(hash_forest_nested_pointer_dag)->RangeMultiplier(4)->Range(1, 64);
+} // namespace
+
@@ -0,0 +1,41 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_BENCHMARKS_IDENTIFIERS_HPP_INCLUDED
+#define DRYAD_BENCHMARKS_IDENTIFIERS_HPP_INCLUDED
+
+#include <random>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace bench
+{
+// Generates `count` distinct identifier-like strings: a random prefix with a length between 1 and
+// `max_length`, followed by `$` and the index of the string.
+inline std::vector<std::string> make_identifiers(std::size_t count, std::size_t max_length = 16)
+{
+    static constexpr char alphabet[] = "abcdefghijklmnopqrstuvwxyzABCDEFGHIJKLMNOPQRSTUVWXYZ_0123456789";
+
+    std::mt19937_64                            rng(count);
+    std::uniform_int_distribution<std::size_t> length(1, max_length);
+    std::uniform_int_distribution<std::size_t> character(0, sizeof(alphabet) - 2);
+
+    std::vector<std::string> result;
+    result.reserve(count);
+    for (auto i = std::size_t(0); i != count; ++i)
+    {
+        std::string str;
+        for (auto n = length(rng); n > 0; --n)
+            str.push_back(alphabet[character(rng)]);
+
+        // Ensure uniqueness by appending the index after a character that isn't in the alphabet.
+        str += '$';
+        str += std::to_string(i);
+        result.push_back(std::move(str));
+    }
+    return result;
+}
+} // namespace bench
+
+#endif // DRYAD_BENCHMARKS_IDENTIFIERS_HPP_INCLUDED
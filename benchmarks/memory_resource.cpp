@@ -0,0 +1,92 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/memory_resource.hpp>
+
+#include "identifiers.hpp"
+#include <benchmark/benchmark.h>
+#include <dryad/symbol_table.hpp>
+
+namespace
+{
+// Many short-lived arenas, e.g. one per parsed function, that allocate a couple of blocks each.
+template <typename MemoryResource>
+void arena_cycle(benchmark::State& state, MemoryResource* resource)
+{
+    auto blocks = std::size_t(state.range(0));
+    for (auto _ : state)
+    {
+        dryad::arena<MemoryResource> arena(resource);
+        for (auto i = std::size_t(0); i != blocks; ++i)
+            for (auto j = 0; j != 15; ++j)
+                benchmark::DoNotOptimize(arena.allocate(1024, alignof(void*)));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * blocks));
+}
+
+void arena_cycle_default(benchmark::State& state)
+{
+    arena_cycle<void>(state, nullptr);
+}
+BENCHMARK(arena_cycle_default)->RangeMultiplier(4)->Range(1, 64)->ThreadRange(1, 4);
+
+dryad::block_pool_resource<> shared_pool;
+
+void arena_cycle_block_pool(benchmark::State& state)
+{
+    arena_cycle(state, &shared_pool);
+}
+BENCHMARK(arena_cycle_block_pool)->RangeMultiplier(4)->Range(1, 64)->ThreadRange(1, 4);
+
+using interner = dryad::symbol_interner<struct bench_id>;
+using symbol   = interner::symbol;
+
+// A scope that declares more names than fit inline, so the table is allocated and grown.
+template <typename MemoryResource>
+void symbol_table_scopes(benchmark::State& state)
+{
+    auto                identifiers = bench::make_identifiers(1024);
+    interner            symbols;
+    std::vector<symbol> syms;
+    for (auto& str : identifiers)
+        syms.push_back(symbols.intern(str.c_str(), str.size()));
+
+    auto names = std::size_t(state.range(0));
+    for (auto _ : state)
+    {
+        for (auto scope = std::size_t(0); scope + names <= syms.size(); scope += names)
+        {
+            alignas(std::max_align_t) unsigned char buffer[32 * 1024];
+            dryad::monotonic_buffer_resource        resource(buffer);
+
+            using table = dryad::symbol_table<symbol, const std::string*, MemoryResource>;
+            auto t      = [&] {
+                if constexpr (std::is_void_v<MemoryResource>)
+                    return table();
+                else
+                    return table(&resource);
+            }();
+            for (auto i = scope; i != scope + names; ++i)
+                t.insert_or_shadow(syms[i], &identifiers[i]);
+            for (auto i = scope; i != scope + names; ++i)
+                benchmark::DoNotOptimize(t.lookup(syms[i]));
+        }
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * (syms.size() / names)));
+}
+
+void symbol_table_scopes_default(benchmark::State& state)
+{
+    symbol_table_scopes<void>(state);
+}
+BENCHMARK(symbol_table_scopes_default)->RangeMultiplier(4)->Range(16, 256);
+
+void symbol_table_scopes_buffer(benchmark::State& state)
+{
+    symbol_table_scopes<dryad::monotonic_buffer_resource>(state);
+}
+BENCHMARK(symbol_table_scopes_buffer)->RangeMultiplier(4)->Range(16, 256);
+} // namespace
+
@@ -0,0 +1,153 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/node_map.hpp>
+#include <dryad/node_vector.hpp>
+
+#include "ast.hpp"
+#include <benchmark/benchmark.h>
+
+// The node_vector benchmark numbers the nodes of the AST.
+template <>
+constexpr bool dryad::enable_node_numbering<bench::node_kind> = true;
+
+namespace
+{
+std::vector<bench::node*> collect_nodes(bench::tree& tree)
+{
+    std::vector<bench::node*> result;
+    for (auto [ev, n] : dryad::traverse(tree))
+        if (ev != dryad::traverse_event::exit)
+            result.push_back(n);
+    return result;
+}
+
+template <typename Probing>
+void node_map_insert(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+    auto nodes = collect_nodes(tree);
+
+    for (auto _ : state)
+    {
+        dryad::node_map<bench::node, std::uint64_t, void, void, Probing> map;
+        for (auto n : nodes)
+            benchmark::DoNotOptimize(map.insert(n, std::uint64_t(0)));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * nodes.size()));
+}
+BENCHMARK_TEMPLATE(node_map_insert, dryad::linear_probing)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+BENCHMARK_TEMPLATE(node_map_insert, dryad::group_probing)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+
+template <typename Probing>
+void node_map_lookup(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+    auto nodes = collect_nodes(tree);
+
+    dryad::node_map<bench::node, std::uint64_t, void, void, Probing> map;
+    for (auto n : nodes)
+        map.insert(n, std::uint64_t(0));
+
+    for (auto _ : state)
+    {
+        for (auto n : nodes)
+            benchmark::DoNotOptimize(map.lookup(n));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * nodes.size()));
+}
+BENCHMARK_TEMPLATE(node_map_lookup, dryad::linear_probing)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+BENCHMARK_TEMPLATE(node_map_lookup, dryad::group_probing)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+
+// Keeps a sliding window of nodes in the map, e.g. a worklist; the map is never emptied.
+template <typename Probing>
+void node_map_churn(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, 1000 * 1000);
+    auto nodes = collect_nodes(tree);
+
+    auto window = std::size_t(state.range(0));
+    dryad::node_map<bench::node, std::uint64_t, void, void, Probing> map;
+    for (auto i = std::size_t(0); i != window; ++i)
+        map.insert(nodes[i], std::uint64_t(0));
+
+    auto oldest = std::size_t(0);
+    for (auto _ : state)
+    {
+        auto newest = (oldest + window) % nodes.size();
+        map.remove(nodes[oldest]);
+        map.insert(nodes[newest], std::uint64_t(0));
+        benchmark::DoNotOptimize(map.lookup(nodes[(oldest + window / 2) % nodes.size()]));
+        oldest = (oldest + 1) % nodes.size();
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations()));
+    state.counters["capacity"] = double(map.capacity());
+}
+BENCHMARK_TEMPLATE(node_map_churn, dryad::linear_probing)
+    ->RangeMultiplier(10)
+    ->Range(100, 100 * 1000);
+BENCHMARK_TEMPLATE(node_map_churn, dryad::group_probing)
+    ->RangeMultiplier(10)
+    ->Range(100, 100 * 1000);
+
+// Annotating every node during a traversal, the typical use case of a type checker.
+void node_map_annotate_traverse(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    dryad::node_map<const bench::node, std::uint64_t> map;
+    for (auto [ev, n] : dryad::traverse(tree))
+        if (ev != dryad::traverse_event::exit)
+            map.insert(n, std::uint64_t(1));
+
+    for (auto _ : state)
+    {
+        auto sum = std::uint64_t(0);
+        for (auto [ev, n] : dryad::traverse(tree))
+            if (ev != dryad::traverse_event::exit)
+                sum += *map.lookup(n);
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * map.size()));
+}
+BENCHMARK(node_map_annotate_traverse)->RangeMultiplier(10)->Range(1000, 1000 * 1000);
+
+// Same as above, but the annotations are stored in a side table indexed by node id.
+void node_vector_annotate_traverse(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    dryad::node_vector<const bench::node, std::uint64_t> vec(dryad::number_nodes(tree));
+    for (auto i = std::size_t(0); i != vec.size(); ++i)
+        vec.data()[i] = 1;
+
+    for (auto _ : state)
+    {
+        auto sum = std::uint64_t(0);
+        for (auto [ev, n] : dryad::traverse(tree))
+            if (ev != dryad::traverse_event::exit)
+                sum += vec[n];
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * vec.size()));
+}
+BENCHMARK(node_vector_annotate_traverse)->RangeMultiplier(10)->Range(1000, 1000 * 1000);
+} // namespace
@@ -0,0 +1,202 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/symbol.hpp>
+
+#include "identifiers.hpp"
+#include <benchmark/benchmark.h>
+#include <vector>
+
+namespace
+{
+using interner = dryad::symbol_interner<struct bench_id>;
+template <typename Probing, typename Storage>
+using bench_interner
+    = dryad::symbol_interner<bench_id, char, std::size_t, void, dryad::default_hash_algorithm,
+                             Probing, Storage>;
+
+// Every string is new to the interner.
+template <typename Probing, typename Storage>
+void symbol_interner_intern_miss(benchmark::State& state)
+{
+    auto identifiers = bench::make_identifiers(std::size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        bench_interner<Probing, Storage> symbols;
+        for (auto& str : identifiers)
+            benchmark::DoNotOptimize(symbols.intern(str.c_str(), str.size()));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * identifiers.size()));
+}
+BENCHMARK_TEMPLATE(symbol_interner_intern_miss, dryad::linear_probing,
+                   dryad::contiguous_symbol_storage)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+BENCHMARK_TEMPLATE(symbol_interner_intern_miss, dryad::group_probing,
+                   dryad::contiguous_symbol_storage)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+BENCHMARK_TEMPLATE(symbol_interner_intern_miss, dryad::linear_probing,
+                   dryad::chunked_symbol_storage)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+
+// Same as above, but with a reserved interner.
+void symbol_interner_intern_miss_reserved(benchmark::State& state)
+{
+    auto identifiers = bench::make_identifiers(std::size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        interner symbols;
+        symbols.reserve(identifiers.size(), 16);
+        for (auto& str : identifiers)
+            benchmark::DoNotOptimize(symbols.intern(str.c_str(), str.size()));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * identifiers.size()));
+}
+BENCHMARK(symbol_interner_intern_miss_reserved)->RangeMultiplier(10)->Range(1000, 1000 * 1000);
+
+// Every string has already been interned.
+template <typename Probing, typename Storage>
+void symbol_interner_intern_hit(benchmark::State& state)
+{
+    auto identifiers = bench::make_identifiers(std::size_t(state.range(0)));
+
+    bench_interner<Probing, Storage> symbols;
+    for (auto& str : identifiers)
+        symbols.intern(str.c_str(), str.size());
+
+    for (auto _ : state)
+    {
+        for (auto& str : identifiers)
+            benchmark::DoNotOptimize(symbols.intern(str.c_str(), str.size()));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * identifiers.size()));
+}
+BENCHMARK_TEMPLATE(symbol_interner_intern_hit, dryad::linear_probing,
+                   dryad::contiguous_symbol_storage)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+BENCHMARK_TEMPLATE(symbol_interner_intern_hit, dryad::group_probing,
+                   dryad::contiguous_symbol_storage)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+BENCHMARK_TEMPLATE(symbol_interner_intern_hit, dryad::linear_probing,
+                   dryad::chunked_symbol_storage)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+
+// Compare with symbol_interner_intern_miss: restoring the same interner from a snapshot.
+template <bool Borrow>
+void symbol_interner_load_snapshot(benchmark::State& state)
+{
+    auto identifiers = bench::make_identifiers(std::size_t(state.range(0)));
+
+    interner symbols;
+    for (auto& str : identifiers)
+        symbols.intern(str.c_str(), str.size());
+
+    std::vector<std::uint64_t> image(symbols.snapshot_size() / sizeof(std::uint64_t) + 1);
+    auto size = symbols.write_snapshot(image.data(), image.size() * sizeof(std::uint64_t));
+
+    for (auto _ : state)
+    {
+        interner loaded;
+        if constexpr (Borrow)
+            benchmark::DoNotOptimize(loaded.borrow_snapshot(image.data(), size));
+        else
+            benchmark::DoNotOptimize(loaded.load_snapshot(image.data(), size));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * identifiers.size()));
+}
+BENCHMARK_TEMPLATE(symbol_interner_load_snapshot, false)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+BENCHMARK_TEMPLATE(symbol_interner_load_snapshot, true)
+    ->RangeMultiplier(10)
+    ->Range(1000, 1000 * 1000);
+
+// Long strings, such as string literals, where hashing dominates.
+template <typename HashAlgorithm>
+void symbol_interner_intern_long(benchmark::State& state)
+{
+    auto identifiers = bench::make_identifiers(1000, std::size_t(state.range(0)));
+
+    dryad::symbol_interner<struct bench_id, char, std::size_t, void, HashAlgorithm> symbols;
+    for (auto& str : identifiers)
+        symbols.intern(str.c_str(), str.size());
+
+    for (auto _ : state)
+    {
+        for (auto& str : identifiers)
+            benchmark::DoNotOptimize(symbols.intern(str.c_str(), str.size()));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * identifiers.size()));
+}
+BENCHMARK_TEMPLATE(symbol_interner_intern_long, dryad::default_hash_algorithm)
+    ->RangeMultiplier(4)
+    ->Range(16, 1024);
+BENCHMARK_TEMPLATE(symbol_interner_intern_long, dryad::wyhash_algorithm)
+    ->RangeMultiplier(4)
+    ->Range(16, 1024);
+
+constexpr auto keywords = dryad::make_symbol_seed(
+    "auto", "break", "case", "char", "const", "continue", "default", "do", "double", "else",
+    "enum", "extern", "float", "for", "goto", "if", "inline", "int", "long", "register",
+    "restrict", "return", "short", "signed", "sizeof", "static", "struct", "switch", "typedef",
+    "union", "unsigned", "void", "volatile", "while");
+
+std::vector<std::string> make_tokens()
+{
+    // Every fourth token is a keyword.
+    auto tokens = bench::make_identifiers(10 * 1000, 8);
+    for (auto i = std::size_t(0); i < tokens.size(); i += 4)
+        tokens[i] = keywords.c_str(i % keywords.size());
+    return tokens;
+}
+
+// Classify identifier tokens by interning them and checking whether the symbol is a keyword.
+void symbol_interner_classify_keyword(benchmark::State& state)
+{
+    auto tokens = make_tokens();
+
+    interner symbols;
+    symbols.seed(keywords);
+    auto last_keyword = keywords.symbol<interner::symbol>(keywords.size() - 1);
+
+    for (auto _ : state)
+    {
+        for (auto& str : tokens)
+        {
+            auto sym = symbols.intern(str.c_str(), str.size());
+            benchmark::DoNotOptimize(sym <= last_keyword);
+        }
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * tokens.size()));
+}
+BENCHMARK(symbol_interner_classify_keyword);
+
+// Same as above, but using the perfect hash table of the seed.
+void symbol_seed_classify_keyword(benchmark::State& state)
+{
+    auto tokens = make_tokens();
+
+    for (auto _ : state)
+    {
+        for (auto& str : tokens)
+            benchmark::DoNotOptimize(keywords.lookup(str.c_str(), str.size()));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * tokens.size()));
+}
+BENCHMARK(symbol_seed_classify_keyword);
+} // namespace
+
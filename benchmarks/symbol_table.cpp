@@ -0,0 +1,154 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/symbol_table.hpp>
+
+#include "identifiers.hpp"
+#include <benchmark/benchmark.h>
+
+namespace
+{
+using interner = dryad::symbol_interner<struct bench_id>;
+using symbol   = interner::symbol;
+using table    = dryad::symbol_table<symbol, const std::string*>;
+template <typename Probing>
+using probing_table = dryad::symbol_table<symbol, const std::string*, void, Probing>;
+
+std::vector<symbol> intern_all(interner& symbols, const std::vector<std::string>& identifiers)
+{
+    std::vector<symbol> result;
+    result.reserve(identifiers.size());
+    for (auto& str : identifiers)
+        result.push_back(symbols.intern(str.c_str(), str.size()));
+    return result;
+}
+
+template <typename Probing>
+void symbol_table_insert_or_shadow(benchmark::State& state)
+{
+    auto     identifiers = bench::make_identifiers(std::size_t(state.range(0)));
+    interner symbols;
+    auto     syms = intern_all(symbols, identifiers);
+
+    for (auto _ : state)
+    {
+        probing_table<Probing> t;
+        for (auto i = std::size_t(0); i != syms.size(); ++i)
+            benchmark::DoNotOptimize(t.insert_or_shadow(syms[i], &identifiers[i]));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * syms.size()));
+}
+BENCHMARK_TEMPLATE(symbol_table_insert_or_shadow, dryad::linear_probing)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000 * 1000);
+BENCHMARK_TEMPLATE(symbol_table_insert_or_shadow, dryad::group_probing)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000 * 1000);
+
+template <typename Probing>
+void symbol_table_lookup(benchmark::State& state)
+{
+    auto     identifiers = bench::make_identifiers(std::size_t(state.range(0)));
+    interner symbols;
+    auto     syms = intern_all(symbols, identifiers);
+
+    probing_table<Probing> t;
+    for (auto i = std::size_t(0); i != syms.size(); ++i)
+        t.insert_or_shadow(syms[i], &identifiers[i]);
+
+    for (auto _ : state)
+    {
+        for (auto sym : syms)
+            benchmark::DoNotOptimize(t.lookup(sym));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * syms.size()));
+}
+BENCHMARK_TEMPLATE(symbol_table_lookup, dryad::linear_probing)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000 * 1000);
+BENCHMARK_TEMPLATE(symbol_table_lookup, dryad::group_probing)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000 * 1000);
+
+// Lookup of symbols that are not in the table, e.g. names from an outer scope.
+template <typename Probing>
+void symbol_table_lookup_miss(benchmark::State& state)
+{
+    auto     identifiers = bench::make_identifiers(2 * std::size_t(state.range(0)));
+    interner symbols;
+    auto     syms = intern_all(symbols, identifiers);
+
+    probing_table<Probing> t;
+    for (auto i = std::size_t(0); i != syms.size() / 2; ++i)
+        t.insert_or_shadow(syms[i], &identifiers[i]);
+
+    for (auto _ : state)
+    {
+        for (auto i = syms.size() / 2; i != syms.size(); ++i)
+            benchmark::DoNotOptimize(t.lookup(syms[i]));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * (syms.size() / 2)));
+}
+BENCHMARK_TEMPLATE(symbol_table_lookup_miss, dryad::linear_probing)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000 * 1000);
+BENCHMARK_TEMPLATE(symbol_table_lookup_miss, dryad::group_probing)
+    ->RangeMultiplier(10)
+    ->Range(10, 1000 * 1000);
+
+// One table per block scope: most of them only declare a handful of names.
+void symbol_table_per_scope(benchmark::State& state)
+{
+    auto     identifiers = bench::make_identifiers(1000);
+    interner symbols;
+    auto     syms = intern_all(symbols, identifiers);
+
+    auto names = std::size_t(state.range(0));
+    for (auto _ : state)
+    {
+        for (auto scope = std::size_t(0); scope + names <= syms.size(); scope += names)
+        {
+            table t;
+            for (auto i = scope; i != scope + names; ++i)
+                t.insert_or_shadow(syms[i], &identifiers[i]);
+            for (auto i = scope; i != scope + names; ++i)
+                benchmark::DoNotOptimize(t.lookup(syms[i]));
+        }
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * (syms.size() / names)));
+}
+BENCHMARK(symbol_table_per_scope)->DenseRange(1, 9, 4);
+
+// Simulates name resolution of nested blocks: every scope declares a couple of names, shadowing
+// some of the outer names, and looks up names before it is popped again.
+void scoped_symbol_table_scopes(benchmark::State& state)
+{
+    auto     identifiers = bench::make_identifiers(1000);
+    interner symbols;
+    auto     syms = intern_all(symbols, identifiers);
+
+    auto depth = std::size_t(state.range(0));
+    dryad::scoped_symbol_table<symbol, const std::string*> t;
+    for (auto _ : state)
+    {
+        for (auto scope = std::size_t(0); scope != depth; ++scope)
+        {
+            t.push_scope();
+            for (auto i = scope * 8; i != scope * 8 + 16; ++i)
+                t.insert_or_shadow(syms[i % syms.size()], &identifiers[i % syms.size()]);
+            for (auto i = std::size_t(0); i != 16; ++i)
+                benchmark::DoNotOptimize(t.lookup(syms[(scope * 8 + i * 5) % syms.size()]));
+        }
+        for (auto scope = std::size_t(0); scope != depth; ++scope)
+            t.pop_scope();
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * depth));
+}
+BENCHMARK(scoped_symbol_table_scopes)->RangeMultiplier(4)->Range(1, 64);
+} // namespace
+
@@ -0,0 +1,506 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/kind_index.hpp>
+#include <dryad/parent_index.hpp>
+#include <dryad/snapshot.hpp>
+#include <dryad/tree.hpp>
+#include <dryad/tree_builder.hpp>
+
+#include "ast.hpp"
+#include <benchmark/benchmark.h>
+#include <cstring>
+#include <utility>
+#include <vector>
+
+namespace
+{
+constexpr auto min_nodes = 1000;
+constexpr auto max_nodes = 10 * 1000 * 1000;
+
+void tree_build(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        bench::tree tree;
+        bench::build_ast(tree, std::size_t(state.range(0)));
+        benchmark::DoNotOptimize(tree.root());
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * state.range(0)));
+}
+BENCHMARK(tree_build)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+// Simulates a recursive descent parser, which creates the nodes in post-order.
+// The shape only depends on the random numbers, so both versions build the same tree.
+bench::node* parse_list(bench::tree& tree, std::mt19937& rng, std::size_t& budget,
+                        unsigned depth = 0)
+{
+    --budget;
+    if (budget == 0 || depth == 16 || rng() % 2 == 0)
+        return tree.create<bench::literal>(budget);
+
+    dryad::unlinked_node_list<bench::node> children;
+    for (auto n = rng() % 8 + 1; n > 0 && budget > 0; --n)
+        children.push_back(parse_list(tree, rng, budget, depth + 1));
+
+    auto result = tree.create<bench::call>();
+    result->set_children(children);
+    return result;
+}
+void parse_builder(dryad::tree_builder<bench::block>& builder, std::mt19937& rng,
+                   std::size_t& budget, unsigned depth = 0)
+{
+    --budget;
+    if (budget == 0 || depth == 16 || rng() % 2 == 0)
+    {
+        builder.create<bench::literal>(budget);
+        return;
+    }
+
+    auto marker = builder.start();
+    for (auto n = rng() % 8 + 1; n > 0 && budget > 0; --n)
+        parse_builder(builder, rng, budget, depth + 1);
+    builder.finish<bench::call>(marker);
+}
+
+void tree_build_post_order(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        bench::tree  tree;
+        std::mt19937 rng(42);
+
+        dryad::unlinked_node_list<bench::node> children;
+        for (auto budget = std::size_t(state.range(0)); budget > 0;)
+            children.push_back(parse_list(tree, rng, budget));
+
+        auto root = tree.create<bench::block>();
+        root->set_children(children);
+        tree.set_root(root);
+        benchmark::DoNotOptimize(tree.root());
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * state.range(0)));
+}
+BENCHMARK(tree_build_post_order)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+template <bool Reserve>
+void tree_build_post_order_builder(benchmark::State& state)
+{
+    for (auto _ : state)
+    {
+        bench::tree  tree;
+        std::mt19937 rng(42);
+
+        dryad::tree_builder<bench::block> builder(tree);
+        if constexpr (Reserve)
+            builder.reserve(std::size_t(state.range(0)), sizeof(bench::literal));
+
+        auto marker = builder.start();
+        for (auto budget = std::size_t(state.range(0)); budget > 0;)
+            parse_builder(builder, rng, budget);
+        builder.finish<bench::block>(marker);
+        builder.set_root();
+        benchmark::DoNotOptimize(tree.root());
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * state.range(0)));
+}
+BENCHMARK_TEMPLATE(tree_build_post_order_builder, false)
+    ->RangeMultiplier(10)
+    ->Range(min_nodes, max_nodes);
+BENCHMARK_TEMPLATE(tree_build_post_order_builder, true)
+    ->RangeMultiplier(10)
+    ->Range(min_nodes, max_nodes);
+
+// An edit that changes a single top-level node: the new version re-uses all other subtrees.
+void tree_reparse_reuse(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    std::vector<bench::node*> children;
+    for (auto _ : state)
+    {
+        bench::tree next;
+        auto        old_root = next.absorb(std::move(tree));
+
+        children.clear();
+        for (auto child : old_root->children())
+            children.push_back(child);
+
+        dryad::tree_builder<bench::block> builder(next);
+        auto                              marker = builder.start();
+        builder.create<bench::literal>(std::uint64_t(0));
+        for (auto i = std::size_t(1); i < children.size(); ++i)
+            builder.reuse(children[i]);
+        builder.finish<bench::block>(marker);
+        builder.set_root();
+
+        tree = std::move(next);
+        benchmark::DoNotOptimize(tree.root());
+    }
+}
+BENCHMARK(tree_reparse_reuse)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+void tree_traverse(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto count = std::size_t(0);
+        for (auto [ev, n] : dryad::traverse(tree))
+        {
+            benchmark::DoNotOptimize(n);
+            ++count;
+        }
+        benchmark::DoNotOptimize(count);
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_traverse)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+// build_ast() creates the nodes bottom-up, compact() stores them in traversal order.
+void tree_traverse_compacted(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+    tree.compact<bench::literal, bench::identifier, bench::call, bench::block>();
+
+    for (auto _ : state)
+    {
+        auto count = std::size_t(0);
+        for (auto [ev, n] : dryad::traverse(tree))
+        {
+            benchmark::DoNotOptimize(n);
+            ++count;
+        }
+        benchmark::DoNotOptimize(count);
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_traverse_compacted)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+void tree_traverse_scattered(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)), 8, true);
+
+    for (auto _ : state)
+    {
+        auto count = std::size_t(0);
+        for (auto [ev, n] : dryad::traverse(tree))
+        {
+            benchmark::DoNotOptimize(n);
+            ++count;
+        }
+        benchmark::DoNotOptimize(count);
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_traverse_scattered)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+void tree_compact(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        tree.compact<bench::literal, bench::identifier, bench::call, bench::block>();
+        benchmark::DoNotOptimize(tree.root());
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_compact)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+void tree_clone(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto copy = tree.clone<bench::literal, bench::identifier, bench::call, bench::block>();
+        benchmark::DoNotOptimize(copy.root());
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_clone)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+// The lower bound for tree_clone: copying the memory of the nodes.
+void tree_clone_memcpy(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    std::vector<unsigned char> source(tree.memory_statistics().bytes_used);
+    for (auto _ : state)
+    {
+        std::vector<unsigned char> copy(source.size());
+        std::memcpy(copy.data(), source.data(), source.size());
+        benchmark::DoNotOptimize(copy.data());
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_clone_memcpy)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+// Compare with tree_build: the time it takes to get the tree back from a cache.
+void tree_load_snapshot(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    auto size = dryad::snapshot_size<bench::literal, bench::identifier, bench::call, bench::block>(
+        tree);
+    std::vector<std::max_align_t> image(size / sizeof(std::max_align_t) + 1);
+    dryad::write_snapshot<bench::literal, bench::identifier, bench::call, bench::block>(
+        tree, image.data(), size);
+
+    for (auto _ : state)
+    {
+        bench::tree loaded;
+        dryad::load_snapshot<bench::literal, bench::identifier, bench::call, bench::block>(
+            loaded, image.data(), size);
+        benchmark::DoNotOptimize(loaded.root());
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_load_snapshot)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+void tree_visit_tree(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        auto sum = std::uint64_t(0);
+        dryad::visit_tree(
+            tree, [&](const bench::literal* n) { sum += n->value; },
+            [&](const bench::identifier*) { ++sum; },
+            [&](dryad::traverse_event_enter, const bench::call*) { sum += 2; },
+            [&](dryad::traverse_event_exit, const bench::block*) { sum += 3; });
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_visit_tree)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+void tree_visit_tree_scattered(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)), 8, true);
+
+    for (auto _ : state)
+    {
+        auto sum = std::uint64_t(0);
+        dryad::visit_tree(
+            tree, [&](const bench::literal* n) { sum += n->value; },
+            [&](const bench::identifier*) { ++sum; },
+            [&](dryad::traverse_event_enter, const bench::call*) { sum += 2; },
+            [&](dryad::traverse_event_exit, const bench::block*) { sum += 3; });
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_visit_tree_scattered)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+void tree_parent(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)), unsigned(state.range(1)));
+
+    for (auto _ : state)
+    {
+        for (auto [ev, n] : dryad::traverse(tree))
+            if (ev != dryad::traverse_event::exit)
+                benchmark::DoNotOptimize(n->parent());
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_parent)->ArgsProduct({{min_nodes, 100 * 1000}, {8, 1024}});
+
+void tree_parent_index(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)), unsigned(state.range(1)));
+    dryad::parent_index<bench::node_kind> index(tree);
+
+    for (auto _ : state)
+    {
+        for (auto [ev, n] : dryad::traverse(tree))
+            if (ev != dryad::traverse_event::exit)
+                benchmark::DoNotOptimize(index.parent(n));
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_parent_index)->ArgsProduct({{min_nodes, 100 * 1000}, {8, 1024}});
+
+void tree_parent_index_build(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        dryad::parent_index<bench::node_kind> index(tree);
+        benchmark::DoNotOptimize(index.size());
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_parent_index_build)->RangeMultiplier(10)->Range(min_nodes, 1000 * 1000);
+
+// A pass that is only interested in calls, compare with tree_nodes_of_kind.
+void tree_traverse_kind(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    for (auto _ : state)
+    {
+        for (auto [ev, n] : dryad::traverse(tree))
+            if (auto call = dryad::node_try_cast<bench::call>(n);
+                call != nullptr && ev == dryad::traverse_event::enter)
+                benchmark::DoNotOptimize(call);
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_traverse_kind)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+void tree_nodes_of_kind(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+    dryad::kind_index<bench::node_kind> index(tree);
+
+    for (auto _ : state)
+    {
+        for (auto call : dryad::nodes_of_kind<bench::call>(index))
+            benchmark::DoNotOptimize(call);
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_nodes_of_kind)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+void tree_kind_index_build(benchmark::State& state)
+{
+    bench::tree tree;
+    bench::build_ast(tree, std::size_t(state.range(0)));
+
+    dryad::kind_index<bench::node_kind> index;
+    for (auto _ : state)
+    {
+        index.rebuild(tree);
+        benchmark::DoNotOptimize(index.size());
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * bench::count_nodes(tree)));
+}
+BENCHMARK(tree_kind_index_build)->RangeMultiplier(10)->Range(min_nodes, max_nodes);
+
+// A tree with lots of different leaf kinds, to measure the dispatch of visitors with many lambdas.
+namespace wide
+{
+enum class node_kind : std::uint16_t
+{
+};
+
+using node = dryad::node<node_kind>;
+
+template <std::uint16_t Kind>
+struct leaf : dryad::basic_node<node_kind(Kind)>
+{
+    explicit leaf(dryad::node_ctor ctor) : dryad::basic_node<node_kind(Kind)>(ctor) {}
+};
+
+struct list : dryad::basic_node<node_kind(0x7FFF), dryad::container_node<node>>
+{
+    DRYAD_NODE_CTOR(list);
+
+    void set_children(dryad::unlinked_node_list<node> children)
+    {
+        insert_child_list_after(nullptr, children);
+    }
+};
+
+using tree = dryad::tree<list>;
+
+template <std::uint16_t... Kinds>
+void build(tree& result, std::size_t node_count)
+{
+    using create_fn                  = node* (*)(tree&);
+    static constexpr create_fn fns[] = {[](tree& t) -> node* { return t.create<leaf<Kinds>>(); }...};
+
+    std::mt19937                            rng(42);
+    std::uniform_int_distribution<unsigned> kind(0, sizeof...(Kinds) - 1);
+
+    dryad::unlinked_node_list<node> children;
+    for (auto i = std::size_t(0); i != node_count; ++i)
+        children.push_back(fns[kind(rng)](result));
+
+    auto root = result.create<list>();
+    root->set_children(children);
+    result.set_root(root);
+}
+} // namespace wide
+
+template <std::uint16_t... Kinds>
+void tree_visit_tree_wide(benchmark::State& state, std::integer_sequence<std::uint16_t, Kinds...>)
+{
+    wide::tree tree;
+    wide::build<Kinds...>(tree, 100 * 1000);
+
+    for (auto _ : state)
+    {
+        auto sum = std::uint64_t(0);
+        dryad::visit_tree(tree, [&](const wide::leaf<Kinds>*) { sum += Kinds; }...);
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * 100 * 1000));
+}
+BENCHMARK_CAPTURE(tree_visit_tree_wide, 4, std::make_integer_sequence<std::uint16_t, 4>{});
+BENCHMARK_CAPTURE(tree_visit_tree_wide, 8, std::make_integer_sequence<std::uint16_t, 8>{});
+BENCHMARK_CAPTURE(tree_visit_tree_wide, 16, std::make_integer_sequence<std::uint16_t, 16>{});
+BENCHMARK_CAPTURE(tree_visit_tree_wide, 64, std::make_integer_sequence<std::uint16_t, 64>{});
+
+template <std::uint16_t... Kinds>
+void tree_visit_node_wide(benchmark::State& state, std::integer_sequence<std::uint16_t, Kinds...>)
+{
+    wide::tree tree;
+    wide::build<Kinds...>(tree, 100 * 1000);
+
+    for (auto _ : state)
+    {
+        auto sum = std::uint64_t(0);
+        for (auto child : tree.root()->children())
+            dryad::visit_node(child, [&](const wide::leaf<Kinds>*) { sum += Kinds; }...);
+        benchmark::DoNotOptimize(sum);
+    }
+
+    state.SetItemsProcessed(std::int64_t(state.iterations() * 100 * 1000));
+}
+BENCHMARK_CAPTURE(tree_visit_node_wide, 4, std::make_integer_sequence<std::uint16_t, 4>{});
+BENCHMARK_CAPTURE(tree_visit_node_wide, 8, std::make_integer_sequence<std::uint16_t, 8>{});
+BENCHMARK_CAPTURE(tree_visit_node_wide, 16, std::make_integer_sequence<std::uint16_t, 16>{});
+BENCHMARK_CAPTURE(tree_visit_node_wide, 64, std::make_integer_sequence<std::uint16_t, 64>{});
+} // namespace
+
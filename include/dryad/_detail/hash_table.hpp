@@ -5,6 +5,7 @@
 #define DRYAD_DETAIL_HASH_TABLE_HPP_INCLUDED
 
 #include <climits>
+#include <cstring>
 #include <dryad/_detail/assert.hpp>
 #include <dryad/_detail/config.hpp>
 #include <dryad/_detail/iterator.hpp>
@@ -16,7 +17,6 @@ struct Traits
     using value_type = T;
 
     static bool is_unoccupied(const T&);
-    static void fill_removed(T* data, size_t size);
     static void fill_unoccupied(T* data, size_t size);
 
     bool is_equal(const T& entry, const T& value) const;
@@ -29,18 +29,97 @@ struct Traits
 };
 #endif
 
+#ifndef DRYAD_HASH_TABLE_STATISTICS
+/// Whether hash tables count lookups and rehashes for `hash_table_statistics`.
+#    define DRYAD_HASH_TABLE_STATISTICS 0
+#endif
+
+#if defined(__SSE2__)
+#    include <emmintrin.h>
+#elif defined(__ARM_NEON)
+#    include <arm_neon.h>
+#endif
+
+namespace dryad
+{
+/// How well the hash table of a container performs.
+struct hash_table_statistics
+{
+    /// The number of entries.
+    std::size_t size;
+    /// The number of slots.
+    std::size_t capacity;
+    /// The number of slots that are occupied by markers of removed entries.
+    std::size_t removed;
+    /// The sum and maximum of the probe lengths of all entries, i.e. the number of slots (linear
+    /// probing) or groups (group probing) a lookup inspects to find them.
+    std::size_t total_probe_length;
+    std::size_t max_probe_length;
+
+    /// The number of times the table grew, only if `DRYAD_HASH_TABLE_STATISTICS` is enabled.
+    std::size_t rehash_count;
+    /// The number of lookups and the number of slots (or groups) they inspected, including
+    /// lookups that didn't find an entry, only if `DRYAD_HASH_TABLE_STATISTICS` is enabled.
+    std::size_t lookup_count;
+    std::size_t lookup_probe_length;
+
+    double average_probe_length() const
+    {
+        return size == 0 ? 0.0 : double(total_probe_length) / double(size);
+    }
+    double average_lookup_probe_length() const
+    {
+        return lookup_count == 0 ? 0.0 : double(lookup_probe_length) / double(lookup_count);
+    }
+};
+} // namespace dryad
+
 namespace dryad::_detail
 {
+template <bool Enabled>
+struct hash_table_counter
+{
+    void lookup(std::size_t) noexcept {}
+    void rehash() noexcept {}
+
+    void fill(hash_table_statistics&) const noexcept {}
+};
+template <>
+struct hash_table_counter<true>
+{
+    std::size_t rehash_count        = 0;
+    std::size_t lookup_count        = 0;
+    std::size_t lookup_probe_length = 0;
+
+    void lookup(std::size_t probe_length) noexcept
+    {
+        ++lookup_count;
+        lookup_probe_length += probe_length;
+    }
+    void rehash() noexcept
+    {
+        ++rehash_count;
+    }
+
+    void fill(hash_table_statistics& stats) const noexcept
+    {
+        stats.rehash_count        = rehash_count;
+        stats.lookup_count        = lookup_count;
+        stats.lookup_probe_length = lookup_probe_length;
+    }
+};
+
 /// A simple hash table for trivial keys with linear probing.
 /// It is non-owning as it does not store the used memory resource.
 template <typename Traits, std::size_t MinTableSize>
-class hash_table
+class linear_hash_table
 {
 public:
     using value_type = typename Traits::value_type;
     static_assert(std::is_trivial_v<value_type>);
 
-    constexpr hash_table() : _table(nullptr), _table_capacity(0), _table_size(0) {}
+    constexpr linear_hash_table() : _table(nullptr), _table_capacity(0), _table_size(0), _counter()
+    {}
 
     template <typename ResourcePtr>
     void free(ResourcePtr resource)
@@ -56,7 +135,7 @@ public:
 
     struct entry_handle
     {
-        hash_table* _self;
+        linear_hash_table* _self;
         value_type* _entry;
         bool        _valid;
 
@@ -84,15 +163,73 @@ public:
             _valid = true;
         }
 
-        void remove()
+        // Same as erase(), but for tables that don't store data next to the entries.
+        void remove(Traits traits = {})
+        {
+            erase([](std::size_t, std::size_t) {}, traits);
+        }
+
+        // Removes the entry without leaving a removed marker behind: the following entries of the
+        // cluster are shifted backwards instead, so probe sequences stay as short as in a table
+        // that never had the entry.
+        // Calls `entry_moved(old_idx, new_idx)` for every entry that is moved.
+        template <typename Callback>
+        void erase(Callback entry_moved, Traits traits = {})
         {
             DRYAD_PRECONDITION(*this);
-            Traits::fill_removed(_entry, 1);
+            auto mask = _self->_table_capacity - 1;
+            auto hole = index();
+            for (auto cur = (hole + 1) & mask;; cur = (cur + 1) & mask)
+            {
+                auto& entry = _self->_table[cur];
+                if (Traits::is_unoccupied(entry))
+                    break;
+
+                // We can only move the entry into the hole if it doesn't move before its home.
+                auto home = traits.hash(entry) & mask;
+                if (((cur - home) & mask) >= ((cur - hole) & mask))
+                {
+                    _self->_table[hole] = entry;
+                    entry_moved(cur, hole);
+                    hole = cur;
+                }
+            }
+
+            Traits::fill_unoccupied(_self->_table + hole, 1);
             --_self->_table_size;
             _valid = false;
         }
     };
 
+    // Erases every entry for which `pred(entry)` returns true, visiting each entry exactly once.
+    // Calls `entry_moved(old_idx, new_idx)` for every entry that is moved, like `erase()`.
+    template <typename Predicate, typename Callback>
+    void erase_if(Predicate pred, Callback entry_moved, Traits traits = {})
+    {
+        if (_table_size == 0)
+            return;
+
+        // Start after an unoccupied slot: entries are only shifted backwards within their cluster,
+        // so an entry that has already been visited is never moved ahead of the current one.
+        auto mask  = _table_capacity - 1;
+        auto start = std::size_t(0);
+        while (!Traits::is_unoccupied(_table[start]))
+            ++start;
+
+        for (auto offset = std::size_t(1); offset != _table_capacity; ++offset)
+        {
+            auto idx = (start + offset) & mask;
+            // Erasing may shift the next entry of the cluster into the slot, so check it again.
+            while (!Traits::is_unoccupied(_table[idx]))
+            {
+                entry_handle entry{this, _table + idx, true};
+                if (!pred(entry))
+                    break;
+                entry.erase(entry_moved, traits);
+            }
+        }
+    }
+
     // Looks for an entry in the table, creating one if necessary.
     //
     // If it is already in the table, returns a pointer to its valid entry.
@@ -107,17 +244,23 @@ public:
         auto hash      = traits.hash(key);
         auto table_idx = hash & (_table_capacity - 1);
 
-        while (true)
+        for (auto probe_length = std::size_t(1);; ++probe_length)
         {
             auto entry = _table + table_idx;
             if (Traits::is_unoccupied(*entry))
+            {
                 // We found an empty entry, return it.
+                _counter.lookup(probe_length);
                 return {this, entry, false};
+            }
 
             // Check whether the entry is the same string.
             if (traits.is_equal(*entry, key))
+            {
                 // It is already in the table, return it.
+                _counter.lookup(probe_length);
                 return {this, entry, true};
+            }
 
             // Go to next entry.
             table_idx = (table_idx + 1) & (_table_capacity - 1);
@@ -129,7 +272,7 @@ public:
         if (_table_size == 0)
             return nullptr;
 
-        auto entry = const_cast<hash_table*>(this)->lookup_entry(key, traits);
+        auto entry = const_cast<linear_hash_table*>(this)->lookup_entry(key, traits);
         return entry ? &entry.get() : nullptr;
     }
 
@@ -137,6 +280,11 @@ public:
     {
         return _table_size >= _table_capacity / 2;
     }
+    // The capacity to rehash to if `should_rehash()`.
+    std::size_t next_capacity() const
+    {
+        return to_table_capacity(2 * _table_capacity);
+    }
 
     static constexpr std::size_t to_table_capacity(unsigned long long cap)
     {
@@ -165,7 +313,8 @@ public:
         _table_capacity = new_capacity;
         Traits::fill_unoccupied(_table, _table_capacity);
 
-        // Insert existing values into the new table.
+        // Insert existing values into the new table; that doesn't count as lookups.
+        auto counter = _counter;
         if (_table_size > 0)
         {
             _table_size = 0;
@@ -178,6 +327,8 @@ public:
                     entry_cb(new_entry, std::size_t(entry - old_table));
                 }
         }
+        _counter = counter;
+        _counter.rehash();
 
         if (old_capacity > 0)
             resource->deallocate(old_table, old_capacity * sizeof(value_type), alignof(value_type));
@@ -187,7 +338,7 @@ public:
         ResourcePtr resource, Traits traits = {},
         Callback entry_cb = +[](entry_handle, std::size_t) {})
     {
-        rehash(resource, to_table_capacity(2 * _table_capacity), traits, entry_cb);
+        rehash(resource, next_capacity(), traits, entry_cb);
     }
 
     //=== access ===//
@@ -199,16 +350,49 @@ public:
     {
         return _table_capacity;
     }
+    /// The number of slots occupied by removed markers, which are never left behind.
+    std::size_t removed() const
+    {
+        return 0;
+    }
+    /// The number of bytes allocated from the memory resource.
+    std::size_t allocated_bytes() const
+    {
+        return _table_capacity * sizeof(value_type);
+    }
+
+    /// Computes the statistics of the table by hashing every entry.
+    hash_table_statistics statistics(Traits traits = {}) const
+    {
+        hash_table_statistics result{};
+        result.size     = _table_size;
+        result.capacity = _table_capacity;
+        _counter.fill(result);
+
+        auto mask = _table_capacity - 1;
+        for (auto idx = std::size_t(0); idx != _table_capacity; ++idx)
+        {
+            auto& entry = _table[idx];
+            if (Traits::is_unoccupied(entry))
+                continue;
+
+            auto probe_length = ((idx - traits.hash(entry)) & mask) + 1;
+            result.total_probe_length += probe_length;
+            if (probe_length > result.max_probe_length)
+                result.max_probe_length = probe_length;
+        }
+        return result;
+    }
 
     struct entry_range
     {
         struct iterator : _detail::forward_iterator_base<iterator, entry_handle, entry_handle, void>
         {
-            hash_table* _self;
+            linear_hash_table* _self;
             value_type* _cur;
 
             iterator() : _self(nullptr), _cur(nullptr) {}
-            explicit iterator(hash_table& self, value_type* cur) : _self(&self), _cur(cur) {}
+            explicit iterator(linear_hash_table& self, value_type* cur) : _self(&self), _cur(cur) {}
 
             entry_handle deref() const
             {
@@ -246,7 +430,7 @@ public:
             return iterator(*_self, _self->_table + _self->_table_capacity);
         }
 
-        hash_table* _self;
+        linear_hash_table* _self;
     };
 
     /// Iterates over all occupied entries.
@@ -255,11 +439,632 @@ public:
         return {this};
     }
 
+    //=== raw memory ===//
+    static constexpr std::size_t allocation_size(std::size_t capacity)
+    {
+        return capacity * sizeof(value_type);
+    }
+
+    /// The memory of the table, which consists of `allocated_bytes()` bytes.
+    /// As the values are trivial, a copy of it can be used to restore the table later on.
+    const void* data() const
+    {
+        return _table;
+    }
+
+    /// Replaces the table by a copy of the memory of a table with the specified capacity and size.
+    template <typename ResourcePtr>
+    void assign(ResourcePtr resource, std::size_t capacity, std::size_t size, const void* data)
+    {
+        DRYAD_PRECONDITION(capacity == 0 || capacity == to_table_capacity(capacity));
+        DRYAD_PRECONDITION(size < capacity || size == 0);
+        free(resource);
+        if (capacity == 0)
+            return;
+
+        auto memory = resource->allocate(allocation_size(capacity), alignof(value_type));
+        std::memcpy(memory, data, allocation_size(capacity));
+        adopt(capacity, size, memory);
+    }
+
+    /// Same as `assign()`, but uses the memory directly without copying it.
+    /// The table must be empty; afterwards, it must not be modified, rehashed, or freed.
+    void adopt(std::size_t capacity, std::size_t size, const void* data)
+    {
+        DRYAD_PRECONDITION(_table_capacity == 0);
+        if (capacity == 0)
+            return;
+
+        _table          = static_cast<value_type*>(const_cast<void*>(data));
+        _table_capacity = capacity;
+        _table_size     = size;
+    }
+
 private:
     value_type* _table;
     std::size_t _table_capacity; // power of two
     std::size_t _table_size;
+
+    DRYAD_EMPTY_MEMBER hash_table_counter<DRYAD_HASH_TABLE_STATISTICS> _counter;
+};
+} // namespace dryad::_detail
+
+namespace dryad::_detail
+{
+// Control bytes of the group hash table:
+// * empty: 0b1000'0000
+// * removed: 0b1111'1110
+// * occupied: 0b0xxx'xxxx, where x are 7 bits of the hash
+constexpr unsigned char group_ctrl_empty   = 0x80;
+constexpr unsigned char group_ctrl_removed = 0xFE;
+
+constexpr bool is_group_ctrl_occupied(unsigned char ctrl)
+{
+    return (ctrl & 0x80) == 0;
+}
+
+// Set of slots in a group that match some condition.
+class group_mask
+{
+public:
+    constexpr explicit group_mask(std::uint64_t bits) : _bits(bits) {}
+
+    explicit operator bool() const
+    {
+        return _bits != 0;
+    }
+
+    // Returns the index of the first slot in the mask and removes it.
+    std::size_t pop()
+    {
+        auto idx = std::size_t(__builtin_ctzll(_bits)) >> shift;
+        _bits &= _bits - 1;
+        return idx;
+    }
+
+#if defined(__ARM_NEON) && !defined(__SSE2__)
+    // We have four bits per slot, of which only the highest one is set.
+    static constexpr auto shift = 2;
+#else
+    // We have one bit per slot.
+    static constexpr auto shift = 0;
+#endif
+
+private:
+    std::uint64_t _bits;
+};
+
+// A group of 16 control bytes that can be matched at once.
+class group
+{
+public:
+    static constexpr std::size_t width = 16;
+
+    explicit group(const unsigned char* ctrl)
+    {
+#if defined(__SSE2__)
+        _ctrl = _mm_loadu_si128(reinterpret_cast<const __m128i*>(ctrl));
+#elif defined(__ARM_NEON)
+        _ctrl = vld1q_u8(ctrl);
+#else
+        std::memcpy(_ctrl, ctrl, width);
+#endif
+    }
+
+    // The slots whose control byte is the specified value.
+    group_mask match(unsigned char value) const
+    {
+#if defined(__SSE2__)
+        auto cmp = _mm_cmpeq_epi8(_ctrl, _mm_set1_epi8(static_cast<char>(value)));
+        return group_mask(std::uint32_t(_mm_movemask_epi8(cmp)));
+#elif defined(__ARM_NEON)
+        return neon_mask(vceqq_u8(_ctrl, vdupq_n_u8(value)));
+#else
+        std::uint64_t bits = 0;
+        for (auto i = 0u; i != width; ++i)
+            if (_ctrl[i] == value)
+                bits |= std::uint64_t(1) << i;
+        return group_mask(bits);
+#endif
+    }
+
+    // The slots that are either empty or removed.
+    group_mask match_unoccupied() const
+    {
+#if defined(__SSE2__)
+        return group_mask(std::uint32_t(_mm_movemask_epi8(_ctrl)));
+#elif defined(__ARM_NEON)
+        return neon_mask(vcltq_s8(vreinterpretq_s8_u8(_ctrl), vdupq_n_s8(0)));
+#else
+        std::uint64_t bits = 0;
+        for (auto i = 0u; i != width; ++i)
+            if (!is_group_ctrl_occupied(_ctrl[i]))
+                bits |= std::uint64_t(1) << i;
+        return group_mask(bits);
+#endif
+    }
+
+    // The slots that are empty.
+    group_mask match_empty() const
+    {
+        return match(group_ctrl_empty);
+    }
+
+private:
+#if defined(__SSE2__)
+    __m128i _ctrl;
+#elif defined(__ARM_NEON)
+    static group_mask neon_mask(uint8x16_t cmp)
+    {
+        // Narrow each byte to four bits, and keep only the highest one.
+        auto narrowed = vshrn_n_u16(vreinterpretq_u16_u8(cmp), 4);
+        auto bits     = vget_lane_u64(vreinterpret_u64_u8(narrowed), 0);
+        return group_mask(bits & 0x8888'8888'8888'8888ull);
+    }
+
+    uint8x16_t _ctrl;
+#else
+    unsigned char _ctrl[width];
+#endif
+};
+
+/// A hash table for trivial keys that probes groups of 16 slots at once.
+/// It is non-owning as it does not store the used memory resource.
+///
+/// In addition to the slots, it stores a control byte for each slot, which contains 7 bits of the
+/// hash for occupied slots; `Traits::is_equal` is only called if they match.
+/// It has the same interface as `linear_hash_table`, but does not use `Traits::is_unoccupied` or
+/// `Traits::fill_unoccupied`.
+template <typename Traits, std::size_t MinTableSize>
+class group_hash_table
+{
+    static_assert(MinTableSize >= 16);
+
+    static unsigned char tag_of(std::size_t hash)
+    {
+        // Fibonacci hashing to get good high bits even for weak hashes.
+        auto mixed = std::uint64_t(hash) * 0x9E37'79B9'7F4A'7C15ull;
+        return static_cast<unsigned char>(mixed >> 57);
+    }
+
+public:
+    using value_type = typename Traits::value_type;
+    static_assert(std::is_trivial_v<value_type>);
+
+    constexpr group_hash_table()
+    : _table(nullptr), _ctrl(nullptr), _table_capacity(0), _table_size(0), _table_removed(0),
+      _counter()
+    {}
+
+    template <typename ResourcePtr>
+    void free(ResourcePtr resource)
+    {
+        if (_table_capacity == 0)
+            return;
+
+        resource->deallocate(_table, allocation_size(_table_capacity), alignof(value_type));
+        _table          = nullptr;
+        _ctrl           = nullptr;
+        _table_size     = 0;
+        _table_removed  = 0;
+        _table_capacity = 0;
+    }
+
+    struct entry_handle
+    {
+        group_hash_table* _self;
+        value_type*       _entry;
+        bool              _valid;
+        unsigned char     _tag;
+
+        explicit operator bool() const
+        {
+            return _valid;
+        }
+
+        std::size_t index() const
+        {
+            return std::size_t(_entry - _self->_table);
+        }
+
+        value_type& get() const
+        {
+            DRYAD_PRECONDITION(*this);
+            return *_entry;
+        }
+
+        void create(const value_type& value)
+        {
+            DRYAD_PRECONDITION(!*this);
+            auto& ctrl = _self->_ctrl[index()];
+            if (ctrl == group_ctrl_removed)
+                --_self->_table_removed;
+
+            *_entry = value;
+            ctrl    = _tag;
+            ++_self->_table_size;
+            _valid = true;
+        }
+
+        void remove()
+        {
+            DRYAD_PRECONDITION(*this);
+            auto idx        = index();
+            auto group_base = idx & ~(group::width - 1);
+
+            // If the group already has an empty slot, no probe sequence continues past it,
+            // so we can mark the slot as empty instead of removed.
+            if (group(_self->_ctrl + group_base).match_empty())
+            {
+                _self->_ctrl[idx] = group_ctrl_empty;
+            }
+            else
+            {
+                _self->_ctrl[idx] = group_ctrl_removed;
+                ++_self->_table_removed;
+            }
+
+            --_self->_table_size;
+            _valid = false;
+        }
+
+        // Same as remove(), entries are never moved; the group probing already avoids removed
+        // markers where it can.
+        template <typename Callback>
+        void erase(Callback, Traits = {})
+        {
+            remove();
+        }
+    };
+
+    // Erases every entry for which `pred(entry)` returns true, visiting each entry exactly once.
+    // Entries are never moved.
+    template <typename Predicate, typename Callback>
+    void erase_if(Predicate pred, Callback, Traits = {})
+    {
+        for (auto idx = std::size_t(0); idx != _table_capacity; ++idx)
+            if (is_group_ctrl_occupied(_ctrl[idx]))
+            {
+                entry_handle entry{this, _table + idx, true, _ctrl[idx]};
+                if (pred(entry))
+                    entry.remove();
+            }
+    }
+
+    // Looks for an entry in the table, creating one if necessary.
+    //
+    // If it is already in the table, returns a pointer to its valid entry.
+    //
+    // Otherwise, locates a new entry for that value and returns a pointer to it which is currently
+    // invalid. Invariants of map are broken until the ptr has been written to.
+    template <typename Key>
+    entry_handle lookup_entry(const Key& key, Traits traits = {})
+    {
+        DRYAD_PRECONDITION(_table_size + _table_removed < _table_capacity);
+
+        auto hash        = traits.hash(key);
+        auto tag         = tag_of(hash);
+        auto group_count = _table_capacity / group::width;
+
+        auto group_idx = hash & (group_count - 1);
+        for (auto step = std::size_t(1);; ++step)
+        {
+            auto base = group_idx * group::width;
+            auto g    = group(_ctrl + base);
+
+            for (auto mask = g.match(tag); mask;)
+            {
+                auto entry = _table + base + mask.pop();
+                if (traits.is_equal(*entry, key))
+                {
+                    // It is already in the table, return it.
+                    _counter.lookup(step);
+                    return {this, entry, true, tag};
+                }
+            }
+
+            if (g.match_empty())
+            {
+                // An empty slot ends the probe sequence, so it's not in the table.
+                _counter.lookup(step);
+                break;
+            }
+
+            // Go to next group; triangular probing visits every group exactly once.
+            group_idx = (group_idx + step) & (group_count - 1);
+        }
+
+        // Find the first unoccupied slot in the probe sequence, which may be a removed one.
+        group_idx = hash & (group_count - 1);
+        for (auto step = std::size_t(1);; ++step)
+        {
+            auto base = group_idx * group::width;
+            if (auto mask = group(_ctrl + base).match_unoccupied())
+                return {this, _table + base + mask.pop(), false, tag};
+
+            group_idx = (group_idx + step) & (group_count - 1);
+        }
+    }
+    template <typename Key>
+    value_type* lookup(const Key& key, Traits traits = {}) const
+    {
+        if (_table_size == 0)
+            return nullptr;
+
+        auto entry = const_cast<group_hash_table*>(this)->lookup_entry(key, traits);
+        return entry ? &entry.get() : nullptr;
+    }
+
+    bool should_rehash() const
+    {
+        // Maximal load factor of 7/8; removed slots count as they don't end a probe sequence.
+        return _table_size + _table_removed >= _table_capacity - _table_capacity / 8;
+    }
+    // The capacity to rehash to if `should_rehash()`.
+    std::size_t next_capacity() const
+    {
+        // If most of the load are removed slots, a rehash at the same capacity drops them.
+        // Afterwards, at least half of the slots are available until the next rehash.
+        if (_table_capacity > 0 && _table_size <= _table_capacity / 8 * 3)
+            return _table_capacity;
+        else
+            return to_table_capacity(2 * _table_capacity);
+    }
+
+    static constexpr std::size_t to_table_capacity(unsigned long long cap)
+    {
+        if (cap < MinTableSize)
+            return MinTableSize;
+
+        // Round up to next power of two.
+        return std::size_t(1) << (int(sizeof(cap) * CHAR_BIT) - __builtin_clzll(cap - 1));
+    }
+
+    template <typename ResourcePtr, typename Callback = void (*)(entry_handle, std::size_t)>
+    void rehash(
+        ResourcePtr resource, std::size_t new_capacity, Traits traits = {},
+        Callback entry_cb = +[](entry_handle, std::size_t) {})
+    {
+        DRYAD_PRECONDITION(new_capacity == to_table_capacity(new_capacity));
+        // Rehashing at the same capacity only makes sense to drop removed slots.
+        if (new_capacity < _table_capacity
+            || (new_capacity == _table_capacity && _table_removed == 0))
+            return;
+
+        auto old_table    = _table;
+        auto old_ctrl     = _ctrl;
+        auto old_capacity = _table_capacity;
+
+        // Allocate a bigger, currently empty table.
+        _table = static_cast<value_type*>(
+            resource->allocate(allocation_size(new_capacity), alignof(value_type)));
+        _ctrl           = reinterpret_cast<unsigned char*>(_table + new_capacity);
+        _table_capacity = new_capacity;
+        _table_removed  = 0;
+        std::memset(_ctrl, group_ctrl_empty, new_capacity);
+
+        // Insert existing values into the new table; that doesn't count as lookups.
+        auto counter = _counter;
+        if (_table_size > 0)
+        {
+            _table_size = 0;
+
+            for (auto idx = std::size_t(0); idx != old_capacity; ++idx)
+                if (is_group_ctrl_occupied(old_ctrl[idx]))
+                {
+                    auto new_entry = lookup_entry(old_table[idx], traits);
+                    new_entry.create(old_table[idx]);
+                    entry_cb(new_entry, idx);
+                }
+        }
+        _counter = counter;
+        _counter.rehash();
+
+        if (old_capacity > 0)
+            resource->deallocate(old_table, allocation_size(old_capacity), alignof(value_type));
+    }
+    template <typename ResourcePtr, typename Callback = void (*)(entry_handle, std::size_t)>
+    void rehash(
+        ResourcePtr resource, Traits traits = {},
+        Callback entry_cb = +[](entry_handle, std::size_t) {})
+    {
+        rehash(resource, next_capacity(), traits, entry_cb);
+    }
+
+    //=== access ===//
+    std::size_t size() const
+    {
+        return _table_size;
+    }
+    std::size_t capacity() const
+    {
+        return _table_capacity;
+    }
+    /// The number of slots occupied by removed markers.
+    std::size_t removed() const
+    {
+        return _table_removed;
+    }
+    /// The number of bytes allocated from the memory resource.
+    std::size_t allocated_bytes() const
+    {
+        return allocation_size(_table_capacity);
+    }
+
+    /// Computes the statistics of the table by hashing every entry.
+    hash_table_statistics statistics(Traits traits = {}) const
+    {
+        hash_table_statistics result{};
+        result.size     = _table_size;
+        result.capacity = _table_capacity;
+        result.removed  = _table_removed;
+        _counter.fill(result);
+
+        auto group_count = _table_capacity / group::width;
+        for (auto idx = std::size_t(0); idx != _table_capacity; ++idx)
+        {
+            if (!is_group_ctrl_occupied(_ctrl[idx]))
+                continue;
+
+            // Follow the probe sequence from the home group until we reach the entry's group.
+            auto group_idx    = traits.hash(_table[idx]) & (group_count - 1);
+            auto probe_length = std::size_t(1);
+            while (group_idx != idx / group::width)
+            {
+                group_idx = (group_idx + probe_length) & (group_count - 1);
+                ++probe_length;
+            }
+
+            result.total_probe_length += probe_length;
+            if (probe_length > result.max_probe_length)
+                result.max_probe_length = probe_length;
+        }
+        return result;
+    }
+
+    struct entry_range
+    {
+        struct iterator : _detail::forward_iterator_base<iterator, entry_handle, entry_handle, void>
+        {
+            group_hash_table* _self;
+            std::size_t       _cur;
+
+            iterator() : _self(nullptr), _cur(0) {}
+            explicit iterator(group_hash_table& self, std::size_t cur) : _self(&self), _cur(cur) {}
+
+            entry_handle deref() const
+            {
+                return {_self, _self->_table + _cur, true, _self->_ctrl[_cur]};
+            }
+            void increment()
+            {
+                do
+                {
+                    ++_cur;
+                } while (_cur != _self->_table_capacity
+                         && !is_group_ctrl_occupied(_self->_ctrl[_cur]));
+            }
+            bool equal(iterator rhs) const
+            {
+                return _cur == rhs._cur;
+            }
+        };
+
+        iterator begin() const
+        {
+            if (_self->size() == 0)
+                return {};
+
+            auto cur = std::size_t(0);
+            while (!is_group_ctrl_occupied(_self->_ctrl[cur]))
+                cur++;
+            return iterator(*_self, cur);
+        }
+        iterator end() const
+        {
+            if (_self->size() == 0)
+                return {};
+
+            return iterator(*_self, _self->_table_capacity);
+        }
+
+        group_hash_table* _self;
+    };
+
+    /// Iterates over all occupied entries.
+    entry_range entries()
+    {
+        return {this};
+    }
+
+    //=== raw memory ===//
+    static constexpr std::size_t allocation_size(std::size_t capacity)
+    {
+        // The control bytes are stored after the slots.
+        return capacity * sizeof(value_type) + capacity;
+    }
+
+    /// The memory of the table, which consists of `allocated_bytes()` bytes.
+    /// As the values are trivial, a copy of it can be used to restore the table later on.
+    const void* data() const
+    {
+        return _table;
+    }
+
+    /// Replaces the table by a copy of the memory of a table with the specified capacity and size.
+    template <typename ResourcePtr>
+    void assign(ResourcePtr resource, std::size_t capacity, std::size_t size, const void* data)
+    {
+        DRYAD_PRECONDITION(capacity == 0 || capacity == to_table_capacity(capacity));
+        DRYAD_PRECONDITION(size < capacity || size == 0);
+        free(resource);
+        if (capacity == 0)
+            return;
+
+        auto memory = resource->allocate(allocation_size(capacity), alignof(value_type));
+        std::memcpy(memory, data, allocation_size(capacity));
+        adopt(capacity, size, memory);
+    }
+
+    /// Same as `assign()`, but uses the memory directly without copying it.
+    /// The table must be empty; afterwards, it must not be modified, rehashed, or freed.
+    void adopt(std::size_t capacity, std::size_t size, const void* data)
+    {
+        DRYAD_PRECONDITION(_table_capacity == 0);
+        if (capacity == 0)
+            return;
+
+        _table          = static_cast<value_type*>(const_cast<void*>(data));
+        _ctrl           = reinterpret_cast<unsigned char*>(_table + capacity);
+        _table_capacity = capacity;
+        _table_size     = size;
+
+        // The number of removed slots isn't part of the memory, so we need to count them.
+        for (auto idx = std::size_t(0); idx != capacity; ++idx)
+            if (_ctrl[idx] == group_ctrl_removed)
+                ++_table_removed;
+    }
+
+private:
+    value_type*    _table;
+    unsigned char* _ctrl;
+    std::size_t    _table_capacity; // power of two, multiple of group width
+    std::size_t    _table_size;
+    std::size_t    _table_removed;
+
+    DRYAD_EMPTY_MEMBER hash_table_counter<DRYAD_HASH_TABLE_STATISTICS> _counter;
+};
+} // namespace dryad::_detail
+
+namespace dryad
+{
+/// The hash table of a container probes one entry at a time, comparing each one.
+/// It is the default, as it is the fastest for cheap comparisons like pointers or integers.
+struct linear_probing
+{
+    static constexpr unsigned layout_id = 0;
+
+    template <typename Traits, std::size_t MinTableSize>
+    using _table = _detail::linear_hash_table<Traits, MinTableSize>;
+};
+
+/// The hash table of a container stores 7 bits of the hash of every entry separately and probes
+/// 16 of them at a time, so entries are only compared on a match.
+/// It is faster for expensive comparisons like strings or trees, and allows a higher load factor.
+struct group_probing
+{
+    static constexpr unsigned layout_id = 1;
+
+    template <typename Traits, std::size_t MinTableSize>
+    using _table = _detail::group_hash_table<Traits, MinTableSize>;
 };
+} // namespace dryad
+
+namespace dryad::_detail
+{
+/// The hash table of a container using the `Probing` strategy.
+template <typename Traits, std::size_t MinTableSize, typename Probing>
+using hash_table = typename Probing::template _table<Traits, MinTableSize>;
 } // namespace dryad::_detail
 
 #endif // DRYAD_DETAIL_HASH_TABLE_HPP_INCLUDED
@@ -4,6 +4,7 @@
 #ifndef DRYAD_DETAIL_MEMORY_RESOURCE_HPP_INCLUDED
 #define DRYAD_DETAIL_MEMORY_RESOURCE_HPP_INCLUDED
 
+#include <dryad/_detail/assert.hpp>
 #include <dryad/_detail/config.hpp>
 #include <new>
 
@@ -97,7 +98,7 @@ class _memory_resource_ptr
 public:
     constexpr explicit _memory_resource_ptr(MemoryResource* resource) noexcept : _resource(resource)
     {
-        LEXY_PRECONDITION(resource);
+        DRYAD_PRECONDITION(resource);
     }
 
     constexpr MemoryResource& operator*() const noexcept
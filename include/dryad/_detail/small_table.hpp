@@ -0,0 +1,121 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_DETAIL_SMALL_TABLE_HPP_INCLUDED
+#define DRYAD_DETAIL_SMALL_TABLE_HPP_INCLUDED
+
+#include <dryad/_detail/assert.hpp>
+#include <dryad/_detail/config.hpp>
+
+namespace dryad::_detail
+{
+// Stores up to `Capacity` keys inline in an unordered array that is searched linearly.
+// Containers use it in front of a hash table, so small instances never allocate: scanning a
+// single cache line of keys is cheaper than hashing anyway.
+template <typename Key, std::size_t Capacity>
+class small_table
+{
+    static_assert(std::is_trivially_copyable_v<Key>);
+
+public:
+    static constexpr auto capacity = Capacity;
+
+    constexpr small_table() : _keys(), _size(0) {}
+
+    std::size_t size() const
+    {
+        return _size;
+    }
+    bool full() const
+    {
+        return _size == Capacity;
+    }
+
+    Key operator[](std::size_t idx) const
+    {
+        DRYAD_PRECONDITION(idx < _size);
+        return _keys[idx];
+    }
+
+    // Returns the index of the key, or `size()` if it isn't stored.
+    template <typename K>
+    std::size_t find(const K& key) const
+    {
+        auto idx = std::size_t(0);
+        while (idx != _size && !(_keys[idx] == key))
+            ++idx;
+        return idx;
+    }
+
+    // Appends the key and returns its index.
+    std::size_t push_back(Key key)
+    {
+        DRYAD_PRECONDITION(!full());
+        _keys[_size] = key;
+        return _size++;
+    }
+
+    // Removes the key by moving the last one into its place.
+    // Values stored in a parallel array have to be moved the same way.
+    void erase(std::size_t idx)
+    {
+        DRYAD_PRECONDITION(idx < _size);
+        --_size;
+        _keys[idx] = _keys[_size];
+    }
+
+    void clear()
+    {
+        _size = 0;
+    }
+
+private:
+    Key         _keys[Capacity];
+    std::size_t _size;
+};
+
+// Disables the inline storage: the table is always empty and full.
+template <typename Key>
+class small_table<Key, 0>
+{
+public:
+    static constexpr auto capacity = std::size_t(0);
+
+    std::size_t size() const
+    {
+        return 0;
+    }
+    bool full() const
+    {
+        return true;
+    }
+
+    Key operator[](std::size_t) const
+    {
+        DRYAD_PRECONDITION(false);
+        return Key();
+    }
+
+    template <typename K>
+    std::size_t find(const K&) const
+    {
+        return 0;
+    }
+
+    std::size_t push_back(Key)
+    {
+        DRYAD_PRECONDITION(false);
+        return 0;
+    }
+
+    void erase(std::size_t)
+    {
+        DRYAD_PRECONDITION(false);
+    }
+
+    void clear() {}
+};
+} // namespace dryad::_detail
+
+#endif // DRYAD_DETAIL_SMALL_TABLE_HPP_INCLUDED
+
@@ -8,6 +8,11 @@
 #include <dryad/_detail/config.hpp>
 #include <dryad/_detail/memory_resource.hpp>
 
+#ifndef DRYAD_ARENA_ALLOCATION_COUNTING
+/// Whether the arena counts the number of allocations for `arena_statistics`.
+#    define DRYAD_ARENA_ALLOCATION_COUNTING 0
+#endif
+
 namespace dryad::_detail
 {
 constexpr bool is_valid_alignment(std::size_t alignment) noexcept
@@ -26,64 +31,151 @@ inline std::size_t align_offset(const void* address, std::size_t alignment) noex
     DRYAD_PRECONDITION(is_valid_alignment(alignment));
     return align_offset(reinterpret_cast<std::uintptr_t>(address), alignment);
 }
+
+template <bool Enabled>
+struct arena_allocation_counter
+{
+    void increment() noexcept {}
+
+    std::size_t get() const noexcept
+    {
+        return 0;
+    }
+};
+template <>
+struct arena_allocation_counter<true>
+{
+    std::size_t count = 0;
+
+    void increment() noexcept
+    {
+        ++count;
+    }
+
+    std::size_t get() const noexcept
+    {
+        return count;
+    }
+};
 } // namespace dryad::_detail
 
 namespace dryad
 {
+/// How the size of newly allocated arena blocks evolves.
+enum class arena_growth
+{
+    /// Every block has the same size.
+    constant,
+    /// Every new block is twice as big as the previous one,
+    /// so the number of blocks is logarithmic in the number of bytes allocated.
+    geometric,
+};
+
+/// Memory usage of an arena.
+struct arena_statistics
+{
+    /// The number of blocks allocated from the memory resource.
+    std::size_t block_count;
+    /// The total size of those blocks, including bookkeeping.
+    std::size_t bytes_reserved;
+    /// The number of bytes currently handed out, including alignment padding.
+    std::size_t bytes_used;
+    /// The number of bytes at the end of blocks that were left unused because an allocation didn't
+    /// fit.
+    std::size_t bytes_wasted;
+    /// The maximal value of `bytes_used` over the lifetime of the arena.
+    std::size_t high_water_mark;
+    /// The number of calls to `allocate()`, only if `DRYAD_ARENA_ALLOCATION_COUNTING` is enabled.
+    std::size_t allocation_count;
+};
+
 /// A simple stack allocator.
 template <typename MemoryResource = void>
 class arena
 {
     using resource_ptr = _detail::memory_resource_ptr<MemoryResource>;
 
-    static constexpr auto block_size = std::size_t(16) * 1024 - sizeof(void*);
-
+    // The memory of a block follows its header.
     struct block
     {
-        block*        next;
-        unsigned char memory[block_size];
+        block*      next;
+        std::size_t capacity;
+        // Statistics of all blocks before this one, updated when it becomes the current block.
+        std::size_t used_before;
+        std::size_t wasted_before;
 
-        static block* allocate(resource_ptr resource)
+        static block* allocate(resource_ptr resource, std::size_t capacity)
         {
-            auto memory = resource->allocate(sizeof(block), alignof(block));
-            auto ptr    = ::new (memory) block; // Don't initialize array!
-            ptr->next   = nullptr;
+            auto memory   = resource->allocate(sizeof(block) + capacity, alignof(block));
+            auto ptr      = ::new (memory) block; // Don't initialize memory!
+            ptr->next     = nullptr;
+            ptr->capacity = capacity;
             return ptr;
         }
 
         static block* deallocate(resource_ptr resource, block* ptr)
         {
             auto next = ptr->next;
-            resource->deallocate(ptr, sizeof(block), alignof(block));
+            resource->deallocate(ptr, sizeof(block) + ptr->capacity, alignof(block));
             return next;
         }
 
+        unsigned char* memory() noexcept
+        {
+            return reinterpret_cast<unsigned char*>(this + 1);
+        }
         unsigned char* end() noexcept
         {
-            return &memory[block_size];
+            return memory() + capacity;
         }
     };
 
 public:
+    /// The size of the blocks requested from the memory resource, including bookkeeping.
+    static constexpr auto default_block_size = std::size_t(16) * 1024;
+
     //=== constructors/destructors/assignment ===//
     constexpr arena() noexcept : arena(_detail::get_memory_resource<MemoryResource>()) {}
 
     explicit constexpr arena(MemoryResource* resource) noexcept
-    : _cur_block(nullptr), _cur_pos(nullptr), _resource(resource), _first_block(nullptr)
+    : arena(resource, default_block_size)
     {}
 
+    explicit constexpr arena(std::size_t block_size,
+                             arena_growth growth = arena_growth::constant) noexcept
+    : arena(_detail::get_memory_resource<MemoryResource>(), block_size, growth)
+    {}
+
+    /// `block_size` is the size of the first block, including bookkeeping.
+    /// With `arena_growth::geometric`, each subsequent block doubles it.
+    explicit constexpr arena(MemoryResource* resource, std::size_t block_size,
+                             arena_growth growth = arena_growth::constant) noexcept
+    : _cur_block(nullptr), _cur_pos(nullptr), _resource(resource), _first_block(nullptr),
+      _first_block_size(block_size), _block_size(block_size), _growth(growth), _absorbed(nullptr),
+      _absorbed_bytes(0), _block_count(0), _bytes_reserved(0), _high_water_mark(0)
+    {
+        DRYAD_PRECONDITION(block_size > sizeof(block));
+    }
+
     arena(arena&& other) noexcept
     : _cur_block(other._cur_block), _cur_pos(other._cur_pos), _resource(other._resource),
-      _first_block(other._first_block)
+      _first_block(other._first_block), _first_block_size(other._first_block_size),
+      _block_size(other._block_size), _growth(other._growth), _absorbed(other._absorbed),
+      _absorbed_bytes(other._absorbed_bytes), _block_count(other._block_count),
+      _bytes_reserved(other._bytes_reserved), _high_water_mark(other._high_water_mark),
+      _allocation_count(other._allocation_count)
     {
-        other._first_block = other._cur_block = nullptr;
-        other._cur_pos                        = nullptr;
+        other._first_block = other._cur_block = other._absorbed = nullptr;
+        other._cur_pos                                          = nullptr;
+        other._absorbed_bytes = other._block_count = other._bytes_reserved = 0;
+        other._high_water_mark                                             = 0;
     }
 
     ~arena() noexcept
     {
-        auto cur = _first_block;
-        while (cur != nullptr)
+        for (auto cur = _first_block; cur != nullptr;)
+            cur = block::deallocate(_resource, cur);
+        for (auto cur = _absorbed; cur != nullptr;)
             cur = block::deallocate(_resource, cur);
     }
 
@@ -93,40 +185,38 @@ public:
         _detail::swap(_first_block, other._first_block);
         _detail::swap(_cur_block, other._cur_block);
         _detail::swap(_cur_pos, other._cur_pos);
+        _detail::swap(_first_block_size, other._first_block_size);
+        _detail::swap(_block_size, other._block_size);
+        _detail::swap(_growth, other._growth);
+        _detail::swap(_absorbed, other._absorbed);
+        _detail::swap(_absorbed_bytes, other._absorbed_bytes);
+        _detail::swap(_block_count, other._block_count);
+        _detail::swap(_bytes_reserved, other._bytes_reserved);
+        _detail::swap(_high_water_mark, other._high_water_mark);
+        _detail::swap(_allocation_count, other._allocation_count);
         return *this;
     }
 
     //=== allocation ===//
-    static constexpr auto max_allocation_size = block_size;
-
+    /// Allocations that don't fit into a regular block, or require an alignment bigger than
+    /// `alignof(void*)`, are still supported; they might get a dedicated block.
     void* allocate(std::size_t size, std::size_t alignment)
     {
-        DRYAD_PRECONDITION(size <= max_allocation_size);
-        DRYAD_PRECONDITION(alignment <= alignof(void*));
+        DRYAD_PRECONDITION(_detail::is_valid_alignment(alignment));
+        _allocation_count.increment();
 
         auto offset    = _detail::align_offset(_cur_pos, alignment);
         auto remaining = _cur_block == nullptr ? 0 : std::size_t(_cur_block->end() - _cur_pos);
         if (offset + size > remaining)
         {
-            if (_cur_block == nullptr)
-            {
-                DRYAD_ASSERT(_first_block == nullptr,
-                             "_cur_block is always valid once we have a block");
-                _first_block = block::allocate(_resource);
-                _cur_block   = _first_block;
-            }
-            else
-            {
-                if (_cur_block->next == nullptr)
-                    _cur_block->next = block::allocate(_resource);
-
-                _cur_block = _cur_block->next;
-            }
-
-            _cur_pos = &_cur_block->memory[0];
-            offset   = 0;
-            DRYAD_ASSERT(_detail::align_offset(_cur_pos, alignment) == 0,
-                         "beginning of block should be properly aligned");
+            // The beginning of a block is only guaranteed to be aligned for the header,
+            // so we need to reserve space for padding in the worst case.
+            auto padding = alignment > alignof(block) ? alignment - 1 : 0;
+            next_block(size + padding);
+
+            _cur_pos = _cur_block->memory();
+            offset   = _detail::align_offset(_cur_pos, alignment);
+            DRYAD_ASSERT(offset <= padding, "padding should be sufficient");
         }
 
         _cur_pos += offset;
@@ -138,8 +228,6 @@ public:
     template <typename T>
     void* allocate()
     {
-        static_assert(sizeof(T) <= max_allocation_size);
-        static_assert(alignof(T) <= alignof(void*));
         return allocate(sizeof(T), alignof(T));
     }
 
@@ -149,10 +237,66 @@ public:
         return ::new (allocate<T>()) T(DRYAD_FWD(args)...);
     }
 
+    /// Ensures that allocations totaling `size` bytes, including alignment padding, fit into the
+    /// current block, so they don't need to allocate a new one.
+    void reserve(std::size_t size)
+    {
+        auto remaining = _cur_block == nullptr ? 0 : std::size_t(_cur_block->end() - _cur_pos);
+        if (size > remaining)
+        {
+            next_block(size);
+            _cur_pos = _cur_block->memory();
+        }
+    }
+
     resource_ptr resource() const
     {
         return _resource;
     }
+    /// The block size and growth strategy the arena was constructed with.
+    std::size_t block_size() const noexcept
+    {
+        return _first_block_size;
+    }
+    arena_growth growth() const noexcept
+    {
+        return _growth;
+    }
+
+    /// Takes ownership of all memory of `other`, which must use the same memory resource.
+    ///
+    /// Everything allocated from `other` stays valid until this arena is cleared or destroyed;
+    /// afterwards, the blocks are re-used for new allocations. `other` is empty.
+    void absorb(arena&& other)
+    {
+        DRYAD_PRECONDITION(_resource.get() == other._resource.get());
+        if (&other == this)
+            return;
+
+        _absorbed_bytes += other.bytes_used() + other._absorbed_bytes;
+        _block_count += other._block_count;
+        _bytes_reserved += other._bytes_reserved;
+        // In a chain of versions, the previously absorbed blocks are the long list.
+        splice_blocks(_absorbed, other._absorbed);
+        splice_blocks(_absorbed, other._first_block);
+
+        other._cur_block      = nullptr;
+        other._cur_pos        = nullptr;
+        other._absorbed_bytes = other._block_count = other._bytes_reserved = 0;
+    }
+
+    //=== statistics ===//
+    /// Constant time; doesn't walk the list of blocks.
+    arena_statistics statistics() const noexcept
+    {
+        auto used = bytes_used() + _absorbed_bytes;
+        return {_block_count,
+                _bytes_reserved,
+                used,
+                _cur_block == nullptr ? 0 : _cur_block->wasted_before,
+                used > _high_water_mark ? used : _high_water_mark,
+                _allocation_count.get()};
+    }
 
     //=== unwinding ===//
     struct marker
@@ -168,26 +312,179 @@ public:
 
     void unwind(marker m)
     {
+        update_high_water_mark();
         _cur_block = m.cur_block;
         _cur_pos   = m.cur_pos;
     }
 
     void clear()
     {
+        if (_absorbed != nullptr)
+        {
+            // The blocks of other arenas can be used for new allocations now.
+            update_high_water_mark();
+            auto last = &_first_block;
+            while (*last != nullptr)
+                last = &(*last)->next;
+            splice_blocks(*last, _absorbed);
+            _absorbed_bytes = 0;
+        }
+
         if (_first_block == nullptr)
             // We never held data to begin with, so don't need to do anything.
             return;
 
+        update_high_water_mark();
         _cur_block = _first_block;
-        _cur_pos   = &_cur_block->memory[0];
+        _cur_pos   = _cur_block->memory();
+    }
+
+    /// Same as `clear()`, but only keeps blocks as long as their total size, including
+    /// bookkeeping, doesn't exceed `retained_bytes`; the remaining blocks are deallocated.
+    /// This prevents a single big allocation phase from pinning its peak memory usage forever.
+    void clear(std::size_t retained_bytes)
+    {
+        clear();
+
+        auto link     = &_first_block;
+        auto retained = std::size_t(0);
+        while (*link != nullptr && retained + (*link)->capacity + sizeof(block) <= retained_bytes)
+        {
+            retained += (*link)->capacity + sizeof(block);
+            link = &(*link)->next;
+        }
+        deallocate_blocks(*link);
+
+        if (_first_block == nullptr)
+        {
+            _cur_block = nullptr;
+            _cur_pos   = nullptr;
+        }
+    }
+
+    /// Deallocates all blocks after the current one.
+    /// Markers that point into blocks after the current one are invalidated.
+    void shrink_to_fit()
+    {
+        deallocate_blocks(_cur_block == nullptr ? _first_block : _cur_block->next);
     }
 
 private:
+    std::size_t bytes_used() const noexcept
+    {
+        if (_cur_block == nullptr)
+            return 0;
+        return _cur_block->used_before + std::size_t(_cur_pos - _cur_block->memory());
+    }
+
+    void update_high_water_mark() noexcept
+    {
+        auto used = bytes_used() + _absorbed_bytes;
+        if (used > _high_water_mark)
+            _high_water_mark = used;
+    }
+
+    // Makes a block with at least `capacity` bytes the current block.
+    void next_block(std::size_t capacity)
+    {
+        auto used_before   = bytes_used();
+        auto wasted_before = _cur_block == nullptr
+                                 ? 0
+                                 : _cur_block->wasted_before
+                                       + std::size_t(_cur_block->end() - _cur_pos);
+
+        // _cur_block is only null if we haven't allocated anything or unwound to such a state.
+        auto& next = _cur_block == nullptr ? _first_block : _cur_block->next;
+        if (next == nullptr || next->capacity < capacity)
+        {
+            // Insert a new block, any next block that is too small remains available for later.
+            auto new_block  = allocate_block(capacity);
+            new_block->next = next;
+            next            = new_block;
+        }
+
+        _cur_block                = next;
+        _cur_block->used_before   = used_before;
+        _cur_block->wasted_before = wasted_before;
+    }
+
+    block* allocate_block(std::size_t min_capacity)
+    {
+        auto capacity = _block_size - sizeof(block);
+        if (min_capacity > capacity)
+            // Give the allocation a dedicated block; this doesn't count towards growth.
+            capacity = min_capacity;
+        else if (_growth == arena_growth::geometric && _block_size <= std::size_t(-1) / 4)
+            _block_size *= 2;
+
+        auto result = block::allocate(_resource, capacity);
+        ++_block_count;
+        _bytes_reserved += sizeof(block) + capacity;
+        return result;
+    }
+
+    // Moves all blocks of `list` in front of `head`, linear in the length of `list`.
+    static void splice_blocks(block*& head, block*& list) noexcept
+    {
+        if (list == nullptr)
+            return;
+        if (head == nullptr)
+        {
+            head = list;
+            list = nullptr;
+            return;
+        }
+
+        auto last = list;
+        while (last->next != nullptr)
+            last = last->next;
+        last->next = head;
+        head       = list;
+        list       = nullptr;
+    }
+
+    // Deallocates `head` and all blocks after it.
+    void deallocate_blocks(block*& head) noexcept
+    {
+        auto cur = head;
+        head     = nullptr;
+        while (cur != nullptr)
+        {
+            --_block_count;
+            _bytes_reserved -= sizeof(block) + cur->capacity;
+            cur = block::deallocate(_resource, cur);
+        }
+
+        if (_growth == arena_growth::geometric)
+        {
+            // Continue growing from the biggest block we still have,
+            // not from the biggest block we ever had.
+            _block_size = _first_block_size;
+            for (auto b = _first_block; b != nullptr; b = b->next)
+            {
+                auto size = sizeof(block) + b->capacity;
+                if (size >= _block_size && size <= std::size_t(-1) / 4)
+                    _block_size = 2 * size;
+            }
+        }
+    }
+
     block*         _cur_block;
     unsigned char* _cur_pos;
 
     DRYAD_EMPTY_MEMBER resource_ptr _resource;
     block*                          _first_block;
+    std::size_t                     _first_block_size;
+    std::size_t                     _block_size;
+    arena_growth                    _growth;
+    block*                          _absorbed; // blocks of other arenas that are still in use
+    std::size_t                     _absorbed_bytes;
+
+    std::size_t _block_count;
+    std::size_t _bytes_reserved;
+    std::size_t _high_water_mark;
+    DRYAD_EMPTY_MEMBER _detail::arena_allocation_counter<DRYAD_ARENA_ALLOCATION_COUNTING>
+        _allocation_count;
 };
 } // namespace dryad
 
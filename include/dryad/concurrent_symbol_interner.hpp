@@ -0,0 +1,346 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_CONCURRENT_SYMBOL_INTERNER_HPP_INCLUDED
+#define DRYAD_CONCURRENT_SYMBOL_INTERNER_HPP_INCLUDED
+
+#include <atomic>
+#include <climits>
+#include <cstring>
+#include <dryad/_detail/assert.hpp>
+#include <dryad/_detail/config.hpp>
+#include <dryad/_detail/memory_resource.hpp>
+#include <dryad/arena.hpp>
+#include <dryad/hash_algorithm.hpp>
+#include <dryad/symbol.hpp>
+#include <mutex>
+#include <utility>
+
+namespace dryad::_detail
+{
+// Maps the dense indices of a concurrent_symbol_interner to their strings.
+// It consists of segments of doubling size that are never re-allocated, so lookups are lock-free.
+template <typename CharT, typename IndexType>
+class concurrent_symbol_directory
+{
+    static constexpr auto first_segment_bits = 10u;
+    static constexpr auto segment_count      = sizeof(IndexType) * CHAR_BIT;
+
+public:
+    constexpr concurrent_symbol_directory() : _segments() {}
+
+    template <typename ResourcePtr>
+    void free(ResourcePtr resource)
+    {
+        for (auto segment = 0u; segment != segment_count; ++segment)
+        {
+            auto ptr = _segments[segment].load(std::memory_order_relaxed);
+            if (ptr != nullptr)
+                resource->deallocate(ptr, segment_size(segment) * sizeof(const CharT*),
+                                     alignof(const CharT*));
+        }
+    }
+
+    // Can be called concurrently, but only once per index.
+    template <typename ResourcePtr>
+    void insert(ResourcePtr resource, IndexType index, const CharT* str)
+    {
+        auto [segment, offset] = locate(index);
+
+        auto ptr = _segments[segment].load(std::memory_order_acquire);
+        if (ptr == nullptr)
+        {
+            // Multiple threads can race to allocate the same segment, only one of them wins.
+            auto size = segment_size(segment) * sizeof(const CharT*);
+            auto new_ptr
+                = static_cast<const CharT**>(resource->allocate(size, alignof(const CharT*)));
+            if (_segments[segment].compare_exchange_strong(ptr, new_ptr,
+                                                           std::memory_order_acq_rel))
+                ptr = new_ptr;
+            else
+                resource->deallocate(new_ptr, size, alignof(const CharT*));
+        }
+
+        ptr[offset] = str;
+    }
+
+    const CharT* lookup(IndexType index) const
+    {
+        auto [segment, offset] = locate(index);
+        return _segments[segment].load(std::memory_order_acquire)[offset];
+    }
+
+private:
+    struct location
+    {
+        unsigned    segment;
+        std::size_t offset;
+    };
+
+    static constexpr std::size_t segment_size(unsigned segment)
+    {
+        return std::size_t(1) << (first_segment_bits + segment);
+    }
+
+    static location locate(IndexType index)
+    {
+        // Segment n starts at index (2^n - 1) * first_segment_size.
+        auto biased  = static_cast<unsigned long long>(index) + (1ull << first_segment_bits);
+        auto segment = unsigned(int(sizeof(biased) * CHAR_BIT) - 1 - __builtin_clzll(biased))
+                       - first_segment_bits;
+        return {segment, std::size_t(biased - (1ull << (first_segment_bits + segment)))};
+    }
+
+    std::atomic<const CharT**> _segments[segment_count];
+};
+
+// A linear probing table of symbol indices that can be read while it is being written.
+// It is never modified after it has been replaced by a bigger table.
+template <typename IndexType>
+struct concurrent_symbol_table
+{
+    struct slot
+    {
+        std::atomic<IndexType> index;
+        IndexType              hash; // only valid once index has been set
+    };
+
+    std::size_t              capacity; // power of two
+    std::size_t              size;
+    concurrent_symbol_table* retired; // previous tables that might still be read
+
+    static constexpr auto empty = IndexType(-1);
+
+    template <typename ResourcePtr>
+    static concurrent_symbol_table* allocate(ResourcePtr resource, std::size_t capacity)
+    {
+        auto memory = resource->allocate(sizeof(concurrent_symbol_table) + capacity * sizeof(slot),
+                                         alignof(concurrent_symbol_table));
+        auto table  = ::new (memory) concurrent_symbol_table{capacity, 0, nullptr};
+        for (auto i = std::size_t(0); i != capacity; ++i)
+            ::new (&table->slots()[i]) slot{{empty}, 0};
+        return table;
+    }
+
+    template <typename ResourcePtr>
+    static void deallocate(ResourcePtr resource, concurrent_symbol_table* table)
+    {
+        while (table != nullptr)
+        {
+            auto retired = table->retired;
+            auto size    = sizeof(concurrent_symbol_table) + table->capacity * sizeof(slot);
+            resource->deallocate(table, size, alignof(concurrent_symbol_table));
+            table = retired;
+        }
+    }
+
+    slot* slots() noexcept
+    {
+        return reinterpret_cast<slot*>(this + 1);
+    }
+
+    bool should_rehash() const noexcept
+    {
+        return size >= capacity / 2;
+    }
+
+    struct entry
+    {
+        slot*     location;
+        IndexType index; // the index that was compared, or empty
+    };
+
+    // Returns the matching entry or the empty slot where it should be inserted.
+    //
+    // Another thread can fill the empty slot right after we've seen it, so the index must not be
+    // loaded from the slot again: it might belong to a different string.
+    template <typename Equal>
+    entry lookup(IndexType hash, Equal equal) noexcept
+    {
+        auto mask = capacity - 1;
+        for (auto i = std::size_t(hash) & mask;; i = (i + 1) & mask)
+        {
+            auto& s     = slots()[i];
+            auto  index = s.index.load(std::memory_order_acquire);
+            if (index == empty || (s.hash == hash && equal(index)))
+                return {&s, index};
+        }
+    }
+};
+} // namespace dryad::_detail
+
+namespace dryad
+{
+/// A symbol interner that can be used by multiple threads at the same time.
+///
+/// Interning a string that has already been interned doesn't lock; only inserting a new string
+/// locks one of multiple shards selected by the hash. Symbols are indices in insertion order and
+/// are comparable across all threads. The memory resource needs to be thread-safe.
+template <typename Id, typename CharT = char, typename IndexType = std::size_t,
+          typename MemoryResource = void, typename HashAlgorithm = default_hash_algorithm>
+class concurrent_symbol_interner
+{
+    static_assert(std::is_trivial_v<CharT>);
+    static_assert(std::is_unsigned_v<IndexType>);
+    static_assert(std::atomic<IndexType>::is_always_lock_free);
+
+    using resource_ptr = _detail::memory_resource_ptr<MemoryResource>;
+    using table        = _detail::concurrent_symbol_table<IndexType>;
+
+    static constexpr auto shard_bits         = 4u;
+    static constexpr auto shard_count        = std::size_t(1) << shard_bits;
+    static constexpr auto min_shard_capacity = std::size_t(64);
+
+public:
+    using symbol = dryad::symbol<Id, IndexType>;
+
+    //=== construction ===//
+    concurrent_symbol_interner()
+    : concurrent_symbol_interner(_detail::get_memory_resource<MemoryResource>())
+    {}
+    explicit concurrent_symbol_interner(MemoryResource* resource)
+    : concurrent_symbol_interner(resource, std::make_index_sequence<shard_count>{})
+    {}
+
+    concurrent_symbol_interner(const concurrent_symbol_interner&)            = delete;
+    concurrent_symbol_interner& operator=(const concurrent_symbol_interner&) = delete;
+
+    ~concurrent_symbol_interner() noexcept
+    {
+        for (auto& shard : _shards)
+            table::deallocate(_resource, shard.current.load(std::memory_order_relaxed));
+        _directory.free(_resource);
+    }
+
+    //=== interning ===//
+    /// Can be called from multiple threads at the same time.
+    symbol intern(const CharT* str, std::size_t length)
+    {
+        auto hash  = HashAlgorithm()
+                        .hash_bytes(reinterpret_cast<const unsigned char*>(str),
+                                    length * sizeof(CharT))
+                        .finish();
+        auto key   = static_cast<IndexType>(hash);
+        auto equal = [&](IndexType index) { return is_equal(index, str, length); };
+
+        auto& shard = _shards[hash >> (sizeof(hash) * CHAR_BIT - shard_bits)];
+
+        // Fast path: lock-free lookup in the current table.
+        {
+            auto entry = shard.current.load(std::memory_order_acquire)->lookup(key, equal);
+            if (entry.index != table::empty)
+                return symbol(entry.index);
+        }
+
+        // Slow path: another thread might have inserted it in the mean time, so check again.
+        std::lock_guard<std::mutex> lock(shard.mutex);
+
+        auto cur_table = shard.current.load(std::memory_order_relaxed);
+        if (cur_table->should_rehash())
+            cur_table = rehash(shard, cur_table);
+
+        auto entry = cur_table->lookup(key, equal);
+        if (entry.index != table::empty)
+            return symbol(entry.index);
+
+        // Copy the string and publish it in the directory, before we publish the index.
+        auto memory = static_cast<CharT*>(shard.strings.allocate((length + 1) * sizeof(CharT),
+                                                                 alignof(CharT)));
+        std::memcpy(memory, str, length * sizeof(CharT));
+        memory[length] = CharT(0);
+
+        auto new_index = _size.fetch_add(1, std::memory_order_relaxed);
+        DRYAD_PRECONDITION(new_index < std::size_t(table::empty)); // Overflow of index type.
+        _directory.insert(_resource, IndexType(new_index), memory);
+
+        entry.location->hash = key;
+        entry.location->index.store(IndexType(new_index), std::memory_order_release);
+        ++cur_table->size;
+
+        return symbol(IndexType(new_index));
+    }
+    template <std::size_t N>
+    symbol intern(const CharT (&literal)[N])
+    {
+        DRYAD_PRECONDITION(literal[N - 1] == CharT(0));
+        return intern(literal, N - 1);
+    }
+
+    /// The number of symbols interned so far.
+    std::size_t size() const
+    {
+        return _size.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct alignas(64) shard // avoid false sharing
+    {
+        std::mutex                   mutex;
+        std::atomic<table*>          current;
+        dryad::arena<MemoryResource> strings;
+
+        explicit shard(MemoryResource* resource)
+        : current(table::allocate(resource_ptr(resource), min_shard_capacity)), strings(resource)
+        {}
+    };
+
+    template <std::size_t... Idx>
+    explicit concurrent_symbol_interner(MemoryResource* resource, std::index_sequence<Idx...>)
+    : _resource(resource), _size(0), _shards{make_shard(Idx, resource)...}
+    {}
+
+    static shard make_shard(std::size_t, MemoryResource* resource)
+    {
+        return shard(resource);
+    }
+
+    bool is_equal(IndexType index, const CharT* str, std::size_t length) const
+    {
+        auto existing_str = _directory.lookup(index);
+        for (auto i = std::size_t(0); i != length; ++i)
+            if (existing_str[i] != str[i] || existing_str[i] == CharT(0))
+                return false;
+        return existing_str[length] == CharT(0);
+    }
+
+    table* rehash(shard& shard, table* old_table)
+    {
+        auto new_table = table::allocate(_resource, 2 * old_table->capacity);
+        for (auto i = std::size_t(0); i != old_table->capacity; ++i)
+        {
+            auto& old_slot = old_table->slots()[i];
+            auto  index    = old_slot.index.load(std::memory_order_relaxed);
+            if (index == table::empty)
+                continue;
+
+            // All strings are distinct, so we only need the first empty slot.
+            auto new_slot
+                = new_table->lookup(old_slot.hash, [](IndexType) { return false; }).location;
+            new_slot->hash = old_slot.hash;
+            new_slot->index.store(index, std::memory_order_relaxed);
+        }
+        new_table->size = old_table->size;
+
+        // Readers might still access the old table, so we can only free it in the destructor.
+        new_table->retired = old_table;
+        shard.current.store(new_table, std::memory_order_release);
+        return new_table;
+    }
+
+    const CharT* c_str(IndexType index) const
+    {
+        DRYAD_PRECONDITION(index < size());
+        return _directory.lookup(index);
+    }
+
+    DRYAD_EMPTY_MEMBER resource_ptr                        _resource;
+    std::atomic<std::size_t>                               _size;
+    _detail::concurrent_symbol_directory<CharT, IndexType> _directory;
+    shard                                                  _shards[shard_count];
+
+    friend symbol;
+};
+} // namespace dryad
+
+#endif // DRYAD_CONCURRENT_SYMBOL_INTERNER_HPP_INCLUDED
+
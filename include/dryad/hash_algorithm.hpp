@@ -5,6 +5,7 @@
 #define DRYAD_HASH_ALGORITHM_HPP_INCLUDED
 
 #include <cstdint>
+#include <cstring>
 #include <dryad/_detail/config.hpp>
 
 namespace dryad
@@ -58,6 +59,151 @@ public:
         return _hash;
     }
 
+private:
+    std::uint64_t _hash;
+};
+
+/// 64 bit hash based on wyhash.
+///
+/// Unlike FNV-1a, it processes 16 bytes per step (48 bytes for long inputs) using 64x64->128 bit
+/// multiplication for mixing, which makes it a lot faster for long strings.
+/// Like FNV-1a, hashing a string via `hash_c_str()` gives the same result as hashing its
+/// characters via `hash_bytes()`.
+class wyhash_algorithm
+{
+    static constexpr std::uint64_t secret0 = 0xa0761d6478bd642full;
+    static constexpr std::uint64_t secret1 = 0xe7037ed1a0b428dbull;
+    static constexpr std::uint64_t secret2 = 0x8ebc6af09c88c6e3ull;
+    static constexpr std::uint64_t secret3 = 0x589965cc75374cc3ull;
+
+    static std::uint64_t mix(std::uint64_t lhs, std::uint64_t rhs)
+    {
+#if defined(__SIZEOF_INT128__)
+        __extension__ typedef unsigned __int128 uint128;
+        auto product = static_cast<uint128>(lhs) * rhs;
+        return std::uint64_t(product) ^ std::uint64_t(product >> 64);
+#else
+        auto lhs_hi = lhs >> 32, lhs_lo = lhs & 0xFFFF'FFFFull;
+        auto rhs_hi = rhs >> 32, rhs_lo = rhs & 0xFFFF'FFFFull;
+        auto hi_hi = lhs_hi * rhs_hi, hi_lo = lhs_hi * rhs_lo;
+        auto lo_hi = lhs_lo * rhs_hi, lo_lo = lhs_lo * rhs_lo;
+
+        auto lo    = lo_lo + (hi_lo << 32);
+        auto carry = std::uint64_t(lo < lo_lo);
+        auto tmp   = lo;
+        lo += lo_hi << 32;
+        carry += lo < tmp;
+        auto hi = hi_hi + (hi_lo >> 32) + (lo_hi >> 32) + carry;
+        return lo ^ hi;
+#endif
+    }
+
+    static std::uint64_t read8(const unsigned char* ptr)
+    {
+        std::uint64_t result;
+        std::memcpy(&result, ptr, sizeof(result));
+        return result;
+    }
+    static std::uint64_t read4(const unsigned char* ptr)
+    {
+        std::uint32_t result;
+        std::memcpy(&result, ptr, sizeof(result));
+        return result;
+    }
+    static std::uint64_t read_small(const unsigned char* ptr, std::size_t size)
+    {
+        // Reads 1-3 bytes.
+        return (std::uint64_t(ptr[0]) << 16) | (std::uint64_t(ptr[size >> 1]) << 8) | ptr[size - 1];
+    }
+
+public:
+    explicit wyhash_algorithm() : _hash(secret0) {}
+
+    wyhash_algorithm(wyhash_algorithm&&)            = default;
+    wyhash_algorithm& operator=(wyhash_algorithm&&) = default;
+
+    ~wyhash_algorithm() = default;
+
+    DRYAD_FORCE_INLINE wyhash_algorithm&& hash_bytes(const unsigned char* ptr, std::size_t size)
+    {
+        auto          seed = _hash;
+        std::uint64_t a, b;
+        if (size <= 16)
+        {
+            if (size >= 4)
+            {
+                auto offset = (size >> 3) << 2;
+                a           = (read4(ptr) << 32) | read4(ptr + offset);
+                b           = (read4(ptr + size - 4) << 32) | read4(ptr + size - 4 - offset);
+            }
+            else if (size > 0)
+            {
+                a = read_small(ptr, size);
+                b = 0;
+            }
+            else
+            {
+                a = b = 0;
+            }
+        }
+        else
+        {
+            auto remaining = size;
+            if (remaining > 48)
+            {
+                // Three independent lanes for instruction level parallelism.
+                auto seed1 = seed, seed2 = seed;
+                do
+                {
+                    seed  = mix(read8(ptr) ^ secret1, read8(ptr + 8) ^ seed);
+                    seed1 = mix(read8(ptr + 16) ^ secret2, read8(ptr + 24) ^ seed1);
+                    seed2 = mix(read8(ptr + 32) ^ secret3, read8(ptr + 40) ^ seed2);
+                    ptr += 48;
+                    remaining -= 48;
+                } while (remaining > 48);
+                seed ^= seed1 ^ seed2;
+            }
+            while (remaining > 16)
+            {
+                seed = mix(read8(ptr) ^ secret1, read8(ptr + 8) ^ seed);
+                ptr += 16;
+                remaining -= 16;
+            }
+
+            // The last 16 bytes, which may overlap with bytes that were already hashed.
+            a = read8(ptr + remaining - 16);
+            b = read8(ptr + remaining - 8);
+        }
+
+        _hash = mix(secret1 ^ size, mix(a ^ secret1, b ^ seed));
+        return DRYAD_MOV(*this);
+    }
+
+    template <typename T, typename = std::enable_if_t<std::is_scalar_v<T>>>
+    DRYAD_FORCE_INLINE wyhash_algorithm&& hash_scalar(T value)
+    {
+        static_assert(!std::is_floating_point_v<T>,
+                      "you shouldn't use floats as keys for a hash table");
+        hash_bytes(reinterpret_cast<unsigned char*>(&value), sizeof(T));
+        return DRYAD_MOV(*this);
+    }
+
+    template <typename CharT>
+    wyhash_algorithm&& hash_c_str(const CharT* str)
+    {
+        auto length = std::size_t(0);
+        while (str[length] != CharT(0))
+            ++length;
+
+        hash_bytes(reinterpret_cast<const unsigned char*>(str), length * sizeof(CharT));
+        return DRYAD_MOV(*this);
+    }
+
+    std::uint64_t finish() &&
+    {
+        return mix(_hash ^ secret0, secret1);
+    }
+
 private:
     std::uint64_t _hash;
 };
@@ -35,6 +35,12 @@ struct NodeHasher : ndryad::node_hasher_base<NodeHasher, NodeType1, NodeType2, .
     static bool is_equal(const NodeTypeN* value, Key key);
     ...
 };
+
+// Nodes can only have a single parent, so identical subtrees of different roots are separate
+// copies: hashing and comparing a root is linear in the size of its tree.
+// To share subtrees (i.e. create a DAG) store pointers to other roots of the hash_forest as node
+// data, hash and compare those pointers, and create the nodes using `lookup_or_create()`.
+// Then hashing and comparing a node is constant.
 #endif
 
 namespace dryad
@@ -106,25 +112,31 @@ namespace dryad::_detail
 template <typename T, typename Key>
 struct hash_forest_key
 {
-    const Key* key;
+    const Key*  key;
+    std::size_t hash;
+};
+
+// An entry in the hash table of roots.
+// It caches the hash of the root, so we never need to re-hash the entire tree on rehash or when
+// comparing against an entry.
+template <typename RootNode>
+struct hash_forest_entry
+{
+    RootNode*   node;
+    std::size_t hash;
 };
 
-template <typename RootNode, typename NodeHasher>
+template <typename RootNode, typename NodeHasher, typename HashAlgorithm>
 struct hash_forest_traits
 {
-    using value_type = RootNode*;
+    using value_type = hash_forest_entry<RootNode>;
 
-    static bool is_unoccupied(value_type ptr)
+    static bool is_unoccupied(value_type entry)
     {
-        auto bits = reinterpret_cast<std::uintptr_t>(ptr);
+        auto bits = reinterpret_cast<std::uintptr_t>(entry.node);
         return bits == 0 || bits == std::uintptr_t(-1);
     }
 
-    static void fill_removed(value_type* data, size_t size)
-    {
-        std::memset(data, static_cast<unsigned char>(-1), size * sizeof(value_type));
-    }
-
     static void fill_unoccupied(value_type* data, size_t size)
     {
         std::memset(data, static_cast<unsigned char>(0), size * sizeof(value_type));
@@ -132,12 +144,14 @@ struct hash_forest_traits
 
     static bool is_equal(value_type entry, value_type key)
     {
-        return NodeHasher::is_equal_base(entry, key);
+        return entry.hash == key.hash && NodeHasher::is_equal_base(entry.node, key.node);
     }
     template <typename T, typename Key>
     static bool is_equal(value_type entry, hash_forest_key<T, Key> key)
     {
-        if (auto node = node_try_cast<T>(entry))
+        if (entry.hash != key.hash)
+            return false;
+        else if (auto node = node_try_cast<T>(entry.node))
             return NodeHasher::is_equal(node, *key.key);
         else
             return false;
@@ -145,17 +159,27 @@ struct hash_forest_traits
 
     static std::size_t hash(value_type entry)
     {
-        default_hash_algorithm hasher;
-        NodeHasher::hash_base(hasher, entry);
-        return DRYAD_MOV(hasher).finish();
+        return entry.hash;
     }
     template <typename T, typename Key>
     static std::size_t hash(hash_forest_key<T, Key> key)
     {
-        default_hash_algorithm hasher;
+        return key.hash;
+    }
+
+    static value_type make_entry(RootNode* node)
+    {
+        HashAlgorithm hasher;
+        NodeHasher::hash_base(hasher, node);
+        return {node, DRYAD_MOV(hasher).finish()};
+    }
+    template <typename T, typename Key>
+    static hash_forest_key<T, Key> make_key(const Key& key)
+    {
+        HashAlgorithm hasher;
         hasher.hash_scalar(T::kind());
-        NodeHasher::hash(hasher, *key.key);
-        return DRYAD_MOV(hasher).finish();
+        NodeHasher::hash(hasher, key);
+        return {&key, DRYAD_MOV(hasher).finish()};
     }
 };
 } // namespace dryad::_detail
@@ -164,10 +188,14 @@ namespace dryad
 {
 /// Owns multiple nodes, eventually all children of a list of root nodes.
 /// Identical trees are interned.
-template <typename RootNode, typename NodeHasher, typename MemoryResource = void>
+///
+/// `Probing` is the strategy of the hash table of the roots, `group_probing` compares fewer trees.
+template <typename RootNode, typename NodeHasher, typename MemoryResource = void,
+          typename HashAlgorithm = default_hash_algorithm, typename Probing = linear_probing>
 class hash_forest
 {
-    using hash_table = _detail::hash_table<_detail::hash_forest_traits<RootNode, NodeHasher>, 64>;
+    using traits     = _detail::hash_forest_traits<RootNode, NodeHasher, HashAlgorithm>;
+    using hash_table = _detail::hash_table<traits, 64, Probing>;
 
 public:
     using node_kind_type = typename RootNode::node_kind_type;
@@ -175,6 +203,14 @@ public:
     //=== construction ===//
     hash_forest() = default;
     explicit hash_forest(MemoryResource* resource) : _arena(resource) {}
+    /// Forwards the block size and growth strategy to the underlying arena.
+    explicit hash_forest(std::size_t block_size, arena_growth growth = arena_growth::constant)
+    : _arena(block_size, growth)
+    {}
+    explicit hash_forest(MemoryResource* resource, std::size_t block_size,
+                         arena_growth growth = arena_growth::constant)
+    : _arena(resource, block_size, growth)
+    {}
 
     ~hash_forest()
     {
@@ -207,17 +243,19 @@ public:
         auto node = builder(node_creator(_arena));
         node->set_next_parent(node);
 
-        auto entry = _roots.lookup_entry(node);
+        // We hash the entire tree once, the hash is then stored in the table.
+        auto key   = traits::make_entry(node);
+        auto entry = _roots.lookup_entry(key);
         if (entry)
         {
             // Node is already part of the tree, remove its memory and return existing one.
             _arena.unwind(marker);
-            return entry.get();
+            return entry.get().node;
         }
         else
         {
             // Node is not part of the tree.
-            entry.create(node);
+            entry.create(key);
             return node;
         }
     }
@@ -235,13 +273,14 @@ public:
         if (_roots.should_rehash())
             rehash(2 * _roots.capacity());
 
-        auto entry = _roots.lookup_entry(_detail::hash_forest_key<T, std::decay_t<Key>>{&key});
+        auto hashed_key = traits::template make_key<T>(key);
+        auto entry      = _roots.lookup_entry(hashed_key);
         if (entry)
-            return entry.get();
+            return entry.get().node;
 
         auto node = node_creator(_arena).template create<T>(DRYAD_FWD(key));
         node->set_next_parent(node);
-        entry.create(node);
+        entry.create({node, hashed_key.hash});
         return node;
     }
 
@@ -250,6 +289,67 @@ public:
         _roots.free(_arena.resource());
         _arena.clear();
     }
+    /// Same as `clear()`, but only keeps up to `retained_bytes` of memory for the next nodes.
+    void clear(std::size_t retained_bytes)
+    {
+        _roots.free(_arena.resource());
+        _arena.clear(retained_bytes);
+    }
+
+    /// Interns the roots of `other` and takes ownership of its nodes without copying them.
+    /// `other` must use the same memory resource and is empty afterwards.
+    ///
+    /// `interned(root, result)` is invoked for every root of `other` with the equivalent root of
+    /// this forest. If it is a duplicate, the nodes of `root` remain allocated until `clear()`.
+    template <typename Callback>
+    void absorb(hash_forest&& other, Callback interned)
+    {
+        for (auto entry : other._roots.entries())
+        {
+            if (_roots.should_rehash())
+                rehash(2 * _roots.capacity());
+
+            // We re-use the cached hash.
+            auto key      = entry.get();
+            auto existing = _roots.lookup_entry(key);
+            if (existing)
+            {
+                interned(key.node, existing.get().node);
+            }
+            else
+            {
+                existing.create(key);
+                interned(key.node, key.node);
+            }
+        }
+
+        _arena.absorb(DRYAD_MOV(other._arena));
+        other._roots.free(other._arena.resource());
+    }
+    void absorb(hash_forest&& other)
+    {
+        absorb(DRYAD_MOV(other), [](RootNode*, RootNode*) {});
+    }
+
+    /// The memory used by the nodes.
+    arena_statistics memory_statistics() const
+    {
+        return _arena.statistics();
+    }
+    /// The memory resource the nodes and the hash table are allocated from.
+    MemoryResource* memory_resource() const
+    {
+        return _arena.resource().get();
+    }
+    /// The block size and growth strategy of the underlying arena.
+    std::size_t block_size() const
+    {
+        return _arena.block_size();
+    }
+    arena_growth growth() const
+    {
+        return _arena.growth();
+    }
 
     //=== hash table interface ===//
     void rehash(std::size_t new_capacity)
@@ -262,6 +362,14 @@ public:
         _roots.rehash(_arena.resource(), new_capacity);
     }
 
+    /// The interned roots in no particular order.
+    auto roots() const
+    {
+        auto entries = const_cast<hash_table&>(_roots).entries();
+        return make_node_range(root_iterator{{}, entries.begin()},
+                               root_iterator{{}, entries.end()});
+    }
+
     std::size_t root_count() const
     {
         return _roots.size();
@@ -270,8 +378,36 @@ public:
     {
         return _roots.capacity();
     }
+    /// The number of bytes allocated for the hash table of roots.
+    std::size_t root_allocated_bytes() const
+    {
+        return _roots.allocated_bytes();
+    }
+    /// The statistics of the hash table of roots.
+    hash_table_statistics root_table_statistics() const
+    {
+        return _roots.statistics();
+    }
 
 private:
+    struct root_iterator : _detail::forward_iterator_base<root_iterator, RootNode*, RootNode*, void>
+    {
+        typename hash_table::entry_range::iterator _cur;
+
+        RootNode* deref() const
+        {
+            return (*_cur).get().node;
+        }
+        void increment()
+        {
+            ++_cur;
+        }
+        bool equal(root_iterator rhs) const
+        {
+            return _cur == rhs._cur;
+        }
+    };
+
     arena<MemoryResource> _arena;
     hash_table            _roots;
 };
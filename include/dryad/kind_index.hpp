@@ -0,0 +1,254 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_KIND_INDEX_HPP_INCLUDED
+#define DRYAD_KIND_INDEX_HPP_INCLUDED
+
+#include <cstring>
+#include <dryad/_detail/config.hpp>
+#include <dryad/_detail/iterator.hpp>
+#include <dryad/_detail/memory_resource.hpp>
+#include <dryad/node.hpp>
+#include <dryad/tree.hpp>
+
+namespace dryad
+{
+/// Lists the nodes of (sub)trees grouped by their kind.
+///
+/// A pass that is only interested in a few kinds can iterate over their nodes without traversing
+/// the rest of the tree. The nodes of each kind are stored contiguously in pre-order. The index is
+/// built in two traversals, the first one counts the nodes of each kind, and has to be rebuilt
+/// when the tree is modified.
+template <typename NodeKind, typename MemoryResource = void>
+class kind_index
+{
+    using resource_ptr = _detail::memory_resource_ptr<MemoryResource>;
+    using node_type    = node<NodeKind>;
+    using traits       = node_kind_traits<NodeKind>;
+
+    struct iterator : _detail::forward_iterator_base<iterator, node_type*, node_type*, void>
+    {
+        node_type* const* _cur;
+
+        node_type* deref() const
+        {
+            return *_cur;
+        }
+        void increment()
+        {
+            ++_cur;
+        }
+        bool equal(iterator rhs) const
+        {
+            return _cur == rhs._cur;
+        }
+    };
+
+public:
+    //=== constructors ===//
+    constexpr kind_index()
+    : _nodes(nullptr), _size(0), _offsets(nullptr), _kind_count(0),
+      _resource(_detail::get_memory_resource<MemoryResource>())
+    {}
+    constexpr explicit kind_index(MemoryResource* resource)
+    : _nodes(nullptr), _size(0), _offsets(nullptr), _kind_count(0), _resource(resource)
+    {}
+
+    /// Indexes the tree rooted at `root`.
+    explicit kind_index(node_type* root) : kind_index()
+    {
+        rebuild(root);
+    }
+    template <typename RootNode, typename TreeMemoryResource>
+    explicit kind_index(tree<RootNode, TreeMemoryResource>& tree) : kind_index()
+    {
+        rebuild(tree);
+    }
+    template <typename RootNode, typename TreeMemoryResource>
+    explicit kind_index(forest<RootNode, TreeMemoryResource>& forest) : kind_index()
+    {
+        rebuild(forest);
+    }
+
+    ~kind_index()
+    {
+        clear();
+    }
+
+    kind_index(kind_index&& other) noexcept
+    : _nodes(other._nodes), _size(other._size), _offsets(other._offsets),
+      _kind_count(other._kind_count), _resource(other._resource)
+    {
+        other._nodes      = nullptr;
+        other._size       = 0;
+        other._offsets    = nullptr;
+        other._kind_count = 0;
+    }
+
+    kind_index& operator=(kind_index&& other) noexcept
+    {
+        _detail::swap(_nodes, other._nodes);
+        _detail::swap(_size, other._size);
+        _detail::swap(_offsets, other._offsets);
+        _detail::swap(_kind_count, other._kind_count);
+        _detail::swap(_resource, other._resource);
+        return *this;
+    }
+
+    //=== modifiers ===//
+    /// Replaces the indexed nodes by the nodes of the tree rooted at `root`.
+    void rebuild(node_type* root)
+    {
+        build([&](auto f) {
+            if (root != nullptr)
+                f(root);
+        });
+    }
+    template <typename RootNode, typename TreeMemoryResource>
+    void rebuild(tree<RootNode, TreeMemoryResource>& tree)
+    {
+        rebuild(tree.root());
+    }
+    /// Indexes the trees of all roots; the nodes of each kind are ordered by root.
+    template <typename RootNode, typename TreeMemoryResource>
+    void rebuild(forest<RootNode, TreeMemoryResource>& forest)
+    {
+        build([&](auto f) {
+            for (auto root : forest.roots())
+                f(root);
+        });
+    }
+
+    /// Removes all nodes and releases the memory.
+    void clear()
+    {
+        if (_size > 0)
+            _resource->deallocate(_nodes, _size * sizeof(node_type*), alignof(node_type*));
+        if (_kind_count > 0)
+            _resource->deallocate(_offsets, (_kind_count + 1) * sizeof(std::size_t),
+                                  alignof(std::size_t));
+
+        _nodes      = nullptr;
+        _size       = 0;
+        _offsets    = nullptr;
+        _kind_count = 0;
+    }
+
+    //=== access ===//
+    bool empty() const
+    {
+        return _size == 0;
+    }
+    /// The number of nodes of all kinds.
+    std::size_t size() const
+    {
+        return _size;
+    }
+    /// The number of bytes allocated from the memory resource.
+    std::size_t allocated_bytes() const
+    {
+        auto result = _size * sizeof(node_type*);
+        if (_kind_count > 0)
+            result += (_kind_count + 1) * sizeof(std::size_t);
+        return result;
+    }
+
+    /// The number of nodes of the kind.
+    std::size_t count(NodeKind kind) const
+    {
+        auto k = traits::to_int(kind);
+        return k < _kind_count ? _offsets[k + 1] - _offsets[k] : 0;
+    }
+
+    /// The nodes of the kind in pre-order.
+    auto nodes(NodeKind kind) const
+    {
+        auto k = traits::to_int(kind);
+        if (k >= _kind_count)
+            return make_node_range(iterator{{}, _nodes}, iterator{{}, _nodes});
+        return make_node_range(iterator{{}, _nodes + _offsets[k]},
+                               iterator{{}, _nodes + _offsets[k + 1]});
+    }
+
+private:
+    // Resizes the offsets for at least `kind_count` kinds; offsets of new kinds are zero.
+    void reserve_kinds(std::size_t kind_count)
+    {
+        auto new_count = kind_count < 2 * _kind_count ? 2 * _kind_count : kind_count;
+        auto new_offsets
+            = static_cast<std::size_t*>(_resource->allocate((new_count + 1) * sizeof(std::size_t),
+                                                            alignof(std::size_t)));
+        std::memset(new_offsets, 0, (new_count + 1) * sizeof(std::size_t));
+
+        if (_kind_count > 0)
+        {
+            std::memcpy(new_offsets, _offsets, (_kind_count + 1) * sizeof(std::size_t));
+            _resource->deallocate(_offsets, (_kind_count + 1) * sizeof(std::size_t),
+                                  alignof(std::size_t));
+        }
+
+        _offsets    = new_offsets;
+        _kind_count = new_count;
+    }
+
+    template <typename ForEachRoot>
+    void build(ForEachRoot for_each_root)
+    {
+        if (_size > 0)
+            _resource->deallocate(_nodes, _size * sizeof(node_type*), alignof(node_type*));
+        _nodes = nullptr;
+        _size  = 0;
+        if (_kind_count > 0)
+            std::memset(_offsets, 0, (_kind_count + 1) * sizeof(std::size_t));
+
+        // Count the nodes of each kind k in _offsets[k + 1].
+        for_each_root([&](node_type* root) {
+            for (auto [ev, n] : traverse(root))
+                if (ev != traverse_event::exit)
+                {
+                    auto k = traits::to_int(n->kind());
+                    if (k >= _kind_count)
+                        reserve_kinds(std::size_t(k) + 1);
+                    ++_offsets[k + 1];
+                    ++_size;
+                }
+        });
+        if (_size == 0)
+            return;
+
+        // Turn them into offsets, so the nodes of kind k begin at _offsets[k].
+        for (auto k = std::size_t(0); k != _kind_count; ++k)
+            _offsets[k + 1] += _offsets[k];
+
+        // Store the nodes, which moves the offset of kind k to the beginning of kind k + 1.
+        _nodes = static_cast<node_type**>(
+            _resource->allocate(_size * sizeof(node_type*), alignof(node_type*)));
+        for_each_root([&](node_type* root) {
+            for (auto [ev, n] : traverse(root))
+                if (ev != traverse_event::exit)
+                    _nodes[_offsets[traits::to_int(n->kind())]++] = n;
+        });
+        std::memmove(_offsets + 1, _offsets, _kind_count * sizeof(std::size_t));
+        _offsets[0] = 0;
+    }
+
+    node_type**                     _nodes;
+    std::size_t                     _size;
+    std::size_t*                    _offsets;
+    std::size_t                     _kind_count;
+    DRYAD_EMPTY_MEMBER resource_ptr _resource;
+};
+
+/// The nodes of type `T` in the index in pre-order, without traversing the tree.
+/// `T` must be a concrete node type.
+template <typename T, typename NodeKind, typename MemoryResource>
+auto nodes_of_kind(const kind_index<NodeKind, MemoryResource>& index)
+{
+    static_assert(is_node<T, NodeKind> && !is_abstract_node<T, NodeKind>);
+    auto range = index.nodes(T::kind());
+    return make_node_range<T>(range._begin, range._end);
+}
+} // namespace dryad
+
+#endif // DRYAD_KIND_INDEX_HPP_INCLUDED
+
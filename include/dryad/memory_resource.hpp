@@ -0,0 +1,267 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_MEMORY_RESOURCE_HPP_INCLUDED
+#define DRYAD_MEMORY_RESOURCE_HPP_INCLUDED
+
+#include <atomic>
+#include <climits>
+#include <dryad/_detail/assert.hpp>
+#include <dryad/_detail/config.hpp>
+#include <dryad/_detail/memory_resource.hpp>
+#include <dryad/arena.hpp>
+
+namespace dryad
+{
+/// A thread-safe memory resource that recycles blocks of `BlockSize` bytes.
+///
+/// The default matches `arena::default_block_size`, so trees, forests and arenas on different
+/// threads can share one pool and re-use each other's blocks without going through `operator new`.
+/// Allocating and deallocating a block is lock-free; other allocations are forwarded to
+/// `operator new`. Blocks are carved out of slabs, which are only freed by the destructor.
+template <std::size_t BlockSize = std::size_t(16) * 1024>
+class block_pool_resource
+{
+    static_assert(BlockSize > 0 && BlockSize % alignof(std::max_align_t) == 0);
+
+    // Slab n has (2^n * first_slab_size) blocks, so 29 slabs cover all 32 bit indices.
+    static constexpr auto first_slab_bits = 3u;
+    static constexpr auto slab_count      = 32u - first_slab_bits;
+
+    // The free list head stores the index of a block plus one in the lower half, and a tag to
+    // prevent ABA in the upper half. The links of the free list also store the index plus one.
+    static constexpr auto no_block = std::uint32_t(0);
+
+public:
+    static constexpr auto block_size = BlockSize;
+
+    //=== constructors/destructors ===//
+    block_pool_resource() noexcept : _slabs(), _free(0), _fresh(0) {}
+
+    block_pool_resource(const block_pool_resource&)            = delete;
+    block_pool_resource& operator=(const block_pool_resource&) = delete;
+
+    /// All memory allocated from the pool must have been deallocated.
+    ~block_pool_resource() noexcept
+    {
+        for (auto n = 0u; n != slab_count; ++n)
+            if (auto slab = _slabs[n].load(std::memory_order_relaxed))
+                _detail::default_memory_resource::deallocate(slab, slab_bytes(n),
+                                                             alignof(std::max_align_t));
+    }
+
+    //=== allocation ===//
+    void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        if (!is_block(bytes, alignment))
+            return _detail::default_memory_resource::allocate(bytes, alignment);
+
+        auto head = _free.load(std::memory_order_acquire);
+        while (std::uint32_t(head) != no_block)
+        {
+            auto index = std::uint32_t(head) - 1;
+            auto next  = link(index).load(std::memory_order_relaxed);
+            // The tag is incremented on every pop, so the CAS fails if the block was popped and
+            // pushed again in the meantime, even though the index is the same.
+            auto new_head = (((head >> 32) + 1) << 32) | next;
+            if (_free.compare_exchange_weak(head, new_head, std::memory_order_acquire,
+                                            std::memory_order_acquire))
+                return block(index);
+        }
+
+        // The free list is empty, so we need a block that has never been used.
+        auto index = _fresh.fetch_add(1, std::memory_order_relaxed);
+        DRYAD_PRECONDITION(index < slab_blocks(slab_count) - slab_blocks(0));
+        auto [n, offset] = locate(index);
+        return slab(n) + offset * BlockSize;
+    }
+
+    void deallocate(void* ptr, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        if (!is_block(bytes, alignment))
+        {
+            _detail::default_memory_resource::deallocate(ptr, bytes, alignment);
+            return;
+        }
+
+        auto index = index_of(static_cast<unsigned char*>(ptr));
+        auto head  = _free.load(std::memory_order_relaxed);
+        while (true)
+        {
+            link(index).store(std::uint32_t(head), std::memory_order_relaxed);
+            auto new_head = (head & ~std::uint64_t(UINT32_MAX)) | (index + 1);
+            if (_free.compare_exchange_weak(head, new_head, std::memory_order_release,
+                                            std::memory_order_relaxed))
+                break;
+        }
+    }
+
+    friend bool operator==(const block_pool_resource& lhs, const block_pool_resource& rhs) noexcept
+    {
+        return &lhs == &rhs;
+    }
+
+    /// The number of blocks that have been handed out at some point, i.e. the peak number of
+    /// blocks in use.
+    std::size_t block_count() const noexcept
+    {
+        return _fresh.load(std::memory_order_relaxed);
+    }
+
+private:
+    struct location
+    {
+        unsigned    slab;
+        std::size_t offset;
+    };
+
+    static constexpr bool is_block(std::size_t bytes, std::size_t alignment) noexcept
+    {
+        return bytes == BlockSize && alignment <= alignof(std::max_align_t);
+    }
+
+    static constexpr std::size_t slab_blocks(unsigned n)
+    {
+        return std::size_t(1) << (first_slab_bits + n);
+    }
+    // The blocks are followed by the links of the free list, so a link is never written while
+    // the block is in use.
+    static constexpr std::size_t slab_bytes(unsigned n)
+    {
+        return slab_blocks(n) * (BlockSize + sizeof(std::atomic<std::uint32_t>));
+    }
+
+    static location locate(std::uint32_t index)
+    {
+        // Slab n starts at index (2^n - 1) * first_slab_size.
+        auto biased = static_cast<unsigned long long>(index) + (1ull << first_slab_bits);
+        auto n      = unsigned(int(sizeof(biased) * CHAR_BIT) - 1 - __builtin_clzll(biased))
+                 - first_slab_bits;
+        return {n, std::size_t(biased - (1ull << (first_slab_bits + n)))};
+    }
+
+    unsigned char* slab(unsigned n)
+    {
+        auto result = _slabs[n].load(std::memory_order_acquire);
+        if (result != nullptr)
+            return result;
+
+        // Multiple threads can get fresh blocks of the same slab, only one of them installs it.
+        auto new_slab = static_cast<unsigned char*>(
+            _detail::default_memory_resource::allocate(slab_bytes(n), alignof(std::max_align_t)));
+        auto links = new_slab + slab_blocks(n) * BlockSize;
+        for (auto i = std::size_t(0); i != slab_blocks(n); ++i)
+            ::new (links + i * sizeof(std::atomic<std::uint32_t>)) std::atomic<std::uint32_t>(no_block);
+        if (_slabs[n].compare_exchange_strong(result, new_slab, std::memory_order_acq_rel,
+                                              std::memory_order_acquire))
+            return new_slab;
+
+        _detail::default_memory_resource::deallocate(new_slab, slab_bytes(n),
+                                                     alignof(std::max_align_t));
+        return result;
+    }
+
+    unsigned char* block(std::uint32_t index)
+    {
+        auto [n, offset] = locate(index);
+        return _slabs[n].load(std::memory_order_relaxed) + offset * BlockSize;
+    }
+    std::atomic<std::uint32_t>& link(std::uint32_t index)
+    {
+        auto [n, offset] = locate(index);
+        auto links       = _slabs[n].load(std::memory_order_relaxed) + slab_blocks(n) * BlockSize;
+        return reinterpret_cast<std::atomic<std::uint32_t>*>(links)[offset];
+    }
+
+    std::uint32_t index_of(unsigned char* ptr)
+    {
+        for (auto n = 0u; n != slab_count; ++n)
+        {
+            auto slab = _slabs[n].load(std::memory_order_relaxed);
+            if (slab != nullptr && slab <= ptr && ptr < slab + slab_blocks(n) * BlockSize)
+            {
+                auto offset = std::size_t(ptr - slab) / BlockSize;
+                return std::uint32_t((slab_blocks(n) - slab_blocks(0)) + offset);
+            }
+        }
+
+        DRYAD_PRECONDITION(false); // ptr wasn't allocated from the pool
+        return 0;
+    }
+
+    std::atomic<unsigned char*> _slabs[slab_count];
+    std::atomic<std::uint64_t>  _free;
+    std::atomic<std::uint32_t>  _fresh;
+};
+
+/// A memory resource that allocates from a caller-supplied buffer, e.g. one on the stack.
+///
+/// Allocation bumps a pointer; deallocation is a no-op, unless it was the latest allocation, and
+/// the memory is only re-used after `release()`. Once the buffer is exhausted, it falls back to
+/// `operator new`. It is not thread-safe.
+class monotonic_buffer_resource
+{
+public:
+    //=== constructors ===//
+    explicit monotonic_buffer_resource(void* buffer, std::size_t size) noexcept
+    : _begin(static_cast<unsigned char*>(buffer)), _cur(_begin), _end(_begin + size)
+    {}
+
+    template <std::size_t N>
+    explicit monotonic_buffer_resource(unsigned char (&buffer)[N]) noexcept
+    : monotonic_buffer_resource(buffer, N)
+    {}
+
+    monotonic_buffer_resource(const monotonic_buffer_resource&)            = delete;
+    monotonic_buffer_resource& operator=(const monotonic_buffer_resource&) = delete;
+
+    //=== allocation ===//
+    void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        auto offset = _detail::align_offset(_cur, alignment);
+        if (offset + bytes > std::size_t(_end - _cur))
+            return _detail::default_memory_resource::allocate(bytes, alignment);
+
+        auto result = _cur + offset;
+        _cur        = result + bytes;
+        return result;
+    }
+
+    void deallocate(void* ptr, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        auto memory = static_cast<unsigned char*>(ptr);
+        if (memory < _begin || memory >= _end)
+            _detail::default_memory_resource::deallocate(ptr, bytes, alignment);
+        else if (memory + bytes == _cur)
+            // Growing a container often frees the latest allocation, so we can re-use it.
+            _cur = memory;
+    }
+
+    friend bool operator==(const monotonic_buffer_resource& lhs,
+                           const monotonic_buffer_resource& rhs) noexcept
+    {
+        return &lhs == &rhs;
+    }
+
+    /// Makes the entire buffer available again.
+    /// All memory allocated from the buffer must no longer be used.
+    void release() noexcept
+    {
+        _cur = _begin;
+    }
+
+    /// The number of bytes of the buffer that are in use, including alignment padding.
+    std::size_t bytes_used() const noexcept
+    {
+        return std::size_t(_cur - _begin);
+    }
+
+private:
+    unsigned char* _begin;
+    unsigned char* _cur;
+    unsigned char* _end;
+};
+} // namespace dryad
+
+#endif // DRYAD_MEMORY_RESOURCE_HPP_INCLUDED
+
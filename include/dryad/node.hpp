@@ -7,6 +7,7 @@
 #include <dryad/_detail/assert.hpp>
 #include <dryad/_detail/config.hpp>
 #include <dryad/_detail/iterator.hpp>
+#include <utility>
 
 namespace dryad
 {
@@ -60,6 +61,11 @@ template <typename T, typename NodeKind>
 constexpr bool is_node = std::is_base_of_v<node<NodeKind>, T>;
 template <typename T, typename NodeKind>
 constexpr bool is_abstract_node = is_node<T, NodeKind>&& T::type_is_abstract();
+
+/// Specialize to `true` to allow `number_nodes()` on the nodes of that kind.
+/// It stores the id in their `user_data32`, so `DRYAD_ATTRIBUTE_USER_DATA32` can't be used then.
+template <typename NodeKind>
+constexpr bool enable_node_numbering = false;
 } // namespace dryad
 
 namespace dryad
@@ -378,6 +384,9 @@ private:
     // 3 bits for alignment: cct
     // * cc: color
     // * t: 0 if sibling, 1 if parent
+    //
+    // The links are full pointers and not offsets: the arena consists of independently allocated
+    // blocks that can be arbitrarily far apart, and a node doesn't know the arena it lives in.
     std::uintptr_t _ptr;
     bool           _is_container : 1;
     std::uint16_t  _kind : 15;
@@ -393,10 +402,18 @@ private:
     friend class tree;
     template <typename, typename>
     friend class forest;
-    template <typename, typename, typename>
+    template <typename, typename, typename, typename, typename>
     friend class hash_forest;
     template <typename>
     friend class _traverse_range;
+    template <typename>
+    friend struct _node_copier;
+    template <typename>
+    friend struct _snapshot;
+    template <typename>
+    friend struct _node_numbering;
+    template <typename, typename>
+    friend class tree_builder;
     template <typename NK>
     friend void leak_node(node<NK>* n);
 };
@@ -461,8 +478,11 @@ protected:
     }                                                                                              \
     void user_data16() = delete
 
+// Not available if `enable_node_numbering` is set, as `number_nodes()` overwrites it.
 #define DRYAD_ATTRIBUTE_USER_DATA32(T, Name)                                                       \
     static_assert(sizeof(T) <= sizeof(std::uint32_t));                                             \
+    static_assert(!::dryad::enable_node_numbering<typename node_base::node_kind_type>,             \
+                  "user_data32 stores the id assigned by number_nodes()");                         \
     T Name() const                                                                                 \
     {                                                                                              \
         return static_cast<T>(node_base::user_data32());                                           \
@@ -954,6 +974,40 @@ struct _node_types_for_lambdas<Ptr, Tail...>
 
 template <typename... Lambdas>
 using node_types_for_lambdas = typename _node_types_for_lambdas<&Lambdas::operator()...>::type;
+
+// With that many node types, visitors dispatch using a table indexed by the node kind instead of
+// checking each node type in turn.
+constexpr auto dispatch_table_min_types = 8u;
+// Limits the size of the table for big node kind values.
+constexpr auto dispatch_table_max_size = 1024u;
+
+template <typename NodeKind, typename T>
+constexpr int concrete_node_kind()
+{
+    if constexpr (is_abstract_node<T, NodeKind>)
+        return -1;
+    else
+        return node_kind_traits<NodeKind>::to_int(T::kind());
+}
+
+// The number of entries in the table, zero if it shouldn't use one.
+// Node kinds that don't have an entry use the linear search as fallback.
+template <typename NodeKind, typename... NodeTypes>
+constexpr std::size_t dispatch_table_size()
+{
+    if (sizeof...(NodeTypes) < dispatch_table_min_types)
+        return 0;
+
+    auto max_kind = -1;
+    ((max_kind = concrete_node_kind<NodeKind, NodeTypes>() > max_kind
+                     ? concrete_node_kind<NodeKind, NodeTypes>()
+                     : max_kind),
+     ...);
+    if (max_kind < 0 || std::size_t(max_kind) >= dispatch_table_max_size)
+        return 0;
+    else
+        return std::size_t(max_kind) + 1;
+}
 } // namespace dryad::_detail
 
 namespace dryad
@@ -964,14 +1018,57 @@ template <typename... NodeTypes, typename... Lambdas>
 struct _visit_node<_detail::node_type_list<NodeTypes...>, Lambdas...>
 {
     template <typename Node>
-    DRYAD_FORCE_INLINE static void visit(Node* node, Lambdas&&... lambdas)
+    DRYAD_FORCE_INLINE static void visit_kind(typename Node::node_kind_type kind, Node* node,
+                                              std::remove_reference_t<Lambdas>&... lambdas)
     {
-        auto                  kind = node->kind();
         [[maybe_unused]] auto found_callback
             = ((NodeTypes::type_matches_kind(kind) ? (lambdas(static_cast<NodeTypes*>(node)), true)
                                                    : false)
                || ...);
     }
+
+    // The kind is a constant, so only the matching lambda remains.
+    // The lambdas are passed type-erased, as passing many references is expensive.
+    template <std::uint16_t Kind, typename Node, std::size_t... Idx>
+    static void visit_as(Node* node, void* const* lambdas)
+    {
+        using traits = node_kind_traits<typename Node::node_kind_type>;
+        visit_kind(traits::from_int(Kind), node,
+                   *static_cast<std::remove_reference_t<Lambdas>*>(lambdas[Idx])...);
+    }
+
+    template <typename Node, std::uint16_t... Kinds, std::size_t... Idx>
+    DRYAD_FORCE_INLINE static void visit_table(std::integer_sequence<std::uint16_t, Kinds...>,
+                                               std::index_sequence<Idx...>, Node* node,
+                                               std::remove_reference_t<Lambdas>&... lambdas)
+    {
+        using traits = node_kind_traits<typename Node::node_kind_type>;
+        using fn     = void (*)(Node*, void* const*);
+        static constexpr fn table[] = {&visit_as<Kinds, Node, Idx...>...};
+
+        auto kind = traits::to_int(node->kind());
+        if (kind < sizeof...(Kinds))
+        {
+            void* ptrs[] = {const_cast<void*>(static_cast<const void*>(&lambdas))...};
+            table[kind](node, ptrs);
+        }
+        else
+        {
+            visit_kind(node->kind(), node, lambdas...);
+        }
+    }
+
+    template <typename Node>
+    DRYAD_FORCE_INLINE static void visit(Node* node, Lambdas&&... lambdas)
+    {
+        constexpr auto table_size
+            = _detail::dispatch_table_size<typename Node::node_kind_type, NodeTypes...>();
+        if constexpr (table_size > 0)
+            visit_table(std::make_integer_sequence<std::uint16_t, table_size>{},
+                        std::index_sequence_for<Lambdas...>{}, node, lambdas...);
+        else
+            visit_kind(node->kind(), node, lambdas...);
+    }
 };
 
 template <typename NodeTypeList, typename... Lambdas>
@@ -980,9 +1077,10 @@ template <typename H, typename... T, typename HLambda, typename... TLambda>
 struct _visit_node_all<_detail::node_type_list<H, T...>, HLambda, TLambda...>
 {
     template <typename Node>
-    DRYAD_FORCE_INLINE static auto visit(Node* node, HLambda&& head, TLambda&&... tail)
+    DRYAD_FORCE_INLINE static auto visit_kind(typename Node::node_kind_type kind, Node* node,
+                                              std::remove_reference_t<HLambda>& head,
+                                              std::remove_reference_t<TLambda>&... tail)
     {
-        auto kind = node->kind();
         if constexpr (sizeof...(T) == 0)
         {
             DRYAD_ASSERT(H::type_matches_kind(kind), "missing visitor");
@@ -993,9 +1091,60 @@ struct _visit_node_all<_detail::node_type_list<H, T...>, HLambda, TLambda...>
             return H::type_matches_kind(kind)
                        ? head(static_cast<H*>(node))
                        : _visit_node_all<_detail::node_type_list<T...>,
-                                         TLambda...>::visit(node, DRYAD_FWD(tail)...);
+                                         TLambda...>::visit_kind(kind, node, tail...);
         }
     }
+
+    template <typename Node>
+    using result_type = decltype(visit_kind(DRYAD_DECLVAL(typename Node::node_kind_type),
+                                            DRYAD_DECLVAL(Node*),
+                                            DRYAD_DECLVAL(std::remove_reference_t<HLambda>&),
+                                            DRYAD_DECLVAL(std::remove_reference_t<TLambda>&)...));
+
+    // Same as in _visit_node.
+    template <std::uint16_t Kind, typename Node, std::size_t... Idx>
+    static result_type<Node> visit_as(Node* node, void* const* lambdas)
+    {
+        using traits = node_kind_traits<typename Node::node_kind_type>;
+        return visit_kind(traits::from_int(Kind), node,
+                          *static_cast<std::remove_reference_t<HLambda>*>(lambdas[0]),
+                          *static_cast<std::remove_reference_t<TLambda>*>(lambdas[Idx + 1])...);
+    }
+
+    template <typename Node, std::uint16_t... Kinds, std::size_t... Idx>
+    DRYAD_FORCE_INLINE static auto visit_table(std::integer_sequence<std::uint16_t, Kinds...>,
+                                               std::index_sequence<Idx...>, Node* node,
+                                               std::remove_reference_t<HLambda>& head,
+                                               std::remove_reference_t<TLambda>&... tail)
+    {
+        using traits = node_kind_traits<typename Node::node_kind_type>;
+        using fn     = result_type<Node> (*)(Node*, void* const*);
+        static constexpr fn table[] = {&visit_as<Kinds, Node, Idx...>...};
+
+        auto kind = traits::to_int(node->kind());
+        if (kind < sizeof...(Kinds))
+        {
+            void* ptrs[] = {const_cast<void*>(static_cast<const void*>(&head)),
+                            const_cast<void*>(static_cast<const void*>(&tail))...};
+            return table[kind](node, ptrs);
+        }
+        else
+        {
+            return visit_kind(node->kind(), node, head, tail...);
+        }
+    }
+
+    template <typename Node>
+    DRYAD_FORCE_INLINE static auto visit(Node* node, HLambda&& head, TLambda&&... tail)
+    {
+        constexpr auto table_size
+            = _detail::dispatch_table_size<typename Node::node_kind_type, H, T...>();
+        if constexpr (table_size > 0)
+            return visit_table(std::make_integer_sequence<std::uint16_t, table_size>{},
+                               std::index_sequence_for<TLambda...>{}, node, head, tail...);
+        else
+            return visit_kind(node->kind(), node, head, tail...);
+    }
 };
 
 /// Visits the node invoking the appropriate lambda for each node type.
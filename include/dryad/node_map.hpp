@@ -7,11 +7,12 @@
 #include <cstring>
 #include <dryad/_detail/config.hpp>
 #include <dryad/_detail/hash_table.hpp>
+#include <dryad/_detail/small_table.hpp>
 #include <dryad/node.hpp>
 
 namespace dryad::_detail
 {
-template <typename NodeType>
+template <typename NodeType, typename HashAlgorithm>
 struct node_hash_traits
 {
     using value_type = NodeType*;
@@ -22,11 +23,6 @@ struct node_hash_traits
         return bits == 0 || bits == std::uintptr_t(-1);
     }
 
-    static void fill_removed(value_type* data, size_t size)
-    {
-        std::memset(data, static_cast<unsigned char>(-1), size * sizeof(value_type));
-    }
-
     static void fill_unoccupied(value_type* data, size_t size)
     {
         std::memset(data, static_cast<unsigned char>(0), size * sizeof(value_type));
@@ -44,9 +40,12 @@ struct node_hash_traits
     static std::size_t hash(std::remove_const_t<NodeType>* value)
     {
         auto bits = reinterpret_cast<std::uintptr_t>(value);
-        // We just remove the alignment bits (which are always zero), and use the rest as-is.
-        // If benchmarks show bad performance, we might reconsider it.
-        return bits >> 3;
+        if constexpr (std::is_void_v<HashAlgorithm>)
+            // We just remove the alignment bits (which are always zero), and use the rest as-is.
+            // If benchmarks show bad performance, we might reconsider it.
+            return bits >> 3;
+        else
+            return static_cast<std::size_t>(HashAlgorithm().hash_scalar(bits).finish());
     }
     static std::size_t hash(const NodeType* key)
     {
@@ -60,23 +59,56 @@ namespace dryad
 struct _node_map_void
 {};
 
+template <typename Value, std::size_t Capacity>
+struct _node_map_small_values
+{
+    alignas(Value) unsigned char storage[Capacity * sizeof(Value)];
+
+    Value* data()
+    {
+        return reinterpret_cast<Value*>(storage);
+    }
+};
+
 /// Maps pointers to `NodeType` (which may be `const`) to `Value` (which may be `void`).
-template <typename NodeType, typename Value, typename MemoryResource = void>
+///
+/// If `HashAlgorithm` is `void`, the address of the node is used as hash directly.
+/// Otherwise, the address is hashed using the specified algorithm.
+///
+/// If `Value` is `void` or trivially copyable, the first `small_capacity` entries are stored inline
+/// and searched linearly; the hash table is only allocated once there are more. `Probing` is its
+/// strategy, either `linear_probing` or `group_probing`.
+template <typename NodeType, typename Value, typename MemoryResource = void,
+          typename HashAlgorithm = void, typename Probing = linear_probing>
 class node_map
 {
     using resource_ptr = _detail::memory_resource_ptr<MemoryResource>;
-    using traits       = _detail::node_hash_traits<NodeType>;
-    using hash_table   = _detail::hash_table<traits, 64>;
+    using traits       = _detail::node_hash_traits<NodeType, HashAlgorithm>;
+    using hash_table   = _detail::hash_table<traits, 64, Probing>;
 
     using value_array = std::conditional_t<std::is_void_v<Value>, _node_map_void, Value*>;
 
+    // The inline values are moved around as bytes.
+    static constexpr std::size_t _small_capacity
+        = std::is_void_v<Value> || std::is_trivially_copyable_v<Value> ? 8 : 0;
+    using small_table        = _detail::small_table<NodeType*, _small_capacity>;
+    using small_value_buffer = std::conditional_t<std::is_void_v<Value> || _small_capacity == 0,
+                                                  _node_map_void,
+                                                  _node_map_small_values<Value, _small_capacity>>;
+
 public:
     using key_type    = NodeType*;
     using mapped_type = Value;
 
+    static constexpr auto small_capacity = _small_capacity;
+
     //=== constructors ===//
-    constexpr node_map() : _values(), _resource(_detail::get_memory_resource<MemoryResource>()) {}
-    constexpr explicit node_map(MemoryResource* resource) : _values(), _resource(resource) {}
+    constexpr node_map()
+    : _small_values(), _values(), _resource(_detail::get_memory_resource<MemoryResource>())
+    {}
+    constexpr explicit node_map(MemoryResource* resource)
+    : _small_values(), _values(), _resource(resource)
+    {}
 
     ~node_map()
     {
@@ -92,14 +124,18 @@ public:
     }
 
     node_map(node_map&& other) noexcept
-    : _table(other._table), _values(other._values), _resource(other._resource)
+    : _small(other._small), _small_values(other._small_values), _table(other._table),
+      _values(other._values), _resource(other._resource)
     {
+        other._small.clear();
         other._table  = {};
         other._values = {};
     }
 
     node_map& operator=(node_map&& other) noexcept
     {
+        _detail::swap(_small, other._small);
+        _detail::swap(_small_values, other._small_values);
         _detail::swap(_table, other._table);
         _detail::swap(_values, other._values);
         _detail::swap(_resource, other._resource);
@@ -109,16 +145,30 @@ public:
     //=== access ===//
     bool empty() const
     {
-        return _table.size() == 0;
+        return size() == 0;
     }
     std::size_t size() const
     {
-        return _table.size();
+        return _small.size() + _table.size();
     }
+    /// The capacity of the hash table, which is zero while the entries are stored inline.
     std::size_t capacity() const
     {
         return _table.capacity();
     }
+    /// The number of bytes allocated from the memory resource.
+    std::size_t allocated_bytes() const
+    {
+        if constexpr (std::is_void_v<Value>)
+            return _table.allocated_bytes();
+        else
+            return _table.allocated_bytes() + _table.capacity() * sizeof(Value);
+    }
+    /// The statistics of the hash table, which doesn't include the inline entries.
+    hash_table_statistics table_statistics() const
+    {
+        return _table.statistics(traits{});
+    }
 
     //=== entry_handle ===//
     class entry_handle
@@ -126,7 +176,10 @@ public:
     public:
         explicit operator bool() const
         {
-            return static_cast<bool>(_entry);
+            if (_small != nullptr)
+                return _small_idx != _small->size();
+            else
+                return static_cast<bool>(_entry);
         }
 
         NodeType* node() const
@@ -137,36 +190,64 @@ public:
         decltype(auto) value() const
         {
             DRYAD_PRECONDITION(*this);
-            return _values[_entry.index()];
+            return _values[index()];
         }
 
         template <typename... Args>
         decltype(auto) insert(Args&&... args)
         {
             DRYAD_PRECONDITION(!*this);
-            _entry.create(_key);
+            if (_small != nullptr)
+                _small_idx = _small->push_back(_key);
+            else
+                _entry.create(_key);
             if constexpr (!std::is_void_v<Value>)
-                return *::new (&_values[_entry.index()]) Value(DRYAD_FWD(args)...);
+                return *::new (&_values[index()]) Value(DRYAD_FWD(args)...);
         }
 
         template <typename... Args>
         decltype(auto) update(Args&&... args) const
         {
             DRYAD_PRECONDITION(*this);
-            return _values[_entry.index()] = Value(DRYAD_FWD(args)...);
+            return _values[index()] = Value(DRYAD_FWD(args)...);
         }
 
         void remove()
         {
             DRYAD_PRECONDITION(*this);
             if constexpr (!std::is_void_v<Value>)
-                _values[_entry.index()].~Value();
-            _entry.remove();
+                _values[index()].~Value();
+
+            if (_small != nullptr)
+            {
+                _small->erase(_small_idx);
+                if constexpr (!std::is_void_v<Value>)
+                    if (_small_idx != _small->size())
+                        // The value is trivially copyable, so this is a destructive move.
+                        ::new (&_values[_small_idx]) Value(DRYAD_MOV(_values[_small->size()]));
+                _small_idx = _small->size();
+            }
+            else
+            {
+                auto values = _values;
+                _entry.erase(
+                    [values](std::size_t old_idx, std::size_t new_idx) {
+                        move_value(values, old_idx, new_idx);
+                    },
+                    traits{});
+            }
+        }
+
+        std::size_t index() const
+        {
+            return _small != nullptr ? _small_idx : _entry.index();
         }
 
         typename hash_table::entry_handle _entry;
         DRYAD_EMPTY_MEMBER value_array    _values;
         NodeType*                         _key;
+        small_table*                      _small; // non-null while the map is in small mode
+        std::size_t                       _small_idx;
     };
 
     //=== modifiers ===//
@@ -174,7 +255,8 @@ public:
     {
         new_capacity  = _table.to_table_capacity(new_capacity);
         auto capacity = _table.capacity();
-        if (new_capacity <= capacity)
+        // Rehashing at the same capacity drops removed slots of the table.
+        if (new_capacity < capacity || (new_capacity == capacity && _table.removed() == 0))
             return;
 
         if constexpr (std::is_void_v<Value>)
@@ -198,19 +280,38 @@ public:
 
             _values = new_values;
         }
+
+        // Move the inline entries into the hash table; it is used from now on.
+        for (auto i = std::size_t(0); i != _small.size(); ++i)
+        {
+            auto entry = _table.lookup_entry(_small[i], traits{});
+            entry.create(_small[i]);
+            if constexpr (!std::is_void_v<Value>)
+                ::new (&_values[entry.index()]) Value(DRYAD_MOV(small_values()[i]));
+        }
+        _small.clear();
     }
 
     entry_handle lookup_entry(NodeType* node)
     {
+        if (_table.capacity() == 0)
+        {
+            auto idx = _small.find(node);
+            if (idx != _small.size() || !_small.full())
+                return {{}, small_values(), node, &_small, idx};
+        }
+
         if (_table.should_rehash())
-            rehash(2 * _table.capacity());
+            rehash(_table.next_capacity());
 
-        return {_table.lookup_entry(node, traits{}), _values, node};
+        return {_table.lookup_entry(node, traits{}), _values, node, nullptr, 0};
     }
 
     bool contains(const NodeType* node)
     {
-        if (empty())
+        if (_table.capacity() == 0)
+            return _small.find(node) != _small.size();
+        else if (_table.size() == 0)
             return false;
 
         auto entry = _table.lookup_entry(node, traits{});
@@ -219,7 +320,12 @@ public:
 
     Value* lookup(const NodeType* node)
     {
-        if (empty())
+        if (_table.capacity() == 0)
+        {
+            auto idx = _small.find(node);
+            return idx != _small.size() ? &small_values()[idx] : nullptr;
+        }
+        else if (_table.size() == 0)
             return nullptr;
 
         auto entry = _table.lookup_entry(node, traits{});
@@ -266,14 +372,79 @@ public:
         return true;
     }
 
+    /// Removes all entries for which `pred(node, value)` returns true, or `pred(node)` if `Value` is
+    /// `void`. Every entry is visited exactly once. Returns the number of removed entries.
+    template <typename Predicate>
+    std::size_t remove_if(Predicate pred)
+    {
+        auto old_size = size();
+        auto matches  = [&](NodeType* node, value_array values, std::size_t idx) {
+            if constexpr (std::is_void_v<Value>)
+                return static_cast<bool>(pred(node));
+            else
+                return static_cast<bool>(pred(node, values[idx]));
+        };
+
+        for (auto idx = std::size_t(0); idx != _small.size();)
+            if (matches(_small[idx], small_values(), idx))
+                // The last entry is moved into its place, so check the index again.
+                entry_handle{{}, small_values(), _small[idx], &_small, idx}.remove();
+            else
+                ++idx;
+
+        auto values = _values;
+        _table.erase_if(
+            [&](auto entry) {
+                if (!matches(entry.get(), values, entry.index()))
+                    return false;
+
+                if constexpr (!std::is_void_v<Value>)
+                    values[entry.index()].~Value();
+                return true;
+            },
+            [values](std::size_t old_idx, std::size_t new_idx) {
+                move_value(values, old_idx, new_idx);
+            },
+            traits{});
+
+        return old_size - size();
+    }
+
 private:
-    hash_table                      _table;
-    DRYAD_EMPTY_MEMBER value_array  _values; // shares key index
-    DRYAD_EMPTY_MEMBER resource_ptr _resource;
+    // Does a destructive move of the value, as its entry has moved.
+    static void move_value(value_array values, std::size_t old_idx, std::size_t new_idx)
+    {
+        if constexpr (!std::is_void_v<Value>)
+        {
+            ::new (&values[new_idx]) Value(DRYAD_MOV(values[old_idx]));
+            values[old_idx].~Value();
+        }
+        else
+        {
+            (void)values;
+            (void)old_idx;
+            (void)new_idx;
+        }
+    }
+
+    value_array small_values()
+    {
+        if constexpr (std::is_same_v<small_value_buffer, _node_map_void>)
+            return {};
+        else
+            return _small_values.data();
+    }
+
+    small_table                           _small; // only used while the hash table is not allocated
+    DRYAD_EMPTY_MEMBER small_value_buffer _small_values; // shares key index
+    hash_table                            _table;
+    DRYAD_EMPTY_MEMBER value_array        _values; // shares key index
+    DRYAD_EMPTY_MEMBER resource_ptr       _resource;
 };
 
-template <typename NodeType, typename MemoryResource = void>
-using node_set = node_map<NodeType, void, MemoryResource>;
+template <typename NodeType, typename MemoryResource = void, typename HashAlgorithm = void,
+          typename Probing = linear_probing>
+using node_set = node_map<NodeType, void, MemoryResource, HashAlgorithm, Probing>;
 } // namespace dryad
 
 #endif // DRYAD_NODE_MAP_HPP_INCLUDED
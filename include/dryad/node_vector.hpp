@@ -0,0 +1,214 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_NODE_VECTOR_HPP_INCLUDED
+#define DRYAD_NODE_VECTOR_HPP_INCLUDED
+
+#include <dryad/_detail/config.hpp>
+#include <dryad/_detail/memory_resource.hpp>
+#include <dryad/node.hpp>
+#include <dryad/tree.hpp>
+#include <new>
+
+namespace dryad
+{
+template <typename NodeKind>
+struct _node_numbering
+{
+    static_assert(enable_node_numbering<NodeKind>,
+                  "number_nodes() overwrites user_data32, opt in with enable_node_numbering");
+
+    static std::uint32_t get(const node<NodeKind>* n)
+    {
+        return n->_user_data32;
+    }
+
+    static std::uint32_t number(node<NodeKind>* root, std::uint32_t next_id)
+    {
+        for (auto [ev, n] : traverse(root))
+            if (ev != traverse_event::exit)
+            {
+                // The returned id needs to be representable as well.
+                DRYAD_PRECONDITION(next_id != UINT32_MAX);
+                n->_user_data32 = next_id++;
+            }
+        return next_id;
+    }
+};
+
+/// Assigns every node of the tree rooted at `root` a dense id in pre-order, starting at
+/// `first_id`. Returns one past the last id assigned, i.e. the size of a `node_vector` for them.
+///
+/// The id is stored in the `user_data32` of the node, so the node kind has to opt in by
+/// specializing `enable_node_numbering`, which disables `DRYAD_ATTRIBUTE_USER_DATA32`.
+/// The numbering stays valid until the tree is modified; it is shared by all `node_vector`s.
+template <typename NodeKind>
+std::uint32_t number_nodes(node<NodeKind>* root, std::uint32_t first_id = 0)
+{
+    return _node_numbering<NodeKind>::number(root, first_id);
+}
+template <typename RootNode, typename MemoryResource>
+std::uint32_t number_nodes(tree<RootNode, MemoryResource>& tree, std::uint32_t first_id = 0)
+{
+    if (!tree.has_root())
+        return first_id;
+    return number_nodes(tree.root(), first_id);
+}
+/// Numbers the trees of all roots consecutively in order.
+template <typename RootNode, typename MemoryResource>
+std::uint32_t number_nodes(forest<RootNode, MemoryResource>& forest, std::uint32_t first_id = 0)
+{
+    for (auto root : forest.roots())
+        first_id = number_nodes(root, first_id);
+    return first_id;
+}
+
+/// The id assigned to the node by `number_nodes()`.
+template <typename NodeKind>
+std::uint32_t node_id(const node<NodeKind>* n)
+{
+    return _node_numbering<NodeKind>::get(n);
+}
+} // namespace dryad
+
+namespace dryad
+{
+/// Maps nodes numbered by `number_nodes()` to `Value`.
+///
+/// The id of the node is used as index into an array, so access is constant time without hashing.
+/// Unlike a `node_map`, it contains a default constructed value for every id less than `size()`.
+template <typename NodeType, typename Value, typename MemoryResource = void>
+class node_vector
+{
+    using resource_ptr = _detail::memory_resource_ptr<MemoryResource>;
+
+public:
+    using key_type    = NodeType*;
+    using mapped_type = Value;
+
+    //=== constructors ===//
+    constexpr node_vector()
+    : _data(nullptr), _size(0), _resource(_detail::get_memory_resource<MemoryResource>())
+    {}
+    constexpr explicit node_vector(MemoryResource* resource)
+    : _data(nullptr), _size(0), _resource(resource)
+    {}
+
+    /// Creates values for all ids less than `size`, usually the result of `number_nodes()`.
+    explicit node_vector(std::size_t size) : node_vector()
+    {
+        resize(size);
+    }
+    explicit node_vector(MemoryResource* resource, std::size_t size) : node_vector(resource)
+    {
+        resize(size);
+    }
+
+    ~node_vector()
+    {
+        clear();
+    }
+
+    node_vector(node_vector&& other) noexcept
+    : _data(other._data), _size(other._size), _resource(other._resource)
+    {
+        other._data = nullptr;
+        other._size = 0;
+    }
+
+    node_vector& operator=(node_vector&& other) noexcept
+    {
+        _detail::swap(_data, other._data);
+        _detail::swap(_size, other._size);
+        _detail::swap(_resource, other._resource);
+        return *this;
+    }
+
+    //=== access ===//
+    bool empty() const
+    {
+        return _size == 0;
+    }
+    std::size_t size() const
+    {
+        return _size;
+    }
+    /// The number of bytes allocated from the memory resource.
+    std::size_t allocated_bytes() const
+    {
+        return _size * sizeof(Value);
+    }
+
+    /// The value of the node, whose id must be less than `size()`.
+    Value& operator[](const NodeType* n)
+    {
+        auto id = node_id(n);
+        DRYAD_PRECONDITION(id < _size);
+        return _data[id];
+    }
+    const Value& operator[](const NodeType* n) const
+    {
+        auto id = node_id(n);
+        DRYAD_PRECONDITION(id < _size);
+        return _data[id];
+    }
+
+    /// The values ordered by id.
+    Value* data()
+    {
+        return _data;
+    }
+    const Value* data() const
+    {
+        return _data;
+    }
+
+    //=== modifiers ===//
+    /// Keeps the values of ids less than `new_size`; new values are default constructed.
+    void resize(std::size_t new_size)
+    {
+        if (new_size == _size)
+            return;
+
+        Value* new_data = nullptr;
+        if (new_size > 0)
+        {
+            new_data = static_cast<Value*>(
+                _resource->allocate(new_size * sizeof(Value), alignof(Value)));
+
+            auto kept = new_size < _size ? new_size : _size;
+            for (auto i = std::size_t(0); i != kept; ++i)
+                ::new (&new_data[i]) Value(DRYAD_MOV(_data[i]));
+            for (auto i = kept; i != new_size; ++i)
+                ::new (&new_data[i]) Value();
+        }
+
+        clear();
+        _data = new_data;
+        _size = new_size;
+    }
+
+    /// Destroys all values and releases the memory.
+    void clear()
+    {
+        if (_size == 0)
+            return;
+
+        if constexpr (!std::is_trivially_destructible_v<Value>)
+            for (auto i = std::size_t(0); i != _size; ++i)
+                _data[i].~Value();
+        _resource->deallocate(_data, _size * sizeof(Value), alignof(Value));
+
+        _data = nullptr;
+        _size = 0;
+    }
+
+private:
+    Value*                          _data;
+    std::size_t                     _size;
+    DRYAD_EMPTY_MEMBER resource_ptr _resource;
+};
+} // namespace dryad
+
+#endif // DRYAD_NODE_VECTOR_HPP_INCLUDED
+
@@ -0,0 +1,90 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_PARALLEL_BUILD_HPP_INCLUDED
+#define DRYAD_PARALLEL_BUILD_HPP_INCLUDED
+
+#include <dryad/_detail/config.hpp>
+#include <dryad/_detail/memory_resource.hpp>
+#include <dryad/arena.hpp>
+#include <dryad/hash_forest.hpp>
+#include <dryad/parallel_visit.hpp>
+#include <dryad/tree.hpp>
+#include <new>
+
+namespace dryad
+{
+template <typename Forest, typename Executor, typename Builder, typename Merge>
+void _parallel_build(Forest& forest, std::size_t task_count, Executor& executor,
+                     Builder& builder, Merge merge)
+{
+    if (task_count == 0)
+        return;
+
+    // Every task gets its own forest, so the threads share nothing but the memory resource;
+    // it allocates its blocks like the target forest.
+    using resource_type = std::remove_pointer_t<decltype(forest.memory_resource())>;
+    auto memory         = _detail::memory_resource_ptr<resource_type>(forest.memory_resource());
+    auto parts          = static_cast<Forest*>(
+        memory->allocate(task_count * sizeof(Forest), alignof(Forest)));
+    for (auto i = std::size_t(0); i != task_count; ++i)
+        ::new (&parts[i]) Forest(forest.memory_resource(), forest.block_size(), forest.growth());
+
+    executor(task_count, [&](std::size_t i) { builder(parts[i], i); });
+
+    for (auto i = std::size_t(0); i != task_count; ++i)
+    {
+        merge(parts[i], i);
+        parts[i].~Forest();
+    }
+    memory->deallocate(parts, task_count * sizeof(Forest), alignof(Forest));
+}
+
+/// Builds roots of a `forest` in parallel.
+///
+/// `builder(part, i)` is invoked for every `i` in `[0, task_count)` using the executor. It creates
+/// nodes and inserts roots into `part`, a forest that is only used by that task. Afterwards, the
+/// roots of all parts are appended in the order of their tasks; their nodes are taken over without
+/// copying them. The memory resource of the forest has to be thread-safe.
+///
+/// Every task allocates at least one arena block, so a task should build more than a tiny root.
+template <typename RootNode, typename MemoryResource, typename Executor, typename Builder>
+void parallel_build(forest<RootNode, MemoryResource>& forest, std::size_t task_count,
+                    Executor&& executor, Builder&& builder)
+{
+    using forest_type = dryad::forest<RootNode, MemoryResource>;
+    _parallel_build(forest, task_count, executor, builder,
+                    [&](forest_type& part, std::size_t) { forest.absorb(DRYAD_MOV(part)); });
+}
+
+/// Builds roots of a `hash_forest` in parallel.
+///
+/// Same as the overload for `forest`, but every part is a `hash_forest`, so identical roots of a
+/// task are interned right away. The roots of the parts are then interned into `forest` in the
+/// order of their tasks, re-using the hashes computed by the tasks. `interned(i, root, result)` is
+/// invoked for every root of task `i` with the equivalent root of `forest`.
+template <typename RootNode, typename NodeHasher, typename MemoryResource, typename HashAlgorithm,
+          typename Probing, typename Executor, typename Builder, typename Callback>
+void parallel_build(
+    hash_forest<RootNode, NodeHasher, MemoryResource, HashAlgorithm, Probing>& forest,
+    std::size_t task_count, Executor&& executor, Builder&& builder, Callback interned)
+{
+    using forest_type = hash_forest<RootNode, NodeHasher, MemoryResource, HashAlgorithm, Probing>;
+    _parallel_build(forest, task_count, executor, builder, [&](forest_type& part, std::size_t i) {
+        forest.absorb(DRYAD_MOV(part),
+                      [&](RootNode* root, RootNode* result) { interned(i, root, result); });
+    });
+}
+template <typename RootNode, typename NodeHasher, typename MemoryResource, typename HashAlgorithm,
+          typename Probing, typename Executor, typename Builder>
+void parallel_build(
+    hash_forest<RootNode, NodeHasher, MemoryResource, HashAlgorithm, Probing>& forest,
+    std::size_t task_count, Executor&& executor, Builder&& builder)
+{
+    parallel_build(forest, task_count, executor, builder,
+                   [](std::size_t, RootNode*, RootNode*) {});
+}
+} // namespace dryad
+
+#endif // DRYAD_PARALLEL_BUILD_HPP_INCLUDED
+
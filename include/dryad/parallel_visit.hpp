@@ -0,0 +1,157 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_PARALLEL_VISIT_HPP_INCLUDED
+#define DRYAD_PARALLEL_VISIT_HPP_INCLUDED
+
+#include <atomic>
+#include <dryad/_detail/config.hpp>
+#include <dryad/_detail/memory_resource.hpp>
+#include <dryad/node.hpp>
+#include <dryad/tree.hpp>
+#include <memory>
+#include <system_error>
+#include <thread>
+
+#if 0
+struct Executor
+{
+    // Invokes `task(i)` for every `i` in `[0, task_count)` exactly once, possibly concurrently.
+    // Returns once all of them have finished.
+    template <typename Task>
+    void operator()(std::size_t task_count, Task task);
+};
+#endif
+
+namespace dryad
+{
+/// Executes all tasks on the calling thread.
+struct sequential_executor
+{
+    template <typename Task>
+    void operator()(std::size_t task_count, Task task) const
+    {
+        for (auto i = std::size_t(0); i != task_count; ++i)
+            task(i);
+    }
+};
+
+/// Executes the tasks on threads that are started for each call.
+/// A thread that is done with its task takes the next one, so the work is balanced automatically
+/// even if the tasks have very different sizes. Tasks must not throw.
+///
+/// If a thread can't be started, the threads that are running and the calling thread do the work.
+class thread_executor
+{
+public:
+    /// Uses one thread per hardware thread.
+    thread_executor() : thread_executor(std::thread::hardware_concurrency()) {}
+    explicit thread_executor(unsigned thread_count)
+    : _thread_count(thread_count == 0 ? 1 : thread_count)
+    {}
+
+    unsigned thread_count() const
+    {
+        return _thread_count;
+    }
+
+    template <typename Task>
+    void operator()(std::size_t task_count, Task task) const
+    {
+        std::atomic<std::size_t> next_task(0);
+        auto                     worker = [&] {
+            while (true)
+            {
+                auto i = next_task.fetch_add(1, std::memory_order_relaxed);
+                if (i >= task_count)
+                    break;
+                task(i);
+            }
+        };
+
+        // The calling thread is one of the workers.
+        auto helper_count = (task_count < _thread_count ? task_count : _thread_count) - 1;
+        if (helper_count == 0)
+        {
+            worker();
+            return;
+        }
+
+        auto helpers = std::unique_ptr<std::thread[]>(new std::thread[helper_count]);
+        auto started = std::size_t(0);
+        try
+        {
+            for (; started != helper_count; ++started)
+                helpers[started] = std::thread(worker);
+        }
+        catch (const std::system_error&)
+        {
+            // The workers take the tasks of the missing ones.
+        }
+        worker();
+        for (auto i = std::size_t(0); i != started; ++i)
+            helpers[i].join();
+    }
+
+private:
+    unsigned _thread_count;
+};
+} // namespace dryad
+
+namespace dryad
+{
+template <typename NodePtr, typename MemoryResource, typename NodeRange, typename Executor,
+          typename... Lambdas>
+void _parallel_visit(const NodeRange& nodes, MemoryResource* resource, Executor& executor,
+                     Lambdas&... lambdas)
+{
+    auto count = std::size_t(0);
+    for (auto iter = nodes.begin(); iter != nodes.end(); ++iter)
+        ++count;
+    if (count == 0)
+        return;
+
+    // The executor needs random access to the nodes.
+    auto memory = _detail::memory_resource_ptr<MemoryResource>(resource);
+    auto array
+        = static_cast<NodePtr*>(memory->allocate(count * sizeof(NodePtr), alignof(NodePtr)));
+    auto cur = array;
+    for (auto n : nodes)
+        *cur++ = n;
+
+    executor(count, [&](std::size_t i) { visit_tree(array[i], lambdas...); });
+    memory->deallocate(array, count * sizeof(NodePtr), alignof(NodePtr));
+}
+
+/// Visits the trees of all roots of a `forest` or `hash_forest` in parallel.
+///
+/// It is equivalent to calling `visit_tree()` for each root, but the calls are distributed using
+/// the executor. All calls share the lambdas, so they need to be thread-safe.
+template <typename Forest, typename Executor, typename... Lambdas>
+void parallel_visit_tree(Forest& forest, Executor&& executor, Lambdas&&... lambdas)
+{
+    using root_node = std::remove_pointer_t<decltype(*forest.roots().begin())>;
+    using node_ptr  = std::conditional_t<std::is_const_v<Forest>, const root_node*, root_node*>;
+    _parallel_visit<node_ptr>(forest.roots(), forest.memory_resource(), executor, lambdas...);
+}
+
+/// Visits the trees of all children of `node` in parallel, but not `node` itself.
+///
+/// Use it to split up big trees, e.g. by passing the container of all top-level declarations.
+template <typename NodeKind, typename Executor, typename... Lambdas>
+void parallel_visit_children(node<NodeKind>* node, Executor&& executor, Lambdas&&... lambdas)
+{
+    _parallel_visit<dryad::node<NodeKind>*, void>(node->children(), nullptr, executor,
+                                                  lambdas...);
+}
+template <typename NodeKind, typename Executor, typename... Lambdas>
+void parallel_visit_children(const node<NodeKind>* node, Executor&& executor,
+                             Lambdas&&... lambdas)
+{
+    _parallel_visit<const dryad::node<NodeKind>*, void>(node->children(), nullptr, executor,
+                                                        lambdas...);
+}
+} // namespace dryad
+
+#endif // DRYAD_PARALLEL_VISIT_HPP_INCLUDED
+
@@ -0,0 +1,99 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_PARENT_INDEX_HPP_INCLUDED
+#define DRYAD_PARENT_INDEX_HPP_INCLUDED
+
+#include <dryad/_detail/config.hpp>
+#include <dryad/node.hpp>
+#include <dryad/node_map.hpp>
+#include <dryad/tree.hpp>
+
+namespace dryad
+{
+/// Maps every node of a (sub)tree to its parent in constant time.
+///
+/// `node::parent()` follows the sibling links until it reaches the parent, which is linear in the
+/// number of siblings after the node. The index is built once in a single traversal and has to be
+/// rebuilt when the tree is modified.
+template <typename NodeKind, typename MemoryResource = void>
+class parent_index
+{
+    using map = node_map<const node<NodeKind>, const node<NodeKind>*, MemoryResource>;
+
+public:
+    //=== constructors ===//
+    parent_index() = default;
+    explicit parent_index(MemoryResource* resource) : _parents(resource) {}
+
+    /// Indexes the tree rooted at `root`.
+    explicit parent_index(const node<NodeKind>* root) : parent_index()
+    {
+        insert(root);
+    }
+    template <typename RootNode, typename TreeMemoryResource>
+    explicit parent_index(const tree<RootNode, TreeMemoryResource>& tree) : parent_index()
+    {
+        insert(tree.root());
+    }
+
+    //=== modifiers ===//
+    /// Adds all nodes of the tree rooted at `root`.
+    /// The parent of `root` is the one returned by `root->parent()`.
+    void insert(const node<NodeKind>* root)
+    {
+        if (root == nullptr)
+            return;
+
+        _parents.insert_or_update(root, root->parent());
+        for (auto [ev, n] : dryad::traverse(root))
+            if (ev == traverse_event::enter)
+                for (auto child : n->children())
+                    _parents.insert_or_update(child, n);
+    }
+
+    void rehash(std::size_t new_capacity)
+    {
+        _parents.rehash(new_capacity);
+    }
+
+    //=== access ===//
+    bool empty() const
+    {
+        return _parents.empty();
+    }
+    std::size_t size() const
+    {
+        return _parents.size();
+    }
+    /// The number of bytes allocated from the memory resource.
+    std::size_t allocated_bytes() const
+    {
+        return _parents.allocated_bytes();
+    }
+
+    bool contains(const node<NodeKind>* n) const
+    {
+        return _parents.lookup(n) != nullptr;
+    }
+
+    /// Same as `n->parent()`, but constant time.
+    /// `n` must be part of an indexed tree.
+    const node<NodeKind>* parent(const node<NodeKind>* n) const
+    {
+        auto result = _parents.lookup(n);
+        DRYAD_PRECONDITION(result != nullptr);
+        return *result;
+    }
+    node<NodeKind>* parent(node<NodeKind>* n) const
+    {
+        return const_cast<node<NodeKind>*>(parent(static_cast<const node<NodeKind>*>(n)));
+    }
+
+private:
+    map _parents;
+};
+} // namespace dryad
+
+#endif // DRYAD_PARENT_INDEX_HPP_INCLUDED
+
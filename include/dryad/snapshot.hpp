@@ -0,0 +1,446 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_SNAPSHOT_HPP_INCLUDED
+#define DRYAD_SNAPSHOT_HPP_INCLUDED
+
+#include <cstdint>
+#include <cstring>
+#include <dryad/_detail/config.hpp>
+#include <dryad/hash_algorithm.hpp>
+#include <dryad/node.hpp>
+#include <dryad/tree.hpp>
+#include <new>
+
+// A snapshot is a single contiguous image of the nodes of a tree or forest:
+//
+// * A header with a magic number, the format version, a fingerprint of the node layout, the size
+//   of the image, and the number of roots.
+// * The offsets of all roots from the beginning of the image.
+// * The nodes of each root in pre-order, each one aligned for the most aligned node type.
+//
+// The nodes are stored bytewise, except that the links to siblings, parents, and the first child
+// are offsets from the beginning of the image instead of pointers, combined with the same tag bits.
+// As nodes are never at offset zero, it is still used for null.
+// Loading requires a single linear relocation pass that turns the offsets back into pointers;
+// the image can then be used in place, e.g. after mapping a file into memory copy-on-write.
+//
+// Only the node data itself is stored, so nodes must not store pointers as user data.
+// Store indices instead, e.g. symbols of a `symbol_interner`, which can be dumped alongside.
+// The image is only portable between programs that use the same node types and ABI.
+
+namespace dryad
+{
+template <typename NodeKind>
+struct _snapshot
+{
+    using node_type = node<NodeKind>;
+
+    static constexpr std::uint32_t magic   = 0x64'72'79'64; // "dryd"
+    static constexpr std::uint32_t version = 1;
+
+    struct header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t layout;
+        std::uint64_t size;
+        std::uint64_t root_count;
+    };
+
+    template <typename... NodeTypes>
+    static constexpr std::size_t alignment()
+    {
+        auto result = alignof(header);
+        ((result = alignof(NodeTypes) > result ? alignof(NodeTypes) : result), ...);
+        return result;
+    }
+
+    static constexpr std::size_t align_up(std::size_t offset, std::size_t alignment)
+    {
+        return (offset + alignment - 1) & ~(alignment - 1);
+    }
+
+    // Fingerprint of everything that determines the bytes of the nodes.
+    template <typename... NodeTypes>
+    static std::uint64_t layout()
+    {
+        default_hash_algorithm hasher;
+        hasher.hash_scalar(sizeof(void*));
+        hasher.hash_scalar(sizeof(node_type));
+        (hasher.hash_scalar(node_kind_traits<NodeKind>::to_int(NodeTypes::kind()))
+             .hash_scalar(sizeof(NodeTypes))
+             .hash_scalar(alignof(NodeTypes)),
+         ...);
+        return DRYAD_MOV(hasher).finish();
+    }
+
+    template <typename... NodeTypes>
+    static std::size_t header_size(std::size_t root_count)
+    {
+        return align_up(sizeof(header) + root_count * sizeof(std::uint64_t),
+                        alignment<NodeTypes...>());
+    }
+
+    // Returns zero if the type of the node is not specified.
+    template <typename... NodeTypes>
+    static std::size_t node_size(const node_type* n)
+    {
+        static_assert(((!is_abstract_node<NodeTypes, NodeKind>)&&...),
+                      "need the concrete node types");
+        static_assert((std::is_trivially_copyable_v<NodeTypes> && ...),
+                      "nodes are stored bytewise");
+
+        auto result = std::size_t(0);
+        (void)((node_has_kind<NodeTypes>(n) && (result = sizeof(NodeTypes), true)) || ...);
+        return result;
+    }
+
+    static node_type* at(unsigned char* image, std::uintptr_t offset)
+    {
+        return std::launder(reinterpret_cast<node_type*>(image + offset));
+    }
+
+    // The root of a tree as range, which is empty if it doesn't have one.
+    struct tree_root
+    {
+        const node_type* root;
+
+        const node_type* const* begin() const
+        {
+            return &root;
+        }
+        const node_type* const* end() const
+        {
+            return root == nullptr ? &root : &root + 1;
+        }
+    };
+
+    //=== writing ===//
+    template <typename... NodeTypes, typename RootRange>
+    static std::size_t size(const RootRange& roots)
+    {
+        auto root_count = std::size_t(0);
+        auto nodes_size = std::size_t(0);
+        for (auto root : roots)
+        {
+            ++root_count;
+            for (auto [ev, n] : traverse(root))
+                if (ev != traverse_event::exit)
+                    nodes_size += align_up(node_size<NodeTypes...>(n), alignment<NodeTypes...>());
+        }
+        return header_size<NodeTypes...>(root_count) + nodes_size;
+    }
+
+    // Writes the tree of root starting at pos, returns the offset of the root.
+    template <typename... NodeTypes>
+    static std::uintptr_t write_tree(unsigned char* image, std::size_t image_size,
+                                     std::size_t& pos, const node_type* root)
+    {
+        std::uintptr_t result = 0;
+        std::uintptr_t parent = 0; // offset of the container whose children we're writing
+        std::uintptr_t last   = 0; // offset of the last child of parent written so far
+        for (auto [ev, cur] : traverse(root))
+        {
+            if (ev == traverse_event::exit)
+            {
+                // The last child points to its parent already.
+                last   = parent;
+                parent = at(image, parent)->_ptr & ~std::uintptr_t(0b111);
+                continue;
+            }
+
+            auto size = node_size<NodeTypes...>(cur);
+            DRYAD_PRECONDITION(size > 0);                 // type of node not specified
+            DRYAD_PRECONDITION(pos + size <= image_size); // buffer too small
+            auto offset = std::uintptr_t(pos);
+            std::memcpy(image + offset, static_cast<const void*>(cur), size);
+            pos = align_up(pos + size, alignment<NodeTypes...>());
+
+            auto copy   = at(image, offset);
+            auto color  = cur->_ptr & 0b110;
+            copy->_ptr  = (parent == 0 ? offset : parent) | color | 0b1;
+            if (copy->_is_container)
+                copy->_user_data_ptr = nullptr;
+
+            if (parent == 0)
+                result = offset;
+            else if (last == 0)
+                at(image, parent)->_user_data_ptr = reinterpret_cast<void*>(offset);
+            else
+                at(image, last)->_ptr = offset | (at(image, last)->_ptr & 0b110);
+
+            if (ev == traverse_event::enter)
+            {
+                parent = offset;
+                last   = 0;
+            }
+            else
+            {
+                last = offset;
+            }
+        }
+        return result;
+    }
+
+    template <typename... NodeTypes, typename RootRange>
+    static std::size_t write(const RootRange& roots, void* buffer, std::size_t buffer_size)
+    {
+        DRYAD_PRECONDITION(reinterpret_cast<std::uintptr_t>(buffer) % alignment<NodeTypes...>()
+                           == 0);
+        auto image = static_cast<unsigned char*>(buffer);
+
+        auto root_count = std::size_t(0);
+        for (auto iter = roots.begin(); iter != roots.end(); ++iter)
+            ++root_count;
+
+        auto pos = header_size<NodeTypes...>(root_count);
+        DRYAD_PRECONDITION(pos <= buffer_size);
+        auto root_offsets = image + sizeof(header);
+        for (const node_type* root : roots)
+        {
+            auto offset = std::uint64_t(write_tree<NodeTypes...>(image, buffer_size, pos, root));
+            std::memcpy(root_offsets, &offset, sizeof(offset));
+            root_offsets += sizeof(offset);
+        }
+        std::memset(root_offsets, 0, std::size_t(image + header_size<NodeTypes...>(root_count)
+                                                 - root_offsets));
+
+        auto h = header{magic, version, layout<NodeTypes...>(), pos, root_count};
+        std::memcpy(image, &h, sizeof(h));
+        return pos;
+    }
+
+    //=== loading ===//
+    // Relocates the image in place, returns the number of roots or -1 if the image is invalid.
+    template <typename RootNode, typename... NodeTypes>
+    static std::size_t relocate(void* data, std::size_t size)
+    {
+        constexpr auto align = alignment<NodeTypes...>();
+        DRYAD_PRECONDITION(reinterpret_cast<std::uintptr_t>(data) % align == 0);
+        auto image = static_cast<unsigned char*>(data);
+
+        header h;
+        if (size < sizeof(h))
+            return std::size_t(-1);
+        std::memcpy(&h, image, sizeof(h));
+        if (h.magic != magic || h.version != version || h.layout != layout<NodeTypes...>()
+            || h.size != size || h.root_count > (size - sizeof(h)) / sizeof(std::uint64_t))
+            return std::size_t(-1);
+
+        auto nodes_begin   = header_size<NodeTypes...>(std::size_t(h.root_count));
+        auto is_valid_node = [&](std::uintptr_t offset) {
+            return offset >= nodes_begin && offset % align == 0 && offset < size
+                   && size - offset >= sizeof(node_type);
+        };
+        auto base = reinterpret_cast<std::uintptr_t>(image);
+
+        for (auto pos = nodes_begin; pos < size;)
+        {
+            if (size - pos < sizeof(node_type))
+                return std::size_t(-1);
+
+            auto n         = at(image, pos);
+            auto node_size = _snapshot::node_size<NodeTypes...>(n);
+            if (node_size == 0 || node_size > size - pos)
+                return std::size_t(-1);
+
+            auto next = n->_ptr & ~std::uintptr_t(0b111);
+            if (!is_valid_node(next))
+                return std::size_t(-1);
+            n->_ptr = (base + next) | (n->_ptr & 0b111);
+
+            if (n->_is_container && n->_user_data_ptr != nullptr)
+            {
+                auto first_child = reinterpret_cast<std::uintptr_t>(n->_user_data_ptr);
+                if (!is_valid_node(first_child))
+                    return std::size_t(-1);
+                n->_user_data_ptr = reinterpret_cast<void*>(base + first_child);
+            }
+
+            pos = align_up(pos + node_size, align);
+        }
+
+        for (auto idx = std::size_t(0); idx != h.root_count; ++idx)
+        {
+            std::uint64_t offset;
+            std::memcpy(&offset, image + sizeof(h) + idx * sizeof(offset), sizeof(offset));
+            if (!is_valid_node(std::uintptr_t(offset)))
+                return std::size_t(-1);
+
+            auto root = at(image, std::uintptr_t(offset));
+            if (root->next_node() != root || !root->next_node_is_parent()
+                || !node_has_kind<RootNode>(root))
+                return std::size_t(-1);
+        }
+
+        return std::size_t(h.root_count);
+    }
+
+    template <typename RootNode>
+    static RootNode* root(void* data, std::size_t idx)
+    {
+        std::uint64_t offset;
+        std::memcpy(&offset, static_cast<unsigned char*>(data) + sizeof(header)
+                                 + idx * sizeof(offset),
+                    sizeof(offset));
+        return static_cast<RootNode*>(at(static_cast<unsigned char*>(data), offset));
+    }
+
+    // Copies the image into the arena of the tree or forest, relocates it,
+    // and passes the unlinked roots to the callback.
+    template <typename RootNode, typename... NodeTypes, typename Container, typename Callback>
+    static bool load(Container& container, const void* data, std::size_t size, Callback callback)
+    {
+        auto& arena  = container._arena;
+        auto  marker = arena.top();
+        auto  memory = arena.allocate(size, alignment<NodeTypes...>());
+        std::memcpy(memory, data, size);
+
+        auto root_count = relocate<RootNode, NodeTypes...>(memory, size);
+        if (root_count == std::size_t(-1))
+        {
+            arena.unwind(marker);
+            return false;
+        }
+
+        unlinked_node_list<RootNode> roots;
+        for (auto idx = std::size_t(0); idx != root_count; ++idx)
+        {
+            auto root = _snapshot::root<RootNode>(memory, idx);
+            root->unlink();
+            roots.push_back(root);
+        }
+        if (!callback(DRYAD_MOV(roots), root_count))
+        {
+            arena.unwind(marker);
+            return false;
+        }
+        return true;
+    }
+};
+} // namespace dryad
+
+namespace dryad
+{
+/// The roots of a snapshot that has been relocated in place.
+/// It does not own the memory of the snapshot.
+template <typename RootNode>
+class snapshot_view
+{
+public:
+    /// An invalid view.
+    snapshot_view() : _data(nullptr), _root_count(0) {}
+
+    explicit operator bool() const
+    {
+        return _data != nullptr;
+    }
+
+    std::size_t root_count() const
+    {
+        return _root_count;
+    }
+
+    RootNode* root(std::size_t idx) const
+    {
+        DRYAD_PRECONDITION(idx < _root_count);
+        return _snapshot<typename RootNode::node_kind_type>::template root<RootNode>(_data, idx);
+    }
+
+private:
+    snapshot_view(void* data, std::size_t root_count) : _data(data), _root_count(root_count) {}
+
+    void*       _data;
+    std::size_t _root_count;
+
+    template <typename NodeType, typename... NodeTypes>
+    friend snapshot_view<NodeType> relocate_snapshot(void* data, std::size_t size);
+};
+
+/// The number of bytes required to write a snapshot of the tree.
+/// `NodeTypes` must list the concrete type of every node in the tree.
+template <typename... NodeTypes, typename RootNode, typename MemoryResource>
+std::size_t snapshot_size(const tree<RootNode, MemoryResource>& tree)
+{
+    using snapshot = _snapshot<typename RootNode::node_kind_type>;
+    return snapshot::template size<NodeTypes...>(typename snapshot::tree_root{tree.root()});
+}
+template <typename... NodeTypes, typename RootNode, typename MemoryResource>
+std::size_t snapshot_size(const forest<RootNode, MemoryResource>& forest)
+{
+    using snapshot = _snapshot<typename RootNode::node_kind_type>;
+    return snapshot::template size<NodeTypes...>(forest.roots());
+}
+
+/// Writes a snapshot of the tree into `buffer`, which needs `snapshot_size()` bytes aligned for all
+/// node types; a page aligned buffer is always fine.
+/// Returns the number of bytes written.
+template <typename... NodeTypes, typename RootNode, typename MemoryResource>
+std::size_t write_snapshot(const tree<RootNode, MemoryResource>& tree, void* buffer,
+                           std::size_t buffer_size)
+{
+    using snapshot = _snapshot<typename RootNode::node_kind_type>;
+    return snapshot::template write<NodeTypes...>(typename snapshot::tree_root{tree.root()},
+                                                  buffer, buffer_size);
+}
+template <typename... NodeTypes, typename RootNode, typename MemoryResource>
+std::size_t write_snapshot(const forest<RootNode, MemoryResource>& forest, void* buffer,
+                           std::size_t buffer_size)
+{
+    using snapshot = _snapshot<typename RootNode::node_kind_type>;
+    return snapshot::template write<NodeTypes...>(forest.roots(), buffer, buffer_size);
+}
+
+/// Turns the snapshot stored in `data` into usable nodes in place, without copying.
+///
+/// It is a single linear pass over the image, `data` must be writable; for a memory mapped file,
+/// map it copy-on-write. Returns an invalid view if the snapshot has been written with different
+/// node types or is corrupted, in which case the contents of `data` are unspecified.
+/// It checks that all links stay within the image, but trusts the tree structure.
+template <typename RootNode, typename... NodeTypes>
+snapshot_view<RootNode> relocate_snapshot(void* data, std::size_t size)
+{
+    using snapshot  = _snapshot<typename RootNode::node_kind_type>;
+    auto root_count = snapshot::template relocate<RootNode, NodeTypes...>(data, size);
+    if (root_count == std::size_t(-1))
+        return {};
+    return snapshot_view<RootNode>(data, root_count);
+}
+
+/// Replaces the tree by a copy of the snapshot, which is loaded into a single block of the tree's
+/// memory. Returns `false` if the snapshot is invalid or has multiple roots; the tree is empty
+/// then.
+template <typename... NodeTypes, typename RootNode, typename MemoryResource>
+bool load_snapshot(tree<RootNode, MemoryResource>& tree, const void* data, std::size_t size)
+{
+    using snapshot = _snapshot<typename RootNode::node_kind_type>;
+
+    tree.clear();
+    return snapshot::template load<RootNode, NodeTypes...>(
+        tree, data, size, [&](unlinked_node_list<RootNode>&& roots, std::size_t root_count) {
+            if (root_count > 1)
+                return false;
+
+            if (root_count == 1)
+                tree.set_root(roots.front());
+            return true;
+        });
+}
+/// Same as above, but for a forest; the roots of the snapshot are appended to the ones of the
+/// forest.
+template <typename... NodeTypes, typename RootNode, typename MemoryResource>
+bool load_snapshot(forest<RootNode, MemoryResource>& forest, const void* data, std::size_t size)
+{
+    using snapshot = _snapshot<typename RootNode::node_kind_type>;
+    return snapshot::template load<RootNode, NodeTypes...>(
+        forest, data, size, [&](unlinked_node_list<RootNode>&& roots, std::size_t) {
+            if (!roots.empty())
+                forest.insert_root_list(DRYAD_MOV(roots));
+            return true;
+        });
+}
+} // namespace dryad
+
+#endif // DRYAD_SNAPSHOT_HPP_INCLUDED
+
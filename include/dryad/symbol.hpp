@@ -13,20 +13,19 @@ namespace dryad::_detail
 {
 // Contains all unique symbols, null-terminated, in memory one after the other.
 template <typename CharT>
-class symbol_buffer
+class contiguous_symbol_buffer
 {
     static constexpr auto min_buffer_size = 16 * 1024;
 
 public:
-    constexpr symbol_buffer() : _data(nullptr), _size(0), _capacity(0) {}
+    constexpr contiguous_symbol_buffer() : _data(nullptr), _size(0), _capacity(0) {}
 
     template <typename ResourcePtr>
     void free(ResourcePtr resource)
     {
-        if (_capacity == 0)
-            return;
-
-        resource->deallocate(_data, _capacity * sizeof(CharT), alignof(CharT));
+        // If the memory has been adopted, the capacity is zero.
+        if (_capacity > 0)
+            resource->deallocate(_data, _capacity * sizeof(CharT), alignof(CharT));
         _data     = nullptr;
         _size     = 0;
         _capacity = 0;
@@ -85,73 +84,584 @@ public:
         return _data + index;
     }
 
+    /// The index of the next string; all indices are less than that.
+    std::size_t size() const
+    {
+        return _size;
+    }
+    /// Copies the characters of all indices into the buffer, which needs `size()` characters.
+    void copy_to(CharT* buffer) const
+    {
+        if (_size > 0)
+            std::memcpy(buffer, _data, _size * sizeof(CharT));
+    }
+
+    /// Replaces all strings by a copy of the result of `copy_to()`.
+    template <typename ResourcePtr>
+    void assign(ResourcePtr resource, const CharT* data, std::size_t size)
+    {
+        _size = 0;
+        reserve(resource, size);
+        if (size > 0)
+            std::memcpy(_data, data, size * sizeof(CharT));
+        _size = size;
+    }
+
+    /// Same as `assign()`, but uses the memory directly without copying it.
+    /// It is never written to or freed, new strings are stored in new memory.
+    template <typename ResourcePtr>
+    void adopt(ResourcePtr resource, const CharT* data, std::size_t size)
+    {
+        free(resource);
+        // With a capacity of zero, the next string copies everything into our own memory.
+        _data = const_cast<CharT*>(data);
+        _size = size;
+    }
+
+    std::size_t allocated_bytes() const
+    {
+        return _capacity * sizeof(CharT);
+    }
+
 private:
     CharT*      _data;
     std::size_t _size;
     std::size_t _capacity;
 };
 
-template <typename IndexType, typename CharT>
+// Contains all unique symbols, null-terminated, in chunks that are never moved.
+//
+// An index is the position in the sequence of all chunks, so the upper bits select the chunk.
+// Strings that don't fit into a chunk get multiple consecutive chunks that are allocated together.
+// A string never crosses the boundary between separate allocations, it starts the next one
+// instead.
+template <typename CharT>
+class chunked_symbol_buffer
+{
+    static constexpr auto chunk_bits = 14u;
+    static constexpr auto chunk_size = std::size_t(1) << chunk_bits;
+
+    struct chunk
+    {
+        CharT*      data;
+        std::size_t allocated; // number of chunks allocated together starting with this one
+    };
+
+public:
+    constexpr chunked_symbol_buffer()
+    : _chunks(nullptr), _chunk_count(0), _chunk_capacity(0), _size(0), _capacity(0),
+      _allocated_bytes(0)
+    {}
+
+    template <typename ResourcePtr>
+    void free(ResourcePtr resource)
+    {
+        for (auto idx = std::size_t(0); idx != _chunk_count; ++idx)
+            if (_chunks[idx].allocated > 0)
+                resource->deallocate(_chunks[idx].data,
+                                     _chunks[idx].allocated * chunk_size * sizeof(CharT),
+                                     alignof(CharT));
+        if (_chunk_capacity > 0)
+            resource->deallocate(_chunks, _chunk_capacity * sizeof(chunk), alignof(chunk));
+
+        _chunks          = nullptr;
+        _chunk_count     = 0;
+        _chunk_capacity  = 0;
+        _size            = 0;
+        _capacity        = 0;
+        _allocated_bytes = 0;
+    }
+
+    template <typename ResourcePtr>
+    void reserve(ResourcePtr resource, std::size_t new_capacity)
+    {
+        if (new_capacity <= _capacity)
+            return;
+
+        allocate_chunks(resource, new_capacity - _size);
+    }
+
+    template <typename ResourcePtr>
+    void reserve_new_string(ResourcePtr resource, std::size_t new_string_length)
+    {
+        // +1 for null-terminator.
+        if (_size + new_string_length + 1 <= _capacity)
+            return;
+
+        allocate_chunks(resource, new_string_length + 1);
+    }
+
+    std::size_t insert(const CharT* str, std::size_t length)
+    {
+        DRYAD_PRECONDITION(_capacity - _size >= length + 1);
+
+        auto index = _size;
+        auto ptr   = pointer(index);
+
+        std::memcpy(ptr, str, length * sizeof(CharT));
+        ptr[length] = CharT(0);
+        _size += length + 1;
+
+        return index;
+    }
+
+    const CharT* c_str(std::size_t index) const
+    {
+        DRYAD_PRECONDITION(index < _size);
+        return pointer(index);
+    }
+
+    /// The index of the next string; all indices are less than that.
+    std::size_t size() const
+    {
+        return _size;
+    }
+    /// Copies the characters of all indices into the buffer, which needs `size()` characters.
+    /// The unused end of chunks is filled with zeroes.
+    void copy_to(CharT* buffer) const
+    {
+        for (auto idx = std::size_t(0); idx * chunk_size < _size; ++idx)
+        {
+            auto count = _size - idx * chunk_size;
+            if (count > chunk_size)
+                count = chunk_size;
+            std::memcpy(buffer + idx * chunk_size, _chunks[idx].data, count * sizeof(CharT));
+        }
+    }
+
+    /// Replaces all strings by a copy of the result of `copy_to()`.
+    template <typename ResourcePtr>
+    void assign(ResourcePtr resource, const CharT* data, std::size_t size)
+    {
+        free(resource);
+        if (size == 0)
+            return;
+
+        allocate_chunks(resource, size);
+        std::memcpy(_chunks[0].data, data, size * sizeof(CharT));
+        _size = size;
+    }
+
+    /// Same as `assign()`, but uses the memory directly without copying it.
+    /// It is never written to or freed, new strings are stored in new chunks.
+    template <typename ResourcePtr>
+    void adopt(ResourcePtr resource, const CharT* data, std::size_t size)
+    {
+        free(resource);
+        if (size == 0)
+            return;
+
+        auto count = (size + chunk_size - 1) / chunk_size;
+        grow_chunks(resource, count);
+        for (auto idx = std::size_t(0); idx != count; ++idx)
+            _chunks[idx] = {const_cast<CharT*>(data) + idx * chunk_size, 0};
+        _chunk_count = count;
+
+        // No space for new strings, so they start a new chunk.
+        _size     = size;
+        _capacity = size;
+    }
+
+    std::size_t allocated_bytes() const
+    {
+        return _allocated_bytes;
+    }
+
+private:
+    CharT* pointer(std::size_t index) const
+    {
+        return _chunks[index >> chunk_bits].data + (index & (chunk_size - 1));
+    }
+
+    template <typename ResourcePtr>
+    void grow_chunks(ResourcePtr resource, std::size_t additional_chunks)
+    {
+        if (_chunk_count + additional_chunks <= _chunk_capacity)
+            return;
+
+        // Only the pointers to the chunks are copied, not the strings.
+        auto new_capacity = 2 * _chunk_capacity;
+        if (new_capacity < _chunk_count + additional_chunks)
+            new_capacity = _chunk_count + additional_chunks;
+        if (new_capacity < 16)
+            new_capacity = 16;
+
+        auto new_chunks
+            = static_cast<chunk*>(resource->allocate(new_capacity * sizeof(chunk), alignof(chunk)));
+        if (_chunk_count > 0)
+            std::memcpy(new_chunks, _chunks, _chunk_count * sizeof(chunk));
+        if (_chunk_capacity > 0)
+            resource->deallocate(_chunks, _chunk_capacity * sizeof(chunk), alignof(chunk));
+
+        _allocated_bytes += (new_capacity - _chunk_capacity) * sizeof(chunk);
+        _chunks         = new_chunks;
+        _chunk_capacity = new_capacity;
+    }
+
+    // Allocates chunks for at least `size` contiguous characters after the existing ones.
+    template <typename ResourcePtr>
+    void allocate_chunks(ResourcePtr resource, std::size_t size)
+    {
+        auto count = (size + chunk_size - 1) / chunk_size;
+        if (count == 0)
+            count = 1;
+        grow_chunks(resource, count);
+
+        // Zero the unused end of the current chunk, so `copy_to()` doesn't read uninitialized
+        // memory.
+        if (_size < _capacity)
+            std::memset(pointer(_size), 0, (_capacity - _size) * sizeof(CharT));
+
+        auto data = static_cast<CharT*>(
+            resource->allocate(count * chunk_size * sizeof(CharT), alignof(CharT)));
+        _allocated_bytes += count * chunk_size * sizeof(CharT);
+        for (auto idx = std::size_t(0); idx != count; ++idx)
+            _chunks[_chunk_count + idx] = {data + idx * chunk_size, idx == 0 ? count : 0};
+
+        _size = _chunk_count * chunk_size;
+        _chunk_count += count;
+        _capacity = _chunk_count * chunk_size;
+    }
+
+    chunk*      _chunks;
+    std::size_t _chunk_count;
+    std::size_t _chunk_capacity;
+    std::size_t _size;
+    std::size_t _capacity;
+    std::size_t _allocated_bytes;
+};
+
+} // namespace dryad::_detail
+
+namespace dryad
+{
+/// The strings of a `symbol_interner` are stored one after the other in a single buffer.
+/// It is the default, but interning a string can move the buffer, which invalidates pointers
+/// returned by `symbol::c_str()`.
+struct contiguous_symbol_storage
+{
+    template <typename CharT>
+    using _buffer = _detail::contiguous_symbol_buffer<CharT>;
+};
+
+/// The strings of a `symbol_interner` are stored in chunks that are never moved, so pointers
+/// returned by `symbol::c_str()` stay valid when more strings are interned.
+struct chunked_symbol_storage
+{
+    template <typename CharT>
+    using _buffer = _detail::chunked_symbol_buffer<CharT>;
+};
+} // namespace dryad
+
+namespace dryad::_detail
+{
+// An entry in the hash table of the interner.
+// It stores the (truncated) hash of the string next to its index, so we never need to look at the
+// string data when rehashing and can reject mismatches without comparing strings.
+template <typename IndexType>
+struct symbol_index_entry
+{
+    IndexType index;
+    IndexType hash;
+};
+
+template <typename IndexType, typename CharT, typename HashAlgorithm, typename Buffer>
 struct symbol_index_hash_traits
 {
-    const symbol_buffer<CharT>* buffer;
+    const Buffer* buffer;
 
-    using value_type = IndexType;
+    using value_type = symbol_index_entry<IndexType>;
 
     struct string_view
     {
         const CharT* ptr;
         std::size_t  length;
+        IndexType    hash;
+
+        explicit string_view(const CharT* ptr, std::size_t length)
+        : ptr(ptr), length(length), hash(hash_string(ptr, length))
+        {}
     };
 
-    static constexpr bool is_unoccupied(IndexType index)
+    static constexpr bool is_unoccupied(value_type entry)
     {
-        return index == IndexType(-1);
+        return entry.index == IndexType(-1);
     }
-    static void fill_unoccupied(IndexType* data, std::size_t size)
+    static void fill_unoccupied(value_type* data, std::size_t size)
     {
         // It has all bits set to 1, so we can do it per-byte.
-        std::memset(data, static_cast<unsigned char>(-1), size * sizeof(IndexType));
+        std::memset(data, static_cast<unsigned char>(-1), size * sizeof(value_type));
     }
 
-    static constexpr bool is_equal(IndexType entry, IndexType value)
+    static constexpr bool is_equal(value_type entry, value_type value)
     {
-        return entry == value;
+        return entry.index == value.index;
     }
-    bool is_equal(IndexType entry, string_view str) const
+    bool is_equal(value_type entry, string_view str) const
     {
-        auto existing_str = buffer->c_str(entry);
-        return std::strncmp(existing_str, str.ptr, str.length) == 0;
+        if (entry.hash != str.hash)
+            return false;
+
+        auto existing_str = buffer->c_str(entry.index);
+        return std::strncmp(existing_str, str.ptr, str.length) == 0
+               && existing_str[str.length] == CharT(0);
     }
 
-    std::size_t hash(IndexType entry) const
+    static constexpr std::size_t hash(value_type entry)
     {
-        auto str = buffer->c_str(entry);
-        return default_hash_algorithm().hash_c_str(str).finish();
+        return entry.hash;
     }
     static constexpr std::size_t hash(string_view str)
     {
-        return default_hash_algorithm()
-            .hash_bytes(reinterpret_cast<const unsigned char*>(str.ptr), str.length * sizeof(CharT))
-            .finish();
+        return str.hash;
+    }
+
+    static IndexType hash_string(const CharT* str, std::size_t length)
+    {
+        auto hash = HashAlgorithm()
+                        .hash_bytes(reinterpret_cast<const unsigned char*>(str),
+                                    length * sizeof(CharT))
+                        .finish();
+        return static_cast<IndexType>(hash);
     }
 };
 } // namespace dryad::_detail
 
+namespace dryad
+{
+/// A compile-time list of strings that can be interned before anything else, e.g. keywords.
+///
+/// When seeded into an empty `symbol_interner`, the strings get indices that are known at
+/// compile-time, so the resulting symbols can be used as constants.
+/// It also contains a perfect hash table to check whether a string is in the list without
+/// interning it.
+template <typename CharT, std::size_t Count, std::size_t BufferSize>
+class symbol_seed
+{
+    static constexpr std::size_t ceil_pow2(std::size_t n)
+    {
+        auto result = std::size_t(1);
+        while (result < n)
+            result *= 2;
+        return result;
+    }
+
+    static constexpr auto table_size   = ceil_pow2(2 * Count);
+    static constexpr auto bucket_count = ceil_pow2(Count / 2);
+
+public:
+    static constexpr auto npos = std::size_t(-1);
+
+    template <std::size_t... N>
+    explicit constexpr symbol_seed(const CharT (&... strs)[N])
+    : _buffer{}, _offsets{}, _displacements{}, _table{}
+    {
+        static_assert(sizeof...(N) == Count && (N + ... + 0) == BufferSize);
+
+        auto offset = std::size_t(0);
+        auto idx    = std::size_t(0);
+        ((_offsets[idx++] = offset, append(offset, strs, N)), ...);
+        _offsets[Count] = offset;
+
+        build_table();
+    }
+
+    //=== access ===//
+    static constexpr std::size_t size()
+    {
+        return Count;
+    }
+
+    constexpr const CharT* c_str(std::size_t pos) const
+    {
+        DRYAD_PRECONDITION(pos < Count);
+        return _buffer + _offsets[pos];
+    }
+    constexpr std::size_t length(std::size_t pos) const
+    {
+        DRYAD_PRECONDITION(pos < Count);
+        return _offsets[pos + 1] - _offsets[pos] - 1;
+    }
+
+    /// The index of the symbol of the string at `pos`, if the seed was given to an empty interner.
+    constexpr std::size_t index(std::size_t pos) const
+    {
+        DRYAD_PRECONDITION(pos < Count);
+        return _offsets[pos];
+    }
+
+    /// The symbol of the string at `pos`, if the seed was given to an empty interner.
+    template <typename Symbol>
+    constexpr Symbol symbol(std::size_t pos) const
+    {
+        return Symbol(static_cast<typename Symbol::index_type>(index(pos)));
+    }
+
+    //=== lookup ===//
+    /// Returns the position of the string in the list, or `npos` if it isn't in it.
+    /// This doesn't require more than one string comparison.
+    constexpr std::size_t lookup(const CharT* str, std::size_t length) const
+    {
+        if constexpr (Count == 0)
+        {
+            (void)str;
+            (void)length;
+            return npos;
+        }
+        else
+        {
+            auto hash  = hash_string(str, length);
+            auto entry = _table[slot_of(hash, _displacements[hash & (bucket_count - 1)])];
+            return entry == 0 ? npos : lookup_in(entry - 1, str, length);
+        }
+    }
+    template <std::size_t N>
+    constexpr std::size_t lookup(const CharT (&literal)[N]) const
+    {
+        DRYAD_PRECONDITION(literal[N - 1] == CharT(0));
+        return lookup(literal, N - 1);
+    }
+
+private:
+    // Returns pos if the string at pos is equal to str.
+    constexpr std::size_t lookup_in(std::size_t pos, const CharT* str, std::size_t length) const
+    {
+        if (this->length(pos) != length)
+            return npos;
+
+        auto existing = c_str(pos);
+        for (auto i = std::size_t(0); i != length; ++i)
+            if (existing[i] != str[i])
+                return npos;
+        return pos;
+    }
+
+    constexpr void append(std::size_t& offset, const CharT* str, std::size_t n)
+    {
+        DRYAD_PRECONDITION(str[n - 1] == CharT(0));
+        for (auto i = std::size_t(0); i != n; ++i)
+            _buffer[offset++] = str[i];
+    }
+
+    static constexpr std::uint64_t hash_string(const CharT* str, std::size_t length)
+    {
+        // FNV-1a, but over characters instead of bytes so it is constexpr.
+        auto hash = std::uint64_t(0xcbf29ce484222325ull);
+        for (auto i = std::size_t(0); i != length; ++i)
+        {
+            hash ^= static_cast<std::uint64_t>(static_cast<std::make_unsigned_t<CharT>>(str[i]));
+            hash *= 0x100000001b3ull;
+        }
+        return hash;
+    }
+
+    static constexpr std::size_t slot_of(std::uint64_t hash, std::uint32_t displacement)
+    {
+        auto x = ((hash >> 32) | (hash << 32)) ^ (displacement * 0x9e3779b97f4a7c15ull);
+        x ^= x >> 31;
+        x *= 0xbf58476d1ce4e5b9ull;
+        x ^= x >> 29;
+        return std::size_t(x & (table_size - 1));
+    }
+
+    // Hash and displace: strings are distributed into buckets, then for each bucket, starting with
+    // the biggest, we search a displacement that maps all of its strings to unused slots.
+    constexpr void build_table()
+    {
+        std::uint64_t hashes[Count + 1]          = {};
+        std::size_t   bucket_sizes[bucket_count] = {};
+        auto          max_bucket_size            = std::size_t(0);
+        for (auto pos = std::size_t(0); pos != Count; ++pos)
+        {
+            hashes[pos] = hash_string(c_str(pos), length(pos));
+            for (auto other = std::size_t(0); other != pos; ++other)
+                DRYAD_PRECONDITION(hashes[other] != hashes[pos]
+                                   || lookup_in(other, c_str(pos), length(pos)) == npos);
+
+            auto& bucket_size = bucket_sizes[hashes[pos] & (bucket_count - 1)];
+            ++bucket_size;
+            if (bucket_size > max_bucket_size)
+                max_bucket_size = bucket_size;
+        }
+
+        for (auto size = max_bucket_size; size > 0; --size)
+            for (auto bucket = std::size_t(0); bucket != bucket_count; ++bucket)
+            {
+                if (bucket_sizes[bucket] != size)
+                    continue;
+
+                for (auto displacement = std::uint32_t(0);; ++displacement)
+                {
+                    if (try_displacement(hashes, bucket, displacement))
+                    {
+                        _displacements[bucket] = displacement;
+                        break;
+                    }
+                }
+            }
+    }
+
+    constexpr bool try_displacement(const std::uint64_t* hashes, std::size_t bucket,
+                                    std::uint32_t displacement)
+    {
+        for (auto pos = std::size_t(0); pos != Count; ++pos)
+        {
+            if ((hashes[pos] & (bucket_count - 1)) != bucket)
+                continue;
+
+            auto& entry = _table[slot_of(hashes[pos], displacement)];
+            if (entry != 0)
+            {
+                // Undo the strings of this bucket we've placed already.
+                for (auto undo = std::size_t(0); undo != pos; ++undo)
+                    if ((hashes[undo] & (bucket_count - 1)) == bucket)
+                        _table[slot_of(hashes[undo], displacement)] = 0;
+                return false;
+            }
+            entry = std::uint32_t(pos + 1);
+        }
+        return true;
+    }
+
+    CharT         _buffer[BufferSize + 1];
+    std::size_t   _offsets[Count + 1];
+    std::uint32_t _displacements[bucket_count];
+    std::uint32_t _table[table_size]; // position + 1, or 0 if empty
+};
+
+/// Creates a `symbol_seed` from string literals.
+template <typename CharT, std::size_t... N>
+constexpr auto make_symbol_seed(const CharT (&... strs)[N])
+{
+    return symbol_seed<CharT, sizeof...(N), (N + ... + 0)>(strs...);
+}
+} // namespace dryad
+
 namespace dryad
 {
 template <typename Id, typename IndexType = std::size_t>
 class symbol;
 
+template <typename Id, typename CharT, typename IndexType, typename MemoryResource,
+          typename HashAlgorithm>
+class concurrent_symbol_interner;
+
+/// Maps strings to symbols, which are indices into a buffer containing all interned strings.
+///
+/// `Probing` is the strategy of the hash table, `group_probing` compares fewer strings.
+/// `Storage` is either `contiguous_symbol_storage` or `chunked_symbol_storage`, which keeps the
+/// strings in place.
 template <typename Id, typename CharT = char, typename IndexType = std::size_t,
-          typename MemoryResource = void>
+          typename MemoryResource = void, typename HashAlgorithm = default_hash_algorithm,
+          typename Probing = linear_probing, typename Storage = contiguous_symbol_storage>
 class symbol_interner
 {
     static_assert(std::is_trivial_v<CharT>);
     static_assert(std::is_unsigned_v<IndexType>);
 
     using resource_ptr = _detail::memory_resource_ptr<MemoryResource>;
-    using traits       = _detail::symbol_index_hash_traits<IndexType, CharT>;
+    using buffer_type  = typename Storage::template _buffer<CharT>;
+    using traits = _detail::symbol_index_hash_traits<IndexType, CharT, HashAlgorithm, buffer_type>;
 
 public:
     using symbol = dryad::symbol<Id, IndexType>;
@@ -162,21 +672,25 @@ public:
 
     ~symbol_interner() noexcept
     {
+        unborrow();
         _buffer.free(_resource);
         _map.free(_resource);
     }
 
     symbol_interner(symbol_interner&& other) noexcept
-    : _buffer(other._buffer), _map(other._map), _resource(other._resource)
+    : _buffer(other._buffer), _map(other._map), _borrowed(other._borrowed),
+      _resource(other._resource)
     {
-        other._buffer = {};
-        other._map    = {};
+        other._buffer   = {};
+        other._map      = {};
+        other._borrowed = false;
     }
 
     symbol_interner& operator=(symbol_interner&& other) noexcept
     {
         _detail::swap(_buffer, other._buffer);
         _detail::swap(_map, other._map);
+        _detail::swap(_borrowed, other._borrowed);
         _detail::swap(_resource, other._resource);
         return *this;
     }
@@ -184,27 +698,56 @@ public:
     //=== interning ===//
     void reserve(std::size_t number_of_symbols, std::size_t average_symbol_length)
     {
+        make_owning();
         _buffer.reserve(_resource, number_of_symbols * average_symbol_length);
         _map.rehash(_resource, _map.to_table_capacity(number_of_symbols), traits{&_buffer});
     }
 
+    /// Interns all strings of the seed, which gives them the indices specified by the seed.
+    /// It must be called before any other string is interned.
+    template <std::size_t Count, std::size_t BufferSize>
+    void seed(const symbol_seed<CharT, Count, BufferSize>& seed)
+    {
+        DRYAD_PRECONDITION(_map.size() == 0);
+        make_owning();
+        _buffer.reserve(_resource, BufferSize);
+        _map.rehash(_resource, _map.to_table_capacity(2 * Count), traits{&_buffer});
+
+        for (auto pos = std::size_t(0); pos != Count; ++pos)
+        {
+            auto sym = intern(seed.c_str(pos), seed.length(pos));
+            DRYAD_ASSERT(sym.id() == seed.index(pos), "seed must be the first thing interned");
+        }
+    }
+
     symbol intern(const CharT* str, std::size_t length)
     {
+        auto key = typename traits::string_view(str, length);
+        if (_borrowed)
+        {
+            // Strings of the snapshot can be looked up without writing to it.
+            // The snapshot of an empty interner has no table, so there is nothing to look up.
+            if (_map.size() > 0)
+                if (auto entry = _map.lookup_entry(key, traits{&_buffer}))
+                    return symbol(entry.get().index);
+            make_owning();
+        }
+
         if (_map.should_rehash())
             _map.rehash(_resource, traits{&_buffer});
 
-        auto entry = _map.lookup_entry(typename traits::string_view{str, length}, traits{&_buffer});
+        auto entry = _map.lookup_entry(key, traits{&_buffer});
         if (entry)
             // Already interned, return index.
-            return symbol(entry.get());
+            return symbol(entry.get().index);
 
         // Copy string data to buffer, as we don't have it yet.
         _buffer.reserve_new_string(_resource, length);
         auto idx = _buffer.insert(str, length);
         DRYAD_PRECONDITION(idx == IndexType(idx)); // Overflow of index type.
 
-        // Store index in map.
-        entry.create(IndexType(idx));
+        // Store index in map, together with the hash so we don't need to compute it again.
+        entry.create({IndexType(idx), key.hash});
 
         // Return new symbol.
         return symbol(IndexType(idx));
@@ -216,10 +759,189 @@ public:
         return intern(literal, N - 1);
     }
 
+    //=== snapshot ===//
+    // The snapshot consists of the header, followed by the string buffer, followed by the memory
+    // of the hash table at the next alignment boundary.
+    // Both are position independent, so it can be loaded by copying them.
+
+    /// The number of bytes required by `write_snapshot()`.
+    std::size_t snapshot_size() const
+    {
+        return table_offset(_buffer.size()) + _map.allocated_bytes();
+    }
+
+    /// Writes all interned strings together with the hash table into `buffer`, which needs
+    /// `snapshot_size()` bytes. Returns the number of bytes written.
+    std::size_t write_snapshot(void* buffer, std::size_t buffer_size) const
+    {
+        auto size = snapshot_size();
+        DRYAD_PRECONDITION(buffer_size >= size);
+        auto image = static_cast<unsigned char*>(buffer);
+
+        auto header = snapshot_header{snapshot_magic, snapshot_version, snapshot_layout(),
+                                      _buffer.size(),  _map.capacity(),  _map.size()};
+        std::memcpy(image, &header, sizeof(header));
+
+        auto buffer_end = sizeof(header) + _buffer.size() * sizeof(CharT);
+        _buffer.copy_to(reinterpret_cast<CharT*>(image + sizeof(header)));
+        std::memset(image + buffer_end, 0, table_offset(_buffer.size()) - buffer_end);
+        if (_map.capacity() > 0)
+            std::memcpy(image + table_offset(_buffer.size()), _map.data(),
+                        _map.allocated_bytes());
+
+        return size;
+    }
+
+    /// Replaces all symbols by the ones of the snapshot; the same strings get the same symbols.
+    /// Nothing is hashed, so the snapshot must have been written by an interner of the same type.
+    /// Returns `false` without changing anything if the snapshot is invalid.
+    bool load_snapshot(const void* data, std::size_t size)
+    {
+        snapshot_header header;
+        if (!read_snapshot_header(data, size, header))
+            return false;
+
+        auto image       = static_cast<const unsigned char*>(data);
+        auto buffer_size = std::size_t(header.buffer_size);
+        unborrow();
+        _buffer.assign(_resource, reinterpret_cast<const CharT*>(image + sizeof(header)),
+                       buffer_size);
+        _map.assign(_resource, std::size_t(header.table_capacity), std::size_t(header.table_size),
+                    image + table_offset(buffer_size));
+        return true;
+    }
+
+    /// Same as `load_snapshot()`, but uses the memory of the snapshot directly instead of copying
+    /// it, e.g. a read-only memory mapped file.
+    ///
+    /// The snapshot is never written to and must outlive the interner. It is only copied once a
+    /// new string is interned; looking up strings of the snapshot doesn't copy anything.
+    /// `data` must be aligned for `std::uint64_t`.
+    bool borrow_snapshot(const void* data, std::size_t size)
+    {
+        DRYAD_PRECONDITION(reinterpret_cast<std::uintptr_t>(data) % alignof(snapshot_header) == 0);
+        snapshot_header header;
+        if (!read_snapshot_header(data, size, header))
+            return false;
+
+        auto image       = static_cast<const unsigned char*>(data);
+        auto buffer_size = std::size_t(header.buffer_size);
+        unborrow();
+        _map.free(_resource);
+        _buffer.adopt(_resource, reinterpret_cast<const CharT*>(image + sizeof(header)),
+                      buffer_size);
+        _map.adopt(std::size_t(header.table_capacity), std::size_t(header.table_size),
+                   image + table_offset(buffer_size));
+        _borrowed = true;
+        return true;
+    }
+
+    /// Whether the interner still uses the hash table of a snapshot passed to `borrow_snapshot()`.
+    /// Strings of the snapshot are never copied with `chunked_symbol_storage`.
+    bool is_borrowing_snapshot() const
+    {
+        return _borrowed;
+    }
+
+    //=== statistics ===//
+    /// The number of bytes allocated from the memory resource for strings and the hash table.
+    std::size_t allocated_bytes() const
+    {
+        return _buffer.allocated_bytes() + (_borrowed ? 0 : _map.allocated_bytes());
+    }
+    /// The statistics of the hash table that maps strings to symbols.
+    hash_table_statistics table_statistics() const
+    {
+        return _map.statistics(traits{&_buffer});
+    }
+
 private:
-    _detail::symbol_buffer<CharT>     _buffer;
-    _detail::hash_table<traits, 1024> _map;
-    DRYAD_EMPTY_MEMBER resource_ptr   _resource;
+    static constexpr std::uint32_t snapshot_magic   = 0x64'73'79'6D; // "dsym"
+    static constexpr std::uint32_t snapshot_version = 1;
+
+    struct snapshot_header
+    {
+        std::uint32_t magic;
+        std::uint32_t version;
+        std::uint64_t layout;
+        std::uint64_t buffer_size;
+        std::uint64_t table_capacity;
+        std::uint64_t table_size;
+    };
+
+    // Fingerprint of everything that determines the bytes of the buffer and the table.
+    static std::uint64_t snapshot_layout()
+    {
+        const CharT str[] = {CharT('d'), CharT('r'), CharT('y'), CharT('a'), CharT('d')};
+        return default_hash_algorithm()
+            .hash_scalar(sizeof(CharT))
+            .hash_scalar(sizeof(IndexType))
+            .hash_scalar(Probing::layout_id)
+            .hash_scalar(traits::hash_string(str, 5))
+            .finish();
+    }
+
+    bool read_snapshot_header(const void* data, std::size_t size, snapshot_header& header) const
+    {
+        auto image = static_cast<const unsigned char*>(data);
+        if (size < sizeof(header))
+            return false;
+        std::memcpy(&header, image, sizeof(header));
+        if (header.magic != snapshot_magic || header.version != snapshot_version
+            || header.layout != snapshot_layout())
+            return false;
+
+        using table = decltype(_map);
+        if (header.buffer_size > (size - sizeof(header)) / sizeof(CharT)
+            || (header.table_capacity != 0
+                && header.table_capacity != table::to_table_capacity(header.table_capacity))
+            || (header.table_size >= header.table_capacity && header.table_size != 0))
+            return false;
+
+        auto buffer_size = std::size_t(header.buffer_size);
+        auto capacity    = std::size_t(header.table_capacity);
+        if (size != table_offset(buffer_size) + table::allocation_size(capacity))
+            return false;
+
+        auto strings = reinterpret_cast<const CharT*>(image + sizeof(header));
+        return buffer_size == 0 || strings[buffer_size - 1] == CharT(0);
+    }
+
+    // Forgets about the borrowed hash table without copying it.
+    // The buffer takes care of borrowed strings itself.
+    void unborrow()
+    {
+        if (!_borrowed)
+            return;
+
+        _map      = {};
+        _borrowed = false;
+    }
+
+    // Copies the borrowed hash table into our own memory, so we can modify it.
+    void make_owning()
+    {
+        if (!_borrowed)
+            return;
+
+        auto map = _map;
+        unborrow();
+        _map.assign(_resource, map.capacity(), map.size(), map.data());
+    }
+
+    static constexpr std::size_t table_offset(std::size_t buffer_size)
+    {
+        constexpr auto alignment = alignof(snapshot_header) > alignof(typename traits::value_type)
+                                       ? alignof(snapshot_header)
+                                       : alignof(typename traits::value_type);
+        auto           end       = sizeof(snapshot_header) + buffer_size * sizeof(CharT);
+        return (end + alignment - 1) & ~(alignment - 1);
+    }
+
+    buffer_type                                _buffer;
+    _detail::hash_table<traits, 1024, Probing> _map;
+    bool                                       _borrowed = false;
+    DRYAD_EMPTY_MEMBER resource_ptr            _resource;
 
     friend symbol;
 };
@@ -250,12 +972,20 @@ public:
     }
 
     //=== slow access ===//
-    template <typename CharT, typename MemoryResource>
-    constexpr const CharT* c_str(
-        const symbol_interner<Id, CharT, IndexType, MemoryResource>& interner) const
+    template <typename CharT, typename MemoryResource, typename HashAlgorithm, typename Probing,
+              typename Storage>
+    constexpr const CharT* c_str(const symbol_interner<Id, CharT, IndexType, MemoryResource,
+                                                       HashAlgorithm, Probing, Storage>& interner)
+        const
     {
         return interner._buffer.c_str(_index);
     }
+    template <typename CharT, typename MemoryResource, typename HashAlgorithm>
+    const CharT* c_str(const concurrent_symbol_interner<Id, CharT, IndexType, MemoryResource,
+                                                        HashAlgorithm>& interner) const
+    {
+        return interner.c_str(_index);
+    }
 
     //=== comparison ===//
     friend constexpr bool operator==(symbol lhs, symbol rhs)
@@ -287,7 +1017,7 @@ public:
 private:
     IndexType _index;
 
-    template <typename, typename, typename, typename>
+    template <typename, typename, typename, typename, typename, typename, typename>
     friend class symbol_interner;
 };
 } // namespace dryad
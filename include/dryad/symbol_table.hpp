@@ -8,6 +8,8 @@
 #include <dryad/_detail/hash_table.hpp>
 #include <dryad/_detail/iterator.hpp>
 #include <dryad/_detail/memory_resource.hpp>
+#include <dryad/_detail/small_table.hpp>
+#include <dryad/arena.hpp>
 #include <dryad/symbol.hpp>
 
 namespace dryad::_detail
@@ -22,12 +24,6 @@ struct symbol_hash_traits
         return idx >= IndexType(-2);
     }
 
-    static void fill_removed(IndexType* data, std::size_t size)
-    {
-        for (auto i = 0u; i < size; ++i)
-            data[i] = IndexType(-2);
-    }
-
     static void fill_unoccupied(IndexType* data, std::size_t size)
     {
         std::memset(data, static_cast<unsigned char>(-1), size * sizeof(IndexType));
@@ -49,19 +45,27 @@ namespace dryad
 {
 /// Maps symbols to their declarations.
 /// API assumes DeclRef is some sort of (smart) pointer to a declaration.
-template <typename Symbol, typename DeclRef, typename MemoryResource = void>
+///
+/// The first `small_capacity` declarations are stored inline and searched linearly; the hash table
+/// is only allocated once there are more. `Probing` is its strategy, either `linear_probing` or
+/// `group_probing`.
+template <typename Symbol, typename DeclRef, typename MemoryResource = void,
+          typename Probing = linear_probing>
 class symbol_table
 {
     static_assert(std::is_trivial_v<DeclRef>);
 
     using resource_ptr = _detail::memory_resource_ptr<MemoryResource>;
     using traits       = _detail::symbol_hash_traits<typename Symbol::index_type>;
-    using hash_table   = _detail::hash_table<traits, 64>;
+    using hash_table   = _detail::hash_table<traits, 64, Probing>;
+    using small_table  = _detail::small_table<typename Symbol::index_type, 8>;
 
 public:
     using symbol   = Symbol;
     using decl_ref = DeclRef;
 
+    static constexpr auto small_capacity = small_table::capacity;
+
     struct value_type
     {
         Symbol  symbol;
@@ -70,9 +74,10 @@ public:
 
     //=== constructors ===//
     constexpr symbol_table()
-    : _decls(nullptr), _resource(_detail::get_memory_resource<MemoryResource>())
+    : _small_decls(), _decls(nullptr), _resource(_detail::get_memory_resource<MemoryResource>())
     {}
-    constexpr explicit symbol_table(MemoryResource* resource) : _decls(nullptr), _resource(resource)
+    constexpr explicit symbol_table(MemoryResource* resource)
+    : _small_decls(), _decls(nullptr), _resource(resource)
     {}
 
     ~symbol_table()
@@ -82,14 +87,21 @@ public:
     }
 
     symbol_table(symbol_table&& other) noexcept
-    : _table(other._table), _decls(other._decls), _resource(other._resource)
+    : _small(other._small), _table(other._table), _decls(other._decls), _resource(other._resource)
     {
+        for (auto i = std::size_t(0); i != _small.size(); ++i)
+            _small_decls[i] = other._small_decls[i];
+
+        other._small.clear();
         other._table = {};
         other._decls = {};
     }
 
     symbol_table& operator=(symbol_table&& other) noexcept
     {
+        _detail::swap(_small, other._small);
+        for (auto i = std::size_t(0); i != small_capacity; ++i)
+            _detail::swap(_small_decls[i], other._small_decls[i]);
         _detail::swap(_table, other._table);
         _detail::swap(_decls, other._decls);
         _detail::swap(_resource, other._resource);
@@ -99,43 +111,63 @@ public:
     //=== access ===//
     bool empty() const
     {
-        return _table.size() == 0;
+        return size() == 0;
     }
     std::size_t size() const
     {
-        return _table.size();
+        return _small.size() + _table.size();
     }
+    /// The capacity of the hash table, which is zero while the declarations are stored inline.
     std::size_t capacity() const
     {
         return _table.capacity();
     }
+    /// The number of bytes allocated from the memory resource.
+    std::size_t allocated_bytes() const
+    {
+        return _table.allocated_bytes() + _table.capacity() * sizeof(DeclRef);
+    }
+    /// The statistics of the hash table, which doesn't include the inline declarations.
+    hash_table_statistics table_statistics() const
+    {
+        return _table.statistics();
+    }
 
     struct iterator : _detail::forward_iterator_base<iterator, value_type, value_type, void>
     {
         const symbol_table*                        _self = nullptr;
+        std::size_t                                _small_idx = 0;
         typename hash_table::entry_range::iterator _cur;
 
         value_type deref() const
         {
-            return {symbol(_cur->get()), _self->_decls[_cur->index()]};
+            if (_small_idx != _self->_small.size())
+                return {symbol(_self->_small[_small_idx]), _self->_small_decls[_small_idx]};
+            else
+                return {symbol(_cur->get()), _self->_decls[_cur->index()]};
         }
         void increment()
         {
-            ++_cur;
+            if (_small_idx != _self->_small.size())
+                ++_small_idx;
+            else
+                ++_cur;
         }
         bool equal(iterator rhs) const
         {
-            return _cur == rhs._cur;
+            return _small_idx == rhs._small_idx && _cur == rhs._cur;
         }
     };
 
     iterator begin() const
     {
-        return {{}, this, const_cast<symbol_table*>(this)->_table.entries().begin()};
+        auto& table = const_cast<symbol_table*>(this)->_table;
+        return {{}, this, 0, table.entries().begin()};
     }
     iterator end() const
     {
-        return {{}, this, const_cast<symbol_table*>(this)->_table.entries().end()};
+        auto& table = const_cast<symbol_table*>(this)->_table;
+        return {{}, this, _small.size(), table.entries().end()};
     }
 
     //=== modifiers ===//
@@ -143,7 +175,8 @@ public:
     {
         new_capacity  = _table.to_table_capacity(new_capacity);
         auto capacity = _table.capacity();
-        if (new_capacity <= capacity)
+        // Rehashing at the same capacity drops removed slots of the table.
+        if (new_capacity < capacity || (new_capacity == capacity && _table.removed() == 0))
             return;
 
         auto new_decls = static_cast<DeclRef*>(
@@ -158,6 +191,15 @@ public:
             _resource->deallocate(_decls, capacity * sizeof(DeclRef), alignof(DeclRef));
 
         _decls = new_decls;
+
+        // Move the inline declarations into the hash table; it is used from now on.
+        for (auto i = std::size_t(0); i != _small.size(); ++i)
+        {
+            auto entry = _table.lookup_entry(_small[i]);
+            entry.create(_small[i]);
+            _decls[entry.index()] = _small_decls[i];
+        }
+        _small.clear();
     }
 
     /// Inserts a new declaration into the symbol table.
@@ -165,8 +207,24 @@ public:
     /// Otherwise returns a default constructed DeclRef.
     DeclRef insert_or_shadow(Symbol symbol, DeclRef decl)
     {
+        if (_table.capacity() == 0)
+        {
+            auto idx = _small.find(symbol.id());
+            if (idx != _small.size())
+            {
+                auto shadowed     = _small_decls[idx];
+                _small_decls[idx] = decl;
+                return shadowed;
+            }
+            else if (!_small.full())
+            {
+                _small_decls[_small.push_back(symbol.id())] = decl;
+                return DeclRef();
+            }
+        }
+
         if (_table.should_rehash())
-            rehash(2 * _table.capacity());
+            rehash(_table.next_capacity());
 
         auto entry = _table.lookup_entry(symbol.id());
         if (entry)
@@ -184,9 +242,22 @@ public:
     }
 
     /// Removes a declaration with that name from the symbol table.
+    /// It invalidates all iterators, as other declarations are moved; use `remove_if()` instead
+    /// while iterating.
     DeclRef remove(Symbol symbol)
     {
-        if (empty())
+        if (_table.capacity() == 0)
+        {
+            auto idx = _small.find(symbol.id());
+            if (idx == _small.size())
+                return DeclRef();
+
+            auto decl = _small_decls[idx];
+            _small.erase(idx);
+            _small_decls[idx] = _small_decls[_small.size()];
+            return decl;
+        }
+        else if (_table.size() == 0)
             return DeclRef();
 
         auto entry = _table.lookup_entry(symbol.id());
@@ -194,16 +265,51 @@ public:
             return DeclRef();
 
         auto decl = _decls[entry.index()];
-        entry.remove();
+        entry.erase([&](std::size_t old_idx, std::size_t new_idx) {
+            // The declaration needs to move as well.
+            _decls[new_idx] = _decls[old_idx];
+        });
         return decl;
     }
 
+    /// Removes all declarations for which `pred(value_type)` returns true.
+    /// Every declaration is visited exactly once. Returns the number of removed declarations.
+    template <typename Predicate>
+    std::size_t remove_if(Predicate pred)
+    {
+        auto old_size = size();
+
+        for (auto idx = std::size_t(0); idx != _small.size();)
+            if (pred(value_type{symbol(_small[idx]), _small_decls[idx]}))
+            {
+                // The last declaration is moved into its place, so check the index again.
+                _small.erase(idx);
+                _small_decls[idx] = _small_decls[_small.size()];
+            }
+            else
+                ++idx;
+
+        _table.erase_if(
+            [&](auto entry) { return pred(value_type{symbol(entry.get()), _decls[entry.index()]}); },
+            [&](std::size_t old_idx, std::size_t new_idx) {
+                // The declaration needs to move as well.
+                _decls[new_idx] = _decls[old_idx];
+            });
+
+        return old_size - size();
+    }
+
     /// Searches for a declaration with that name.
     /// If found in the symbol table, returns it.
     /// Otherwise, returns a default constructed DeclRef.
     DeclRef lookup(Symbol symbol) const
     {
-        if (empty())
+        if (_table.capacity() == 0)
+        {
+            auto idx = _small.find(symbol.id());
+            return idx != _small.size() ? _small_decls[idx] : DeclRef();
+        }
+        else if (_table.size() == 0)
             return DeclRef();
 
         auto entry = const_cast<symbol_table*>(this)->_table.lookup_entry(symbol.id());
@@ -211,10 +317,155 @@ public:
     }
 
 private:
+    small_table                     _small; // only used while the hash table is not allocated
+    DeclRef                         _small_decls[small_capacity]; // shares key index
     hash_table                      _table;
     DeclRef*                        _decls; // shares key index
     DRYAD_EMPTY_MEMBER resource_ptr _resource;
 };
+
+/// A symbol table with nested scopes.
+/// Declarations inserted in a scope are removed when the scope is popped, restoring the
+/// declarations they've shadowed.
+template <typename Symbol, typename DeclRef, typename MemoryResource = void,
+          typename Probing = linear_probing>
+class scoped_symbol_table
+{
+    using table = symbol_table<Symbol, DeclRef, MemoryResource, Probing>;
+
+public:
+    using symbol     = Symbol;
+    using decl_ref   = DeclRef;
+    using value_type = typename table::value_type;
+    using iterator   = typename table::iterator;
+
+    //=== constructors ===//
+    scoped_symbol_table() : _scope(nullptr), _scope_depth(0) {}
+    explicit scoped_symbol_table(MemoryResource* resource)
+    : _table(resource), _log(resource), _scope(nullptr), _scope_depth(0)
+    {}
+
+    scoped_symbol_table(scoped_symbol_table&& other) noexcept
+    : _table(DRYAD_MOV(other._table)), _log(DRYAD_MOV(other._log)), _scope(other._scope),
+      _scope_depth(other._scope_depth)
+    {
+        other._scope       = nullptr;
+        other._scope_depth = 0;
+    }
+
+    scoped_symbol_table& operator=(scoped_symbol_table&& other) noexcept
+    {
+        _detail::swap(_table, other._table);
+        _detail::swap(_log, other._log);
+        _detail::swap(_scope, other._scope);
+        _detail::swap(_scope_depth, other._scope_depth);
+        return *this;
+    }
+
+    //=== access ===//
+    bool empty() const
+    {
+        return _table.empty();
+    }
+    std::size_t size() const
+    {
+        return _table.size();
+    }
+
+    /// Iterates over all visible declarations.
+    iterator begin() const
+    {
+        return _table.begin();
+    }
+    iterator end() const
+    {
+        return _table.end();
+    }
+
+    //=== scopes ===//
+    /// The number of scopes that have been pushed and not popped yet.
+    std::size_t scope_depth() const
+    {
+        return _scope_depth;
+    }
+
+    void push_scope()
+    {
+        auto marker = _log.top();
+        _scope      = _log.template construct<scope>(scope{_scope, nullptr, marker});
+        ++_scope_depth;
+    }
+
+    /// Removes all declarations inserted since the matching `push_scope()`.
+    /// Memory of the scope is re-used by the next scope.
+    void pop_scope()
+    {
+        DRYAD_PRECONDITION(_scope != nullptr);
+
+        // Undo in reverse order, so a symbol declared multiple times in the scope is restored to
+        // the declaration before the scope.
+        for (auto cur = _scope->last; cur != nullptr; cur = cur->prev)
+        {
+            if (cur->shadowed == DeclRef())
+                _table.remove(cur->symbol);
+            else
+                _table.insert_or_shadow(cur->symbol, cur->shadowed);
+        }
+
+        auto scope = *_scope;
+        _log.unwind(scope.marker);
+        _scope = scope.parent;
+        --_scope_depth;
+    }
+
+    //=== modifiers ===//
+    void rehash(std::size_t new_capacity)
+    {
+        _table.rehash(new_capacity);
+    }
+
+    /// Inserts a new declaration into the current scope.
+    /// If there is already a declaration with that name, shadows it until the scope is popped and
+    /// returns it. Otherwise returns a default constructed DeclRef.
+    ///
+    /// Declarations inserted without a scope are never removed.
+    DeclRef insert_or_shadow(Symbol symbol, DeclRef decl)
+    {
+        auto shadowed = _table.insert_or_shadow(symbol, decl);
+        if (_scope != nullptr)
+            _scope->last = _log.template construct<undo_entry>(
+                undo_entry{_scope->last, symbol, shadowed});
+        return shadowed;
+    }
+
+    /// Searches for a declaration with that name in all scopes.
+    /// If found, returns the innermost one.
+    /// Otherwise, returns a default constructed DeclRef.
+    DeclRef lookup(Symbol symbol) const
+    {
+        return _table.lookup(symbol);
+    }
+
+private:
+    struct undo_entry
+    {
+        undo_entry* prev;
+        Symbol      symbol;
+        DeclRef     shadowed;
+    };
+
+    struct scope
+    {
+        scope*                                 parent;
+        undo_entry*                            last;
+        typename arena<MemoryResource>::marker marker;
+    };
+
+    table                 _table;
+    arena<MemoryResource> _log;
+    scope*                _scope;
+    std::size_t           _scope_depth;
+};
 } // namespace dryad
 
 #endif // DRYAD_SYMBOL_TABLE_HPP_INCLUDED
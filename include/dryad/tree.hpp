@@ -4,12 +4,17 @@
 #ifndef DRYAD_TREE_HPP_INCLUDED
 #define DRYAD_TREE_HPP_INCLUDED
 
+#include <cstring>
 #include <dryad/_detail/config.hpp>
 #include <dryad/arena.hpp>
 #include <dryad/node.hpp>
+#include <new>
 
 namespace dryad
 {
+template <typename NodeKind>
+struct _node_copier;
+
 template <typename NodeKindType, typename MemoryResource>
 class node_creator : public node_ctor
 {
@@ -24,16 +29,26 @@ public:
         return _arena->template construct<T>(*this, DRYAD_FWD(args)...);
     }
 
+    /// Reserves `size` bytes of memory for the nodes created next, so creating them doesn't
+    /// allocate.
+    void reserve(std::size_t size)
+    {
+        _arena->reserve(size);
+    }
+
 private:
     node_creator(arena<MemoryResource>& arena) : _arena(&arena) {}
 
     arena<MemoryResource>* _arena;
 
+    template <typename>
+    friend struct _node_copier;
+
     template <typename, typename>
     friend class tree;
     template <typename, typename>
     friend class forest;
-    template <typename, typename, typename>
+    template <typename, typename, typename, typename, typename>
     friend class hash_forest;
 };
 
@@ -47,6 +62,14 @@ public:
     //=== construction ===//
     tree() = default;
     explicit tree(MemoryResource* resource) : _arena(resource) {}
+    /// Forwards the block size and growth strategy to the underlying arena.
+    explicit tree(std::size_t block_size, arena_growth growth = arena_growth::constant)
+    : _arena(block_size, growth)
+    {}
+    explicit tree(MemoryResource* resource, std::size_t block_size,
+                  arena_growth growth = arena_growth::constant)
+    : _arena(resource, block_size, growth)
+    {}
 
     //=== node creation ===//
     using node_creator = dryad::node_creator<node_kind_type, MemoryResource>;
@@ -56,12 +79,96 @@ public:
     {
         return node_creator(_arena).template create<T>(DRYAD_FWD(args)...);
     }
+    /// Creates nodes of the tree, e.g. for `clone_subtree()`.
+    node_creator creator()
+    {
+        return node_creator(_arena);
+    }
 
     void clear()
     {
         _root = nullptr;
         _arena.clear();
     }
+    /// Same as `clear()`, but only keeps up to `retained_bytes` of memory for the next tree.
+    void clear(std::size_t retained_bytes)
+    {
+        _root = nullptr;
+        _arena.clear(retained_bytes);
+    }
+
+    /// Releases memory that isn't used by any node.
+    void shrink_to_fit()
+    {
+        _arena.shrink_to_fit();
+    }
+
+    /// The memory used by the nodes.
+    arena_statistics memory_statistics() const
+    {
+        return _arena.statistics();
+    }
+    /// The memory resource the nodes are allocated from.
+    MemoryResource* memory_resource() const
+    {
+        return _arena.resource().get();
+    }
+    /// The block size and growth strategy of the underlying arena.
+    std::size_t block_size() const
+    {
+        return _arena.block_size();
+    }
+    arena_growth growth() const
+    {
+        return _arena.growth();
+    }
+
+    /// Copies all nodes reachable from the root into fresh memory in pre-order and releases the old
+    /// memory, so traversals access memory sequentially.
+    ///
+    /// `NodeTypes` must list the concrete type of every node in the tree; they are copied bytewise.
+    /// `remap(old, copy)` is invoked for every node, `old` is destroyed after `compact()` returns.
+    template <typename... NodeTypes, typename Callback>
+    void compact(Callback remap)
+    {
+        auto old_arena = DRYAD_MOV(_arena);
+        if (_root == nullptr)
+            return;
+
+        using copier = _node_copier<node_kind_type>;
+        auto copy    = copier::template copy_subtree<NodeTypes...>(_arena, _root, remap);
+        _root        = static_cast<RootNode*>(copy);
+        _root->set_next_parent(_root);
+    }
+    template <typename... NodeTypes>
+    void compact()
+    {
+        compact<NodeTypes...>([](const auto*, auto*) {});
+    }
+
+    /// Creates a deep copy of the tree that uses the same memory resource, e.g. to keep the tree
+    /// before modifying it.
+    ///
+    /// Like `compact()`, only the nodes reachable from the root are copied bytewise in pre-order;
+    /// the copy uses the same block size and growth strategy. `remap(node, copy)` is invoked for
+    /// every node.
+    template <typename... NodeTypes, typename Callback>
+    tree clone(Callback remap) const
+    {
+        tree result(memory_resource(), _arena.block_size(), _arena.growth());
+        if (_root == nullptr)
+            return result;
+
+        using copier = _node_copier<node_kind_type>;
+        auto copy    = copier::template copy_subtree<NodeTypes...>(result._arena, _root, remap);
+        result.set_root(static_cast<RootNode*>(copy));
+        return result;
+    }
+    template <typename... NodeTypes>
+    tree clone() const
+    {
+        return clone<NodeTypes...>([](const auto*, auto*) {});
+    }
 
     //=== root node ===//
     bool has_root() const
@@ -86,9 +193,30 @@ public:
         _root->set_next_parent(_root);
     }
 
+    //=== versions ===//
+    /// Takes ownership of all nodes of `other`, which must use the same memory resource, and
+    /// returns its root; `other` is empty afterwards.
+    ///
+    /// This allows building a new version of a tree that re-uses unchanged subtrees of the previous
+    /// version, e.g. using `tree_builder::reuse()`. Nodes of previous versions stay alive until the
+    /// tree is cleared or compacted, so a `compact()` every couple of versions releases those that
+    /// aren't reachable anymore.
+    RootNode* absorb(tree&& other)
+    {
+        _arena.absorb(DRYAD_MOV(other._arena));
+        auto root   = other._root;
+        other._root = nullptr;
+        return root;
+    }
+
 private:
     arena<MemoryResource> _arena;
     RootNode*             _root = nullptr;
+
+    template <typename>
+    friend struct _snapshot;
+    template <typename, typename>
+    friend class tree_builder;
 };
 
 /// Owns multiple nodes, eventually all children of a list of root nodes.
@@ -101,6 +229,14 @@ public:
     //=== construction ===//
     forest() = default;
     explicit forest(MemoryResource* resource) : _arena(resource) {}
+    /// Forwards the block size and growth strategy to the underlying arena.
+    explicit forest(std::size_t block_size, arena_growth growth = arena_growth::constant)
+    : _arena(block_size, growth)
+    {}
+    explicit forest(MemoryResource* resource, std::size_t block_size,
+                    arena_growth growth = arena_growth::constant)
+    : _arena(resource, block_size, growth)
+    {}
 
     //=== node creation ===//
     using node_creator = dryad::node_creator<node_kind_type, MemoryResource>;
@@ -110,6 +246,11 @@ public:
     {
         return node_creator(_arena).template create<T>(DRYAD_FWD(args)...);
     }
+    /// Creates nodes of the forest, e.g. for `clone_subtree()`.
+    node_creator creator()
+    {
+        return node_creator(_arena);
+    }
 
     void insert_root(RootNode* root)
     {
@@ -122,21 +263,113 @@ public:
         _roots.back()->set_next_sibling(_roots.front());
     }
 
+    /// Appends the roots of `other` and takes ownership of its nodes without copying them.
+    /// `other` must use the same memory resource and is empty afterwards.
+    void absorb(forest&& other)
+    {
+        _arena.absorb(DRYAD_MOV(other._arena));
+        if (!other._roots.empty())
+            insert_root_list(DRYAD_MOV(other._roots));
+    }
+
     void clear()
     {
         _roots = {};
         _arena.clear();
     }
+    /// Same as `clear()`, but only keeps up to `retained_bytes` of memory for the next nodes.
+    void clear(std::size_t retained_bytes)
+    {
+        _roots = {};
+        _arena.clear(retained_bytes);
+    }
+
+    /// Releases memory that isn't used by any node.
+    void shrink_to_fit()
+    {
+        _arena.shrink_to_fit();
+    }
+
+    /// The memory used by the nodes.
+    arena_statistics memory_statistics() const
+    {
+        return _arena.statistics();
+    }
+    /// The memory resource the nodes are allocated from.
+    MemoryResource* memory_resource() const
+    {
+        return _arena.resource().get();
+    }
+    /// The block size and growth strategy of the underlying arena.
+    std::size_t block_size() const
+    {
+        return _arena.block_size();
+    }
+    arena_growth growth() const
+    {
+        return _arena.growth();
+    }
+
+    /// Same as `tree::compact()`, but copies the trees of all roots in order.
+    template <typename... NodeTypes, typename Callback>
+    void compact(Callback remap)
+    {
+        auto old_arena = DRYAD_MOV(_arena);
+        auto old_roots = _roots;
+        _roots         = {};
+        if (old_roots.empty())
+            return;
+
+        using copier = _node_copier<node_kind_type>;
+        unlinked_node_list<RootNode> new_roots;
+        for (auto cur = old_roots.front();; cur = static_cast<RootNode*>(cur->next_node()))
+        {
+            auto copy = copier::template copy_subtree<NodeTypes...>(_arena, cur, remap);
+            new_roots.push_back(static_cast<RootNode*>(copy));
+
+            if (cur == old_roots.back())
+                break;
+        }
+        insert_root_list(DRYAD_MOV(new_roots));
+    }
+    template <typename... NodeTypes>
+    void compact()
+    {
+        compact<NodeTypes...>([](const auto*, auto*) {});
+    }
 
     //=== root nodes ===//
     auto roots() const
     {
-        return make_node_range(_roots.begin(), _roots.end());
+        return make_node_range(root_iterator{{}, _roots.front(), _roots.back()}, root_iterator{});
     }
 
 private:
+    // The roots form a circular list, so we need to stop after the last one.
+    struct root_iterator : _detail::forward_iterator_base<root_iterator, RootNode*, RootNode*, void>
+    {
+        RootNode* _cur  = nullptr;
+        RootNode* _last = nullptr;
+
+        RootNode* deref() const
+        {
+            return _cur;
+        }
+        void increment()
+        {
+            _cur = _cur == _last ? nullptr : static_cast<RootNode*>(_cur->next_node());
+        }
+        bool equal(root_iterator rhs) const
+        {
+            return _cur == rhs._cur;
+        }
+    };
+
     arena<MemoryResource>        _arena;
     unlinked_node_list<RootNode> _roots;
+
+    template <typename>
+    friend struct _snapshot;
 };
 } // namespace dryad
 
@@ -310,6 +543,111 @@ auto traverse(const tree<NodeKind, MemoryResource>& t)
 }
 } // namespace dryad
 
+namespace dryad
+{
+template <typename NodeKind>
+struct _node_copier
+{
+    using node_type = node<NodeKind>;
+
+    template <typename T, typename MemoryResource>
+    static node_type* copy_as(arena<MemoryResource>& arena, const node_type* n)
+    {
+        static_assert(!is_abstract_node<T, NodeKind>, "need the concrete node type");
+        static_assert(std::is_trivially_destructible_v<T>, "nobody will call its destructor");
+
+        auto memory = arena.template allocate<T>();
+        std::memcpy(memory, static_cast<const void*>(static_cast<const T*>(n)), sizeof(T));
+        return std::launder(static_cast<T*>(memory));
+    }
+
+    // Creates an unlinked copy of the node itself without its children.
+    template <typename... NodeTypes, typename MemoryResource>
+    static node_type* copy_node(arena<MemoryResource>& arena, const node_type* n)
+    {
+        node_type* result = nullptr;
+        (void)((node_has_kind<NodeTypes>(n) && (result = copy_as<NodeTypes>(arena, n), true))
+               || ...);
+        DRYAD_PRECONDITION(result != nullptr); // type of node not specified
+
+        result->unlink();
+        if (result->_is_container)
+            result->_user_data_ptr = nullptr;
+        return result;
+    }
+
+    // Copies the subtree in pre-order and returns its unlinked root.
+    template <typename... NodeTypes, typename MemoryResource, typename Callback>
+    static node_type* copy_subtree(arena<MemoryResource>& arena, const node_type* n,
+                                   Callback& callback)
+    {
+        node_type* root   = nullptr;
+        node_type* parent = nullptr; // copy of the container whose children we're copying
+        node_type* last   = nullptr; // last child of parent copied so far
+        for (auto [ev, cur] : traverse(n))
+        {
+            if (ev == traverse_event::exit)
+            {
+                // The copy of cur is the last child of its parent, so it points to it.
+                last   = parent;
+                parent = parent->next_node();
+                continue;
+            }
+
+            auto copy = copy_node<NodeTypes...>(arena, cur);
+            callback(cur, copy);
+
+            if (parent == nullptr)
+                root = copy;
+            else
+            {
+                copy->set_next_parent(parent);
+                if (last == nullptr)
+                    parent->_user_data_ptr = copy;
+                else
+                    last->set_next_sibling(copy);
+            }
+
+            if (ev == traverse_event::enter)
+            {
+                parent = copy;
+                last   = nullptr;
+            }
+            else
+            {
+                last = copy;
+            }
+        }
+        return root;
+    }
+    template <typename... NodeTypes, typename MemoryResource, typename Callback>
+    static node_type* copy_subtree(node_creator<NodeKind, MemoryResource> creator,
+                                   const node_type* n, Callback& callback)
+    {
+        return copy_subtree<NodeTypes...>(*creator._arena, n, callback);
+    }
+};
+
+/// Copies the subtree rooted at `n` using `creator`, which can belong to a different tree or
+/// forest with the same node kind, and returns the unlinked copy of `n`.
+///
+/// `NodeTypes` must list the concrete type of every node in the subtree; they are copied bytewise
+/// in pre-order. `remap(node, copy)` is invoked for every node. Reserve memory using the creator
+/// first, so all copies are next to each other.
+template <typename... NodeTypes, typename T, typename MemoryResource, typename Callback>
+T* clone_subtree(const T* n, node_creator<typename T::node_kind_type, MemoryResource> creator,
+                 Callback remap)
+{
+    using copier = _node_copier<typename T::node_kind_type>;
+    return static_cast<T*>(copier::template copy_subtree<NodeTypes...>(creator, n, remap));
+}
+template <typename... NodeTypes, typename T, typename MemoryResource>
+T* clone_subtree(const T* n, node_creator<typename T::node_kind_type, MemoryResource> creator)
+{
+    return clone_subtree<NodeTypes...>(n, creator, [](const auto*, auto*) {});
+}
+} // namespace dryad
+
 namespace dryad
 {
 /// Visitor that can be used to visit the children of a node manually.
@@ -344,12 +682,13 @@ struct _visit_tree<NodeKind, _detail::node_type_list<NodeTypes...>, Lambdas...>
     {}
 
     template <typename T, typename Iter, typename Lambda>
-    DRYAD_FORCE_INLINE auto call(_detail::priority_tag<4>, Iter& iter, Lambda& lambda)
+    DRYAD_FORCE_INLINE auto call(_detail::priority_tag<4>, node_kind kind, Iter& iter,
+                                 Lambda& lambda)
         -> decltype(lambda(child_visitor<node_kind>{}, DRYAD_DECLVAL(T*)), true)
     {
-        auto node = node_try_cast<T>(iter->node);
-        if (node == nullptr)
+        if (!T::type_matches_kind(kind))
             return false;
+        auto node = node_cast<T>(iter->node);
 
         if (iter->event == traverse_event::enter)
         {
@@ -369,61 +708,98 @@ struct _visit_tree<NodeKind, _detail::node_type_list<NodeTypes...>, Lambdas...>
         return !is_abstract_node<T, node_kind>;
     }
     template <typename T, typename Iter, typename Lambda>
-    DRYAD_FORCE_INLINE static auto call(_detail::priority_tag<3>, Iter& iter, Lambda& lambda)
+    DRYAD_FORCE_INLINE static auto call(_detail::priority_tag<3>, node_kind kind, Iter& iter,
+                                        Lambda& lambda)
         -> decltype(lambda(traverse_event::enter, DRYAD_DECLVAL(T*)), true)
     {
-        auto node = node_try_cast<T>(iter->node);
-        if (node == nullptr)
+        if (!T::type_matches_kind(kind))
             return false;
+        auto node = node_cast<T>(iter->node);
 
         lambda(iter->event, node);
         return !is_abstract_node<T, node_kind>;
     }
     template <typename T, typename Iter, typename Lambda>
-    DRYAD_FORCE_INLINE static auto call(_detail::priority_tag<2>, Iter& iter, Lambda& lambda)
+    DRYAD_FORCE_INLINE static auto call(_detail::priority_tag<2>, node_kind kind, Iter& iter,
+                                        Lambda& lambda)
         -> decltype(lambda(traverse_event_enter{}, DRYAD_DECLVAL(T*)), true)
     {
-        auto node = node_try_cast<T>(iter->node);
-        if (node == nullptr)
+        if (!T::type_matches_kind(kind))
             return false;
+        auto node = node_cast<T>(iter->node);
 
         if (iter->event == traverse_event::enter)
             lambda(traverse_event_enter{}, node);
         return !is_abstract_node<T, node_kind>;
     }
     template <typename T, typename Iter, typename Lambda>
-    DRYAD_FORCE_INLINE static auto call(_detail::priority_tag<2>, Iter& iter, Lambda& lambda)
+    DRYAD_FORCE_INLINE static auto call(_detail::priority_tag<2>, node_kind kind, Iter& iter,
+                                        Lambda& lambda)
         -> decltype(lambda(traverse_event_exit{}, DRYAD_DECLVAL(T*)), true)
     {
-        auto node = node_try_cast<T>(iter->node);
-        if (node == nullptr)
+        if (!T::type_matches_kind(kind))
             return false;
+        auto node = node_cast<T>(iter->node);
 
         if (iter->event == traverse_event::exit)
             lambda(traverse_event_exit{}, node);
         return !is_abstract_node<T, node_kind>;
     }
     template <typename T, typename Iter, typename Lambda>
-    DRYAD_FORCE_INLINE static auto call(_detail::priority_tag<2>, Iter& iter, Lambda& lambda)
+    DRYAD_FORCE_INLINE static auto call(_detail::priority_tag<2>, node_kind kind, Iter& iter,
+                                        Lambda& lambda)
         -> decltype(lambda(DRYAD_DECLVAL(T*)), true)
     {
-        auto node = node_try_cast<T>(iter->node);
-        if (node == nullptr)
+        if (!T::type_matches_kind(kind))
             return false;
+        auto node = node_cast<T>(iter->node);
 
         if (iter->event != traverse_event::exit)
             lambda(node);
         return !is_abstract_node<T, node_kind>;
     }
 
+    template <typename Iter>
+    DRYAD_FORCE_INLINE void visit_kind(node_kind kind, Iter& iter)
+    {
+        (void)(call<NodeTypes>(_detail::priority_tag<4>{}, kind, iter,
+                               static_cast<Lambdas&>(*this))
+               || ...);
+    }
+
+    // The kind is a constant, so only the matching lambdas remain.
+    template <std::uint16_t Kind, typename Iter>
+    static void visit_as(_visit_tree& self, Iter& iter)
+    {
+        self.visit_kind(node_kind_traits<node_kind>::from_int(Kind), iter);
+    }
+
+    template <typename Iter, std::uint16_t... Kinds>
+    DRYAD_FORCE_INLINE void visit_table(std::integer_sequence<std::uint16_t, Kinds...>,
+                                        Iter& iter)
+    {
+        using fn                    = void (*)(_visit_tree&, Iter&);
+        static constexpr fn table[] = {&visit_as<Kinds, Iter>...};
+
+        auto kind = node_kind_traits<node_kind>::to_int(iter->node->kind());
+        if (kind < sizeof...(Kinds))
+            table[kind](*this, iter);
+        else
+            visit_kind(iter->node->kind(), iter);
+    }
+
     template <typename TreeOrNode>
     DRYAD_FORCE_INLINE void visit(TreeOrNode&& tree_or_node)
     {
+        constexpr auto table_size = _detail::dispatch_table_size<node_kind, NodeTypes...>();
+
         auto range = dryad::traverse(tree_or_node);
         for (auto iter = range.begin(); iter != range.end(); ++iter)
         {
-            (void)(call<NodeTypes>(_detail::priority_tag<4>{}, iter, static_cast<Lambdas&>(*this))
-                   || ...);
+            if constexpr (table_size > 0)
+                visit_table(std::make_integer_sequence<std::uint16_t, table_size>{}, iter);
+            else
+                visit_kind(iter->node->kind(), iter);
         }
     }
 };
@@ -0,0 +1,169 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#ifndef DRYAD_TREE_BUILDER_HPP_INCLUDED
+#define DRYAD_TREE_BUILDER_HPP_INCLUDED
+
+#include <dryad/_detail/config.hpp>
+#include <dryad/_detail/memory_resource.hpp>
+#include <dryad/node.hpp>
+#include <dryad/tree.hpp>
+
+namespace dryad
+{
+/// Builds a tree bottom-up from nodes that are created in post-order, e.g. by a parser.
+///
+/// Created nodes are pushed onto a stack until their parent is finished, which takes all nodes
+/// pushed since the matching `start()` as its children. Every node is linked exactly once, when
+/// its parent is created, unlike building `unlinked_node_list`s and inserting them.
+template <typename RootNode, typename MemoryResource = void>
+class tree_builder
+{
+    using resource_ptr = _detail::memory_resource_ptr<MemoryResource>;
+
+public:
+    using node_kind_type = typename RootNode::node_kind_type;
+    using node_type      = node<node_kind_type>;
+
+    /// The position on the stack where the children of a container begin.
+    struct marker
+    {
+        std::size_t _pos;
+    };
+
+    //=== constructors ===//
+    explicit tree_builder(tree<RootNode, MemoryResource>& tree)
+    : _tree(&tree), _stack(nullptr), _size(0), _capacity(0)
+    {}
+
+    tree_builder(const tree_builder&)            = delete;
+    tree_builder& operator=(const tree_builder&) = delete;
+
+    ~tree_builder()
+    {
+        if (_capacity > 0)
+            resource()->deallocate(_stack, _capacity * sizeof(node_type*), alignof(node_type*));
+    }
+
+    /// Reserves memory for `node_count` nodes of `node_size` bytes on average, so creating them
+    /// doesn't allocate.
+    void reserve(std::size_t node_count, std::size_t node_size)
+    {
+        _tree->_arena.reserve(node_count * node_size);
+    }
+
+    //=== building ===//
+    /// The number of nodes on the stack, i.e. nodes without a parent.
+    std::size_t stack_size() const
+    {
+        return _size;
+    }
+
+    /// Creates a node and pushes it; it becomes a child of the next container that is finished.
+    template <typename T, typename... Args>
+    T* create(Args&&... args)
+    {
+        auto result = _tree->template create<T>(DRYAD_FWD(args)...);
+        push(result);
+        return result;
+    }
+
+    /// Pushes a node that has been created separately and isn't part of a tree yet.
+    void push(node_type* n)
+    {
+        DRYAD_PRECONDITION(n != nullptr && !n->is_linked_in_tree());
+        push_unchecked(n);
+    }
+
+    /// Pushes a node of a previous version of the tree, which has been absorbed using
+    /// `tree::absorb()`, to re-use it together with its entire subtree.
+    ///
+    /// Unlike `push()`, the node may still be linked into its old parent. That is overridden when
+    /// it is linked into the new version, so the old parent must not be traversed anymore. Every
+    /// node can only be re-used once per version.
+    void reuse(node_type* n)
+    {
+        DRYAD_PRECONDITION(n != nullptr);
+        push_unchecked(n);
+    }
+
+    /// Marks the beginning of the children of the next container.
+    marker start() const
+    {
+        return {_size};
+    }
+
+    /// Creates a container which takes all nodes pushed since `m` as its children, in order, and
+    /// pushes it.
+    template <typename T, typename... Args>
+    T* finish(marker m, Args&&... args)
+    {
+        DRYAD_PRECONDITION(m._pos <= _size);
+        auto result = _tree->template create<T>(DRYAD_FWD(args)...);
+
+        if (m._pos != _size)
+        {
+            node_type* container = result;
+            DRYAD_PRECONDITION(bool(container->_is_container));
+
+            container->_user_data_ptr = _stack[m._pos];
+            for (auto i = m._pos; i + 1 < _size; ++i)
+                _stack[i]->set_next_sibling(_stack[i + 1]);
+            _stack[_size - 1]->set_next_parent(container);
+        }
+
+        _size = m._pos;
+        push(result);
+        return result;
+    }
+
+    /// Turns the only node on the stack into the root of the tree.
+    RootNode* set_root()
+    {
+        DRYAD_PRECONDITION(_size == 1);
+        auto root = node_cast<RootNode>(_stack[0]);
+        _size     = 0;
+
+        root->unlink(); // it might be re-used from a previous version
+        _tree->set_root(root);
+        return root;
+    }
+
+private:
+    resource_ptr resource() const
+    {
+        return _tree->_arena.resource();
+    }
+
+    void push_unchecked(node_type* n)
+    {
+        if (_size == _capacity)
+            grow();
+        _stack[_size++] = n;
+    }
+
+    void grow()
+    {
+        auto new_capacity = _capacity == 0 ? std::size_t(64) : 2 * _capacity;
+        auto new_stack    = static_cast<node_type**>(
+            resource()->allocate(new_capacity * sizeof(node_type*), alignof(node_type*)));
+
+        // Not memcpy: GCC 12 warns about the (empty) copy from the null stack of a new builder.
+        for (auto i = std::size_t(0); i != _size; ++i)
+            new_stack[i] = _stack[i];
+        if (_capacity > 0)
+            resource()->deallocate(_stack, _capacity * sizeof(node_type*), alignof(node_type*));
+
+        _stack    = new_stack;
+        _capacity = new_capacity;
+    }
+
+    tree<RootNode, MemoryResource>* _tree;
+    node_type**                     _stack;
+    std::size_t                     _size;
+    std::size_t                     _capacity;
+};
+} // namespace dryad
+
+#endif // DRYAD_TREE_BUILDER_HPP_INCLUDED
+
@@ -6,6 +6,29 @@
 #include <cstring>
 #include <doctest/doctest.h>
 
+namespace
+{
+struct counting_resource
+{
+    std::size_t allocation_count = 0;
+    std::size_t bytes_allocated  = 0;
+
+    void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        ++allocation_count;
+        bytes_allocated += bytes;
+        return dryad::_detail::default_memory_resource::allocate(bytes, alignment);
+    }
+
+    void deallocate(void* ptr, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        --allocation_count;
+        bytes_allocated -= bytes;
+        dryad::_detail::default_memory_resource::deallocate(ptr, bytes, alignment);
+    }
+};
+} // namespace
+
 TEST_CASE("arena")
 {
     dryad::arena<> arena;
@@ -55,3 +78,302 @@ TEST_CASE("arena")
     }
 }
 
+TEST_CASE("arena oversized and over-aligned allocations")
+{
+    counting_resource resource;
+    {
+        dryad::arena<counting_resource> arena(&resource);
+
+        SUBCASE("bigger than a block")
+        {
+            auto small = arena.construct<int>(42);
+
+            auto size = 4 * dryad::arena<>::default_block_size;
+            auto big  = arena.allocate(size, 1);
+            std::memset(big, 'a', size);
+            CHECK(resource.allocation_count == 2);
+            CHECK(resource.bytes_allocated > size);
+
+            auto after = arena.construct<int>(11);
+            CHECK(*small == 42);
+            CHECK(*after == 11);
+            CHECK(static_cast<char*>(big)[size - 1] == 'a');
+
+            // The dedicated block is re-used after clearing.
+            arena.clear();
+            arena.construct<int>(0);
+            CHECK(arena.allocate(size, 1) == big);
+            CHECK(resource.allocation_count == 3);
+        }
+        SUBCASE("over-aligned")
+        {
+            arena.construct<char>('a');
+            for (auto alignment : {16u, 64u, 256u, 4096u})
+            {
+                auto ptr = arena.allocate(alignment, alignment);
+                CHECK(dryad::_detail::align_offset(ptr, alignment) == 0);
+                std::memset(ptr, 'b', alignment);
+            }
+
+            struct alignas(64) simd_payload
+            {
+                unsigned char data[64];
+            };
+            auto payload = arena.construct<simd_payload>();
+            CHECK(dryad::_detail::align_offset(payload, 64) == 0);
+        }
+    }
+    CHECK(resource.allocation_count == 0);
+}
+
+TEST_CASE("arena block size and growth")
+{
+    counting_resource resource;
+
+    SUBCASE("constant")
+    {
+        dryad::arena<counting_resource> arena(&resource, 1024);
+        for (auto i = 0; i != 100; ++i)
+            arena.allocate(100, 1);
+
+        // Each block fits nine allocations.
+        CHECK(resource.allocation_count == 12);
+        CHECK(resource.bytes_allocated == 12 * 1024);
+        CHECK(arena.block_size() == 1024);
+        CHECK(arena.growth() == dryad::arena_growth::constant);
+    }
+    SUBCASE("geometric")
+    {
+        dryad::arena<counting_resource> arena(&resource, 1024, dryad::arena_growth::geometric);
+        for (auto i = 0; i != 100; ++i)
+            arena.allocate(100, 1);
+
+        // 1024 + 2048 + 4096 + 8192 bytes.
+        CHECK(resource.allocation_count == 4);
+        CHECK(resource.bytes_allocated == 15 * 1024);
+        // The block size is the one it was constructed with.
+        CHECK(arena.block_size() == 1024);
+        CHECK(arena.growth() == dryad::arena_growth::geometric);
+
+        // Re-using the blocks doesn't allocate.
+        arena.clear();
+        for (auto i = 0; i != 100; ++i)
+            arena.allocate(100, 1);
+        CHECK(resource.allocation_count == 4);
+    }
+    SUBCASE("unwind skips small blocks")
+    {
+        dryad::arena<counting_resource> arena(&resource, 1024);
+        auto marker = arena.top();
+        arena.allocate(512, 1);
+        arena.allocate(512, 1);
+        CHECK(resource.allocation_count == 2);
+
+        arena.unwind(marker);
+        auto big = arena.allocate(4096, 1);
+        std::memset(big, 'a', 4096);
+        CHECK(resource.allocation_count == 3);
+
+        // The small block is still used afterwards.
+        arena.allocate(512, 1);
+        CHECK(resource.allocation_count == 3);
+    }
+    SUBCASE("reserve")
+    {
+        dryad::arena<counting_resource> arena(&resource, 1024);
+        arena.reserve(100);
+        CHECK(resource.allocation_count == 1);
+        arena.reserve(100); // already fits
+        CHECK(resource.allocation_count == 1);
+
+        arena.reserve(100 * 100);
+        CHECK(resource.allocation_count == 2);
+        for (auto i = 0; i != 100; ++i)
+            arena.allocate(100, 1);
+        CHECK(resource.allocation_count == 2);
+    }
+}
+
+TEST_CASE("arena statistics")
+{
+    dryad::arena<> arena(1024);
+
+    auto stats = arena.statistics();
+    CHECK(stats.block_count == 0);
+    CHECK(stats.bytes_reserved == 0);
+    CHECK(stats.bytes_used == 0);
+    CHECK(stats.bytes_wasted == 0);
+    CHECK(stats.high_water_mark == 0);
+    CHECK(stats.allocation_count == 0);
+
+    arena.allocate(100, 1);
+    arena.allocate(1, 1);
+    arena.allocate(8, 8);
+    stats = arena.statistics();
+    CHECK(stats.block_count == 1);
+    CHECK(stats.bytes_reserved == 1024);
+    CHECK(stats.bytes_used == 112); // 7 bytes padding
+    CHECK(stats.bytes_wasted == 0);
+    CHECK(stats.high_water_mark == 112);
+#if DRYAD_ARENA_ALLOCATION_COUNTING
+    CHECK(stats.allocation_count == 3);
+#else
+    CHECK(stats.allocation_count == 0);
+#endif
+
+    auto marker = arena.top();
+    arena.allocate(400, 1);
+    arena.allocate(400, 1);
+    arena.allocate(400, 1); // doesn't fit, so the tail of the first block is wasted
+    stats = arena.statistics();
+    CHECK(stats.block_count == 2);
+    CHECK(stats.bytes_reserved == 2048);
+    CHECK(stats.bytes_used == 912 + 400);
+    CHECK(stats.bytes_wasted == 1024 - 4 * sizeof(void*) - 912); // block header is four words
+    CHECK(stats.high_water_mark == 912 + 400);
+
+    arena.unwind(marker);
+    stats = arena.statistics();
+    CHECK(stats.block_count == 2);
+    CHECK(stats.bytes_used == 112);
+    CHECK(stats.bytes_wasted == 0);
+    CHECK(stats.high_water_mark == 912 + 400);
+
+    arena.clear();
+    stats = arena.statistics();
+    CHECK(stats.bytes_used == 0);
+    CHECK(stats.high_water_mark == 912 + 400);
+}
+
+TEST_CASE("arena absorb")
+{
+    counting_resource               resource;
+    dryad::arena<counting_resource> arena(&resource, 1024);
+    auto                            own = static_cast<char*>(arena.allocate(100, 1));
+    std::memset(own, 'a', 100);
+
+    dryad::arena<counting_resource> other(&resource, 1024);
+    auto                            absorbed = static_cast<char*>(other.allocate(2000, 1));
+    std::memset(absorbed, 'b', 2000);
+    other.allocate(100, 1);
+    REQUIRE(resource.allocation_count == 3);
+
+    arena.absorb(DRYAD_MOV(other));
+    CHECK(resource.allocation_count == 3);
+    CHECK(other.statistics().block_count == 0);
+    CHECK(other.statistics().bytes_used == 0);
+
+    auto stats = arena.statistics();
+    CHECK(stats.block_count == 3);
+    CHECK(stats.bytes_used == 2200);
+
+    // New allocations don't touch the absorbed memory.
+    std::memset(arena.allocate(500, 1), 'c', 500);
+    CHECK(resource.allocation_count == 3);
+    for (auto i = 0; i != 100; ++i)
+        REQUIRE(own[i] == 'a');
+    for (auto i = 0; i != 2000; ++i)
+        REQUIRE(absorbed[i] == 'b');
+
+    SUBCASE("move")
+    {
+        auto moved = DRYAD_MOV(arena);
+        CHECK(moved.statistics().bytes_used == 2700);
+    }
+    SUBCASE("clear re-uses the absorbed blocks")
+    {
+        arena.clear();
+        CHECK(arena.statistics().bytes_used == 0);
+        CHECK(arena.statistics().high_water_mark == 2700);
+
+        arena.allocate(2000, 1);
+        arena.allocate(900, 1);
+        CHECK(resource.allocation_count == 3);
+
+        arena.clear(0);
+        CHECK(resource.allocation_count == 0);
+    }
+    SUBCASE("absorb an empty arena")
+    {
+        dryad::arena<counting_resource> empty(&resource);
+        arena.absorb(DRYAD_MOV(empty));
+        CHECK(arena.statistics().block_count == 3);
+    }
+}
+
+TEST_CASE("arena release memory")
+{
+    counting_resource               resource;
+    dryad::arena<counting_resource> arena(&resource, 1024);
+    for (auto i = 0; i != 100; ++i)
+        arena.allocate(100, 1);
+    REQUIRE(resource.allocation_count == 12);
+
+    SUBCASE("clear keeps everything")
+    {
+        arena.clear();
+        CHECK(resource.allocation_count == 12);
+    }
+    SUBCASE("clear with budget")
+    {
+        arena.clear(3 * 1024 + 512);
+        CHECK(resource.allocation_count == 3);
+        CHECK(arena.statistics().block_count == 3);
+        CHECK(arena.statistics().bytes_reserved == 3 * 1024);
+
+        for (auto i = 0; i != 27; ++i)
+            arena.allocate(100, 1);
+        CHECK(resource.allocation_count == 3);
+        arena.allocate(100, 1);
+        CHECK(resource.allocation_count == 4);
+    }
+    SUBCASE("clear with zero budget")
+    {
+        arena.clear(0);
+        CHECK(resource.allocation_count == 0);
+        CHECK(arena.statistics().bytes_used == 0);
+
+        arena.allocate(100, 1);
+        CHECK(resource.allocation_count == 1);
+    }
+    SUBCASE("shrink_to_fit")
+    {
+        arena.clear();
+        arena.allocate(100, 1);
+        arena.shrink_to_fit();
+        CHECK(resource.allocation_count == 1);
+
+        arena.allocate(1000, 1);
+        CHECK(resource.allocation_count == 2);
+    }
+    SUBCASE("shrink_to_fit after unwind")
+    {
+        auto marker = arena.top();
+        arena.unwind(marker);
+        arena.shrink_to_fit();
+        CHECK(resource.allocation_count == 12);
+
+        arena.clear();
+        auto empty = dryad::arena<counting_resource>::marker{nullptr, nullptr};
+        arena.unwind(empty);
+        arena.shrink_to_fit();
+        CHECK(resource.allocation_count == 0);
+    }
+}
+
+TEST_CASE("arena release memory with geometric growth")
+{
+    counting_resource               resource;
+    dryad::arena<counting_resource> arena(&resource, 1024, dryad::arena_growth::geometric);
+    for (auto i = 0; i != 1000; ++i)
+        arena.allocate(100, 1);
+
+    // Only keep the first two blocks, the next one is allocated with twice the size of the last.
+    arena.clear(3 * 1024);
+    CHECK(resource.bytes_allocated == 3 * 1024);
+    for (auto i = 0; i != 30; ++i)
+        arena.allocate(100, 1);
+    CHECK(resource.allocation_count == 3);
+    CHECK(resource.bytes_allocated == 7 * 1024);
+}
+
@@ -0,0 +1,153 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/concurrent_symbol_interner.hpp>
+
+#include <doctest/doctest.h>
+#include <string>
+#include <thread>
+#include <vector>
+
+TEST_CASE("concurrent_symbol_interner")
+{
+    dryad::concurrent_symbol_interner<void> symbols;
+    CHECK(symbols.size() == 0);
+
+    auto abc1 = symbols.intern("abc");
+    auto abc2 = symbols.intern("abc");
+    CHECK(abc1 == abc2);
+    CHECK(abc1.c_str(symbols) == doctest::String("abc"));
+
+    auto def1 = symbols.intern("def");
+    auto def2 = symbols.intern("def");
+    CHECK(def1 == def2);
+    CHECK(def1 != abc1);
+    CHECK(def1.c_str(symbols) == doctest::String("def"));
+
+    // Symbols are dense indices.
+    CHECK(abc1.id() == 0);
+    CHECK(def1.id() == 1);
+    CHECK(symbols.size() == 2);
+
+    auto ab = symbols.intern("ab");
+    CHECK(ab != abc1);
+    CHECK(ab.c_str(symbols) == doctest::String("ab"));
+    auto abcd = symbols.intern("abcd");
+    CHECK(abcd != abc1);
+    CHECK(abcd.c_str(symbols) == doctest::String("abcd"));
+
+    auto empty = symbols.intern("");
+    CHECK(empty == symbols.intern(""));
+    CHECK(empty.c_str(symbols) == doctest::String(""));
+
+    SUBCASE("many symbols")
+    {
+        std::vector<dryad::concurrent_symbol_interner<void>::symbol> result;
+        for (auto i = 0; i != 10 * 1000; ++i)
+        {
+            auto str = std::to_string(i);
+            result.push_back(symbols.intern(str.c_str(), str.size()));
+        }
+
+        for (auto i = 0; i != 10 * 1000; ++i)
+        {
+            auto str = std::to_string(i);
+            REQUIRE(symbols.intern(str.c_str(), str.size()) == result[std::size_t(i)]);
+            REQUIRE(result[std::size_t(i)].c_str(symbols) == doctest::String(str.c_str()));
+        }
+        CHECK(symbols.size() == 10 * 1000 + 5);
+    }
+}
+
+TEST_CASE("concurrent_symbol_interner with multiple threads")
+{
+    using interner = dryad::concurrent_symbol_interner<void, char, std::uint32_t>;
+    interner symbols;
+
+    constexpr auto thread_count = 4;
+    constexpr auto symbol_count = 5000;
+
+    // Every thread interns the same strings, but in a different order.
+    std::vector<std::vector<interner::symbol>> result(thread_count);
+    std::vector<std::thread>                   threads;
+    for (auto t = 0; t != thread_count; ++t)
+        threads.emplace_back([&, t] {
+            auto& thread_result = result[std::size_t(t)];
+            thread_result.resize(symbol_count);
+            for (auto i = 0; i != symbol_count; ++i)
+            {
+                auto idx = (i * 7 + t * 1013) % symbol_count;
+                auto str = "symbol" + std::to_string(idx);
+                thread_result[std::size_t(idx)] = symbols.intern(str.c_str(), str.size());
+            }
+        });
+    for (auto& thread : threads)
+        thread.join();
+
+    CHECK(symbols.size() == symbol_count);
+    for (auto i = 0; i != symbol_count; ++i)
+    {
+        auto sym = result[0][std::size_t(i)];
+        for (auto t = 1; t != thread_count; ++t)
+            REQUIRE(result[std::size_t(t)][std::size_t(i)] == sym);
+
+        auto str = "symbol" + std::to_string(i);
+        REQUIRE(sym.c_str(symbols) == doctest::String(str.c_str()));
+    }
+}
+
+namespace
+{
+// Every string has the same hash, so they all end up in the same shard and probe sequence.
+struct colliding_hash_algorithm
+{
+    colliding_hash_algorithm&& hash_bytes(const unsigned char*, std::size_t)
+    {
+        return static_cast<colliding_hash_algorithm&&>(*this);
+    }
+
+    std::uint64_t finish() &&
+    {
+        return 42;
+    }
+};
+} // namespace
+
+TEST_CASE("concurrent_symbol_interner with colliding strings")
+{
+    using interner
+        = dryad::concurrent_symbol_interner<void, char, std::uint32_t, void, colliding_hash_algorithm>;
+
+    constexpr auto thread_count = 4;
+    constexpr auto symbol_count = 100;
+
+    for (auto round = 0; round != 20; ++round)
+    {
+        interner symbols;
+
+        // Every thread interns its own strings, which race for the same empty slots.
+        std::vector<std::vector<interner::symbol>> result(thread_count);
+        std::vector<std::thread>                   threads;
+        for (auto t = 0; t != thread_count; ++t)
+            threads.emplace_back([&, t] {
+                for (auto i = 0; i != symbol_count; ++i)
+                {
+                    auto str = std::to_string(t) + "_" + std::to_string(i);
+                    result[std::size_t(t)].push_back(symbols.intern(str.c_str(), str.size()));
+                }
+            });
+        for (auto& thread : threads)
+            thread.join();
+
+        REQUIRE(symbols.size() == thread_count * symbol_count);
+        for (auto t = 0; t != thread_count; ++t)
+            for (auto i = 0; i != symbol_count; ++i)
+            {
+                auto str = std::to_string(t) + "_" + std::to_string(i);
+                auto sym = result[std::size_t(t)][std::size_t(i)];
+                REQUIRE(sym.c_str(symbols) == doctest::String(str.c_str()));
+                REQUIRE(symbols.intern(str.c_str(), str.size()) == sym);
+            }
+    }
+}
+
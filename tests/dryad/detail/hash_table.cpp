@@ -0,0 +1,404 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/_detail/hash_table.hpp>
+
+#include <doctest/doctest.h>
+#include <set>
+#include <vector>
+
+namespace
+{
+template <std::size_t HashMask>
+struct traits
+{
+    using value_type = std::size_t;
+
+    static bool is_unoccupied(std::size_t value)
+    {
+        return value >= std::size_t(-2);
+    }
+    static void fill_unoccupied(std::size_t* data, std::size_t size)
+    {
+        std::memset(data, static_cast<unsigned char>(-1), size * sizeof(std::size_t));
+    }
+
+    static bool is_equal(std::size_t entry, std::size_t value)
+    {
+        return entry == value;
+    }
+
+    static std::size_t hash(std::size_t value)
+    {
+        // Allow creating lots of collisions.
+        return value & HashMask;
+    }
+};
+
+template <typename HashTable>
+void insert(HashTable& table, std::size_t value)
+{
+    dryad::_detail::default_memory_resource resource;
+    if (table.should_rehash())
+        table.rehash(&resource);
+
+    auto entry = table.lookup_entry(value);
+    REQUIRE(!entry);
+    entry.create(value);
+    CHECK(entry);
+    CHECK(entry.get() == value);
+}
+
+template <typename HashTable>
+void check_hash_table()
+{
+    dryad::_detail::default_memory_resource resource;
+
+    HashTable table;
+    CHECK(table.size() == 0);
+    CHECK(table.capacity() == 0);
+    CHECK(table.lookup(std::size_t(0)) == nullptr);
+    CHECK(table.entries().begin() == table.entries().end());
+
+    for (auto i = std::size_t(0); i != 1000; ++i)
+        insert(table, i);
+    CHECK(table.size() == 1000);
+    CHECK(table.capacity() >= 1000);
+
+    for (auto i = std::size_t(0); i != 1000; ++i)
+    {
+        auto ptr = table.lookup(i);
+        REQUIRE(ptr != nullptr);
+        CHECK(*ptr == i);
+    }
+    for (auto i = std::size_t(1000); i != 2000; ++i)
+        CHECK(table.lookup(i) == nullptr);
+
+    std::set<std::size_t> values;
+    for (auto entry : table.entries())
+    {
+        CHECK(entry);
+        CHECK(values.insert(entry.get()).second);
+    }
+    CHECK(values.size() == 1000);
+
+    table.free(&resource);
+    CHECK(table.size() == 0);
+    CHECK(table.capacity() == 0);
+}
+
+template <typename HashTable>
+void check_erase()
+{
+    dryad::_detail::default_memory_resource resource;
+
+    HashTable table;
+    table.rehash(&resource, 2048);
+
+    // Additional data stored next to the table, which needs to follow the entries that are moved.
+    std::vector<std::size_t> payload(table.capacity());
+    for (auto i = std::size_t(0); i != 1000; ++i)
+    {
+        insert(table, i);
+        payload[table.lookup_entry(i).index()] = i;
+    }
+
+    // Remove every other value.
+    for (auto i = std::size_t(0); i < 1000; i += 2)
+    {
+        auto entry = table.lookup_entry(i);
+        REQUIRE(entry);
+        entry.erase([&](std::size_t old_idx, std::size_t new_idx) {
+            payload[new_idx] = payload[old_idx];
+        });
+        CHECK(!entry);
+    }
+    CHECK(table.size() == 500);
+
+    for (auto i = std::size_t(0); i != 1000; ++i)
+    {
+        auto entry = table.lookup_entry(i);
+        if (i % 2 == 0)
+            CHECK(!entry);
+        else
+        {
+            REQUIRE(entry);
+            CHECK(payload[entry.index()] == i);
+        }
+    }
+
+    table.free(&resource);
+}
+
+// Erases every value divisible by three in a single pass over the table.
+template <typename HashTable>
+void check_erase_if(const std::vector<std::size_t>& values)
+{
+    dryad::_detail::default_memory_resource resource;
+
+    HashTable table;
+    for (auto value : values)
+        insert(table, value);
+
+    std::vector<std::size_t> payload(table.capacity());
+    for (auto value : values)
+        payload[table.lookup_entry(value).index()] = value;
+
+    std::multiset<std::size_t> visited;
+    table.erase_if(
+        [&](auto entry) {
+            CHECK(payload[entry.index()] == entry.get());
+            visited.insert(entry.get());
+            return entry.get() % 3 == 0;
+        },
+        [&](std::size_t old_idx, std::size_t new_idx) { payload[new_idx] = payload[old_idx]; });
+
+    // Every value is visited exactly once, even if it has been moved.
+    CHECK(visited.size() == values.size());
+    auto erased = std::size_t(0);
+    for (auto value : values)
+    {
+        CHECK(visited.count(value) == 1);
+
+        auto entry = table.lookup_entry(value);
+        if (value % 3 == 0)
+        {
+            CHECK(!entry);
+            ++erased;
+        }
+        else
+        {
+            REQUIRE(entry);
+            CHECK(payload[entry.index()] == value);
+        }
+    }
+    CHECK(table.size() == values.size() - erased);
+
+    table.free(&resource);
+}
+
+std::vector<std::size_t> make_values(std::size_t count)
+{
+    std::vector<std::size_t> result;
+    for (auto i = std::size_t(0); i != count; ++i)
+        result.push_back(i);
+    return result;
+}
+
+// Values that all hash to the last slot of the smallest table, so their cluster wraps around.
+std::vector<std::size_t> make_wrapping_values()
+{
+    std::vector<std::size_t> result;
+    for (auto i = std::size_t(0); i != 10; ++i)
+        result.push_back(63 + 64 * i);
+    return result;
+}
+
+// Keeps a sliding window of values in the table, removing the oldest one before every insertion.
+template <typename HashTable>
+void check_churn()
+{
+    dryad::_detail::default_memory_resource resource;
+
+    HashTable table;
+    for (auto i = std::size_t(0); i != 100; ++i)
+        insert(table, i);
+    auto capacity = table.capacity();
+
+    for (auto i = std::size_t(0); i != 10 * 1000; ++i)
+    {
+        auto entry = table.lookup_entry(i);
+        REQUIRE(entry);
+        entry.remove();
+        insert(table, i + 100);
+    }
+
+    // Removed slots are reclaimed, so the table doesn't grow.
+    CHECK(table.size() == 100);
+    CHECK(table.capacity() == capacity);
+    CHECK(table.removed() < table.capacity() - table.capacity() / 8);
+    for (auto i = std::size_t(0); i != 10 * 1000; ++i)
+        CHECK(table.lookup(i) == nullptr);
+    for (auto i = std::size_t(10 * 1000); i != 10 * 1000 + 100; ++i)
+        CHECK(table.lookup(i) != nullptr);
+
+    table.free(&resource);
+}
+
+template <template <typename, std::size_t> typename HashTable>
+void check_statistics(std::size_t collision_total, std::size_t collision_max,
+                      std::size_t expected_removed)
+{
+    dryad::_detail::default_memory_resource resource;
+
+    SUBCASE("empty")
+    {
+        HashTable<traits<std::size_t(-1)>, 64> table;
+
+        auto stats = table.statistics();
+        CHECK(stats.size == 0);
+        CHECK(stats.capacity == 0);
+        CHECK(stats.total_probe_length == 0);
+        CHECK(stats.average_probe_length() == 0.0);
+    }
+    SUBCASE("distinct hashes")
+    {
+        HashTable<traits<std::size_t(-1)>, 64> table;
+        for (auto i = std::size_t(0); i != 100; ++i)
+            insert(table, i);
+
+        // Every entry is in its home slot.
+        auto stats = table.statistics();
+        CHECK(stats.size == 100);
+        CHECK(stats.capacity == table.capacity());
+        CHECK(stats.removed == 0);
+        CHECK(stats.total_probe_length == 100);
+        CHECK(stats.max_probe_length == 1);
+        CHECK(stats.average_probe_length() == 1.0);
+
+        for (auto i = std::size_t(0); i != 10; ++i)
+            table.lookup_entry(i).remove();
+        CHECK(table.statistics().removed == expected_removed);
+        CHECK(table.statistics().total_probe_length == 90);
+
+        table.free(&resource);
+    }
+    SUBCASE("same hash")
+    {
+        HashTable<traits<0>, 64> table;
+        for (auto i = std::size_t(0); i != 100; ++i)
+            insert(table, i);
+
+        auto stats = table.statistics();
+        CHECK(stats.size == 100);
+        CHECK(stats.total_probe_length == collision_total);
+        CHECK(stats.max_probe_length == collision_max);
+
+        table.free(&resource);
+    }
+#if DRYAD_HASH_TABLE_STATISTICS
+    SUBCASE("counters")
+    {
+        HashTable<traits<std::size_t(-1)>, 64> table;
+        for (auto i = std::size_t(0); i != 100; ++i)
+            insert(table, i);
+
+        auto stats = table.statistics();
+        // The initial allocation of 64 slots and at least one growth.
+        CHECK(stats.rehash_count >= 2);
+        CHECK(stats.rehash_count <= 3);
+        CHECK(stats.lookup_count == 100);
+        CHECK(stats.lookup_probe_length == 100);
+
+        // Unsuccessful lookups count as well.
+        CHECK(table.lookup(std::size_t(1000)) == nullptr);
+        stats = table.statistics();
+        CHECK(stats.lookup_count == 101);
+        CHECK(stats.average_lookup_probe_length() >= 1.0);
+
+        table.free(&resource);
+    }
+#endif
+}
+} // namespace
+
+TEST_CASE("_detail::linear_hash_table")
+{
+    check_hash_table<dryad::_detail::linear_hash_table<traits<std::size_t(-1)>, 64>>();
+    check_hash_table<dryad::_detail::linear_hash_table<traits<0xF>, 64>>();
+
+    check_erase<dryad::_detail::linear_hash_table<traits<std::size_t(-1)>, 64>>();
+    check_erase<dryad::_detail::linear_hash_table<traits<0xFF>, 64>>();
+    check_erase<dryad::_detail::linear_hash_table<traits<0>, 64>>();
+
+    check_erase_if<dryad::_detail::linear_hash_table<traits<std::size_t(-1)>, 64>>(
+        make_values(1000));
+    check_erase_if<dryad::_detail::linear_hash_table<traits<0xFF>, 64>>(make_values(1000));
+    check_erase_if<dryad::_detail::linear_hash_table<traits<std::size_t(-1)>, 64>>(
+        make_wrapping_values());
+
+    check_churn<dryad::_detail::linear_hash_table<traits<std::size_t(-1)>, 64>>();
+    check_churn<dryad::_detail::linear_hash_table<traits<0xF>, 64>>();
+
+    SUBCASE("remove")
+    {
+        dryad::_detail::default_memory_resource          resource;
+        dryad::_detail::linear_hash_table<traits<0>, 64> table;
+        for (auto i = std::size_t(0); i != 10; ++i)
+            insert(table, i);
+
+        // The entries of the cluster after the removed one are still found.
+        table.lookup_entry(std::size_t(0)).remove();
+        for (auto i = std::size_t(1); i != 10; ++i)
+            CHECK(table.lookup(i) != nullptr);
+        CHECK(table.removed() == 0);
+        CHECK(table.statistics().total_probe_length == 9 * 10 / 2);
+
+        table.free(&resource);
+    }
+
+    // Probe lengths 1 to 100; removing never leaves markers behind.
+    check_statistics<dryad::_detail::linear_hash_table>(5050, 100, 0);
+}
+
+TEST_CASE("_detail::group_hash_table")
+{
+    check_hash_table<dryad::_detail::group_hash_table<traits<std::size_t(-1)>, 64>>();
+    check_hash_table<dryad::_detail::group_hash_table<traits<0xF>, 64>>();
+    check_hash_table<dryad::_detail::group_hash_table<traits<0>, 64>>();
+
+    check_erase<dryad::_detail::group_hash_table<traits<std::size_t(-1)>, 64>>();
+    check_erase<dryad::_detail::group_hash_table<traits<0xFF>, 64>>();
+
+    check_erase_if<dryad::_detail::group_hash_table<traits<std::size_t(-1)>, 64>>(
+        make_values(1000));
+    check_erase_if<dryad::_detail::group_hash_table<traits<0xFF>, 64>>(make_values(1000));
+    check_erase_if<dryad::_detail::group_hash_table<traits<std::size_t(-1)>, 64>>(
+        make_wrapping_values());
+
+    check_churn<dryad::_detail::group_hash_table<traits<std::size_t(-1)>, 64>>();
+    check_churn<dryad::_detail::group_hash_table<traits<0xF>, 64>>();
+    check_churn<dryad::_detail::group_hash_table<traits<0>, 64>>();
+
+    // Six full groups and four entries in the seventh group of the probe sequence.
+    // Removed slots are marked as empty as every group still has an empty slot.
+    check_statistics<dryad::_detail::group_hash_table>(6 * 7 / 2 * 16 + 4 * 7, 7, 0);
+
+    SUBCASE("remove")
+    {
+        dryad::_detail::default_memory_resource            resource;
+        dryad::_detail::group_hash_table<traits<0xFF>, 64> table;
+        for (auto i = std::size_t(0); i != 1000; ++i)
+            insert(table, i);
+
+        // Remove every other value.
+        for (auto i = std::size_t(0); i < 1000; i += 2)
+        {
+            auto entry = table.lookup_entry(i);
+            REQUIRE(entry);
+            entry.remove();
+            CHECK(!entry);
+        }
+        CHECK(table.size() == 500);
+
+        for (auto i = std::size_t(0); i != 1000; ++i)
+        {
+            if (i % 2 == 0)
+                CHECK(table.lookup(i) == nullptr);
+            else
+                CHECK(table.lookup(i) != nullptr);
+        }
+
+        // Insert them again, re-using removed slots.
+        auto capacity = table.capacity();
+        for (auto i = std::size_t(0); i < 1000; i += 2)
+            insert(table, i);
+        CHECK(table.size() == 1000);
+        CHECK(table.capacity() == capacity);
+
+        for (auto i = std::size_t(0); i != 1000; ++i)
+            CHECK(table.lookup(i) != nullptr);
+
+        table.free(&resource);
+    }
+}
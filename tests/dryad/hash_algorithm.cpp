@@ -0,0 +1,60 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/hash_algorithm.hpp>
+
+#include <doctest/doctest.h>
+#include <set>
+#include <string>
+
+namespace
+{
+template <typename HashAlgorithm>
+std::uint64_t hash_bytes(const std::string& str)
+{
+    return HashAlgorithm()
+        .hash_bytes(reinterpret_cast<const unsigned char*>(str.data()), str.size())
+        .finish();
+}
+
+template <typename HashAlgorithm>
+void check_hash_algorithm()
+{
+    // Strings of all interesting lengths, in particular around the block sizes.
+    std::string             str;
+    std::set<std::uint64_t> hashes;
+    for (auto i = 0u; i != 200; ++i)
+    {
+        auto hash = hash_bytes<HashAlgorithm>(str);
+        CHECK(hash == hash_bytes<HashAlgorithm>(str));
+        CHECK(hash == HashAlgorithm().hash_c_str(str.c_str()).finish());
+        CHECK(hashes.insert(hash).second);
+
+        str.push_back(char('a' + i % 26));
+    }
+
+    // Strings that only differ in a single character.
+    for (auto i = 0u; i != str.size(); ++i)
+    {
+        auto copy = str;
+        copy[i]   = '0';
+        CHECK(hashes.insert(hash_bytes<HashAlgorithm>(copy)).second);
+    }
+
+    // Scalars.
+    CHECK(HashAlgorithm().hash_scalar(1).finish() == HashAlgorithm().hash_scalar(1).finish());
+    CHECK(HashAlgorithm().hash_scalar(1).finish() != HashAlgorithm().hash_scalar(2).finish());
+    CHECK(HashAlgorithm().hash_scalar(1).hash_scalar(2).finish()
+          != HashAlgorithm().hash_scalar(2).hash_scalar(1).finish());
+}
+} // namespace
+
+TEST_CASE("default_hash_algorithm")
+{
+    check_hash_algorithm<dryad::default_hash_algorithm>();
+}
+
+TEST_CASE("wyhash_algorithm")
+{
+    check_hash_algorithm<dryad::wyhash_algorithm>();
+}
@@ -5,6 +5,7 @@
 
 #include <doctest/doctest.h>
 #include <dryad/tree.hpp>
+#include <vector>
 
 namespace
 {
@@ -93,5 +94,148 @@ TEST_CASE("hash_forest")
     CHECK(leaf1 == leaf2);
     auto leaf3 = forest.lookup_or_create<leaf_node>(2);
     CHECK(leaf3 != leaf1);
+
+    CHECK(forest.root_allocated_bytes() >= forest.root_capacity() * sizeof(node*));
+    CHECK(forest.memory_statistics().block_count == 1);
+    CHECK(forest.memory_statistics().bytes_used > 0);
+}
+
+namespace
+{
+template <typename Probing>
+void check_rehash()
+{
+    using forest_type
+        = dryad::hash_forest<node, node_hasher, void, dryad::default_hash_algorithm, Probing>;
+    forest_type forest;
+
+    std::vector<node*> roots;
+    for (auto i = 0; i != 1000; ++i)
+        roots.push_back(forest.build([&](typename forest_type::node_creator creator) {
+            auto a = creator.template create<leaf_node>(i);
+            auto b = creator.template create<leaf_node>(i / 2);
+            return creator.template create<container_node>(a, b);
+        }));
+    CHECK(forest.root_count() == 1000);
+    CHECK(forest.root_capacity() >= 1000);
+    CHECK(forest.root_table_statistics().size == 1000);
+    CHECK(forest.root_table_statistics().capacity == forest.root_capacity());
+
+    for (auto i = 0; i != 1000; ++i)
+    {
+        auto root = forest.build([&](typename forest_type::node_creator creator) {
+            auto a = creator.template create<leaf_node>(i);
+            auto b = creator.template create<leaf_node>(i / 2);
+            return creator.template create<container_node>(a, b);
+        });
+        REQUIRE(root == roots[std::size_t(i)]);
+    }
+    CHECK(forest.root_count() == 1000);
+}
+} // namespace
+
+TEST_CASE("hash_forest rehash")
+{
+    check_rehash<dryad::linear_probing>();
+}
+TEST_CASE("hash_forest rehash with group probing")
+{
+    check_rehash<dryad::group_probing>();
+}
+
+namespace
+{
+// A DAG, subtrees are shared by storing pointers to other roots.
+enum class dag_kind
+{
+    leaf,
+    pointer,
+};
+
+using dag_node = dryad::node<dag_kind>;
+
+struct dag_leaf : dryad::basic_node<dag_kind::leaf>
+{
+    int data;
+
+    dag_leaf(dryad::node_ctor ctor, int i) : node_base(ctor), data(i) {}
+};
+
+struct dag_pointer : dryad::basic_node<dag_kind::pointer>
+{
+    const dag_node* pointee;
+
+    dag_pointer(dryad::node_ctor ctor, const dag_node* pointee) : node_base(ctor), pointee(pointee)
+    {}
+};
+
+struct dag_hasher : dryad::node_hasher_base<dag_hasher, dag_leaf, dag_pointer>
+{
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, const dag_leaf* n)
+    {
+        hasher.hash_scalar(n->data);
+    }
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, const dag_pointer* n)
+    {
+        hasher.hash_scalar(n->pointee);
+    }
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, int data)
+    {
+        hasher.hash_scalar(data);
+    }
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, const dag_node* pointee)
+    {
+        hasher.hash_scalar(pointee);
+    }
+
+    static bool is_equal(const dag_leaf* lhs, const dag_leaf* rhs)
+    {
+        return lhs->data == rhs->data;
+    }
+    static bool is_equal(const dag_pointer* lhs, const dag_pointer* rhs)
+    {
+        return lhs->pointee == rhs->pointee;
+    }
+    static bool is_equal(const dag_leaf* entry, int data)
+    {
+        return entry->data == data;
+    }
+    static bool is_equal(const dag_pointer* entry, const dag_node* pointee)
+    {
+        return entry->pointee == pointee;
+    }
+};
+} // namespace
+
+TEST_CASE("hash_forest as DAG")
+{
+    dryad::hash_forest<dag_node, dag_hasher> forest;
+
+    std::vector<const dag_node*> pointers;
+    for (auto i = 0; i != 100; ++i)
+    {
+        const dag_node* cur = forest.lookup_or_create<dag_leaf>(i);
+        for (auto depth = 0; depth != 10; ++depth)
+        {
+            cur = forest.lookup_or_create<dag_pointer>(cur);
+            pointers.push_back(cur);
+        }
+    }
+    CHECK(forest.root_count() == 100 * 11);
+
+    for (auto i = 0; i != 100; ++i)
+    {
+        const dag_node* cur = forest.lookup_or_create<dag_leaf>(i);
+        for (auto depth = 0; depth != 10; ++depth)
+        {
+            cur = forest.lookup_or_create<dag_pointer>(cur);
+            REQUIRE(cur == pointers[std::size_t(i * 10 + depth)]);
+        }
+    }
+    CHECK(forest.root_count() == 100 * 11);
 }
 
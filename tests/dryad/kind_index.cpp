@@ -0,0 +1,167 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/kind_index.hpp>
+
+#include <doctest/doctest.h>
+#include <vector>
+
+namespace
+{
+enum class node_kind
+{
+    leaf,
+    value,
+    container,
+    unused,
+};
+
+using node = dryad::node<node_kind>;
+
+struct leaf_node : dryad::basic_node<node_kind::leaf>
+{
+    DRYAD_NODE_CTOR(leaf_node);
+};
+
+struct value_node : dryad::basic_node<node_kind::value>
+{
+    int value;
+
+    value_node(dryad::node_ctor ctor, int value) : node_base(ctor), value(value) {}
+};
+
+struct container_node : dryad::basic_node<node_kind::container, dryad::container_node<node>>
+{
+    DRYAD_NODE_CTOR(container_node);
+
+    void insert_front(node* n)
+    {
+        this->insert_child_after(nullptr, n);
+    }
+};
+
+template <typename Creator>
+container_node* make_tree(Creator& creator, int first, int count)
+{
+    auto result = creator.template create<container_node>();
+    for (auto i = count - 1; i >= 0; --i)
+    {
+        auto child = creator.template create<container_node>();
+        child->insert_front(creator.template create<leaf_node>());
+        child->insert_front(creator.template create<value_node>(first + i));
+        result->insert_front(child);
+    }
+    result->insert_front(creator.template create<container_node>()); // empty container
+    return result;
+}
+
+template <typename T, typename Index>
+std::vector<const node*> collect(const Index& index)
+{
+    std::vector<const node*> result;
+    for (auto n : dryad::nodes_of_kind<T>(index))
+        result.push_back(n);
+    return result;
+}
+
+// The nodes of type T in pre-order, found by traversing.
+template <typename T>
+std::vector<const node*> traverse_kind(node* root)
+{
+    std::vector<const node*> result;
+    for (auto [ev, n] : dryad::traverse(root))
+        if (ev != dryad::traverse_event::exit && dryad::node_has_kind<T>(n))
+            result.push_back(n);
+    return result;
+}
+} // namespace
+
+TEST_CASE("kind_index")
+{
+    dryad::tree<container_node> tree;
+
+    SUBCASE("empty")
+    {
+        dryad::kind_index<node_kind> index(tree);
+        CHECK(index.empty());
+        CHECK(index.size() == 0);
+        CHECK(index.count(node_kind::leaf) == 0);
+        CHECK(dryad::nodes_of_kind<leaf_node>(index).empty());
+    }
+
+    tree.set_root(make_tree(tree, 0, 100));
+
+    dryad::kind_index<node_kind> index(tree);
+    CHECK(!index.empty());
+    CHECK(index.size() == 1 + 1 + 3 * 100);
+    CHECK(index.allocated_bytes() > 0);
+
+    CHECK(index.count(node_kind::leaf) == 100);
+    CHECK(index.count(node_kind::value) == 100);
+    CHECK(index.count(node_kind::container) == 102);
+    CHECK(index.count(node_kind::unused) == 0);
+    CHECK(index.nodes(node_kind::unused).empty());
+
+    CHECK(collect<leaf_node>(index) == traverse_kind<leaf_node>(tree.root()));
+    CHECK(collect<container_node>(index) == traverse_kind<container_node>(tree.root()));
+    CHECK(index.nodes(node_kind::container).front() == tree.root());
+
+    auto i = 0;
+    for (auto n : dryad::nodes_of_kind<value_node>(index))
+    {
+        CHECK(n->value == i);
+        n->value = -n->value;
+        ++i;
+    }
+    CHECK(i == 100);
+    CHECK(dryad::node_cast<value_node>(index.nodes(node_kind::value).front())->value == 0);
+    CHECK(dryad::nodes_of_kind<value_node>(index).front()->value == 0);
+
+    SUBCASE("subtree")
+    {
+        auto child = tree.root()->children().front();
+        index.rebuild(child);
+        CHECK(index.size() == 1);
+        CHECK(index.count(node_kind::container) == 1);
+        CHECK(index.count(node_kind::value) == 0);
+
+        index.rebuild(nullptr);
+        CHECK(index.empty());
+        CHECK(index.count(node_kind::container) == 0);
+    }
+    SUBCASE("move")
+    {
+        auto other = DRYAD_MOV(index);
+        CHECK(index.empty());
+        CHECK(other.count(node_kind::leaf) == 100);
+
+        index = DRYAD_MOV(other);
+        CHECK(index.count(node_kind::leaf) == 100);
+    }
+    SUBCASE("clear")
+    {
+        index.clear();
+        CHECK(index.empty());
+        CHECK(index.allocated_bytes() == 0);
+        CHECK(dryad::nodes_of_kind<value_node>(index).empty());
+    }
+}
+
+TEST_CASE("kind_index forest")
+{
+    dryad::forest<container_node> forest;
+    auto                          first  = make_tree(forest, 0, 3);
+    auto                          second = make_tree(forest, 3, 5);
+    forest.insert_root(first);
+    forest.insert_root(second);
+
+    dryad::kind_index<node_kind> index(forest);
+    CHECK(index.size() == 2 * 2 + 3 * 8);
+
+    // The nodes of each kind are ordered by root.
+    auto expected = traverse_kind<value_node>(first);
+    for (auto n : traverse_kind<value_node>(second))
+        expected.push_back(n);
+    CHECK(collect<value_node>(index) == expected);
+}
+
@@ -0,0 +1,190 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/memory_resource.hpp>
+
+#include <cstring>
+#include <doctest/doctest.h>
+#include <dryad/parallel_visit.hpp>
+#include <dryad/symbol.hpp>
+#include <dryad/symbol_table.hpp>
+#include <set>
+#include <string>
+#include <vector>
+
+TEST_CASE("block_pool_resource")
+{
+    dryad::block_pool_resource<> pool;
+    CHECK(pool == pool);
+    CHECK(pool.block_count() == 0);
+
+    SUBCASE("recycle")
+    {
+        auto a = pool.allocate(pool.block_size, alignof(void*));
+        auto b = pool.allocate(pool.block_size, alignof(void*));
+        CHECK(a != b);
+        CHECK(pool.block_count() == 2);
+
+        pool.deallocate(a, pool.block_size, alignof(void*));
+        auto c = pool.allocate(pool.block_size, alignof(void*));
+        CHECK(c == a);
+        CHECK(pool.block_count() == 2);
+
+        pool.deallocate(b, pool.block_size, alignof(void*));
+        pool.deallocate(c, pool.block_size, alignof(void*));
+    }
+    SUBCASE("many blocks")
+    {
+        // Spans multiple slabs.
+        std::vector<void*> blocks;
+        for (auto i = 0; i != 100; ++i)
+        {
+            auto block = pool.allocate(pool.block_size, alignof(std::max_align_t));
+            CHECK(reinterpret_cast<std::uintptr_t>(block) % alignof(std::max_align_t) == 0);
+            std::memset(block, i, pool.block_size);
+            blocks.push_back(block);
+        }
+        CHECK(std::set<void*>(blocks.begin(), blocks.end()).size() == 100);
+        for (auto i = 0; i != 100; ++i)
+            CHECK(static_cast<unsigned char*>(blocks[std::size_t(i)])[pool.block_size - 1] == i);
+
+        for (auto block : blocks)
+            pool.deallocate(block, pool.block_size, alignof(std::max_align_t));
+        for (auto i = 0; i != 100; ++i)
+            blocks[std::size_t(i)] = pool.allocate(pool.block_size, alignof(std::max_align_t));
+        CHECK(pool.block_count() == 100);
+        CHECK(std::set<void*>(blocks.begin(), blocks.end()).size() == 100);
+
+        for (auto block : blocks)
+            pool.deallocate(block, pool.block_size, alignof(std::max_align_t));
+    }
+    SUBCASE("other sizes")
+    {
+        auto ptr = pool.allocate(100, alignof(void*));
+        pool.deallocate(ptr, 100, alignof(void*));
+        CHECK(pool.block_count() == 0);
+    }
+    SUBCASE("arena")
+    {
+        {
+            dryad::arena<dryad::block_pool_resource<>> arena(&pool);
+            for (auto i = 0; i != 1000; ++i)
+                arena.allocate(1024, alignof(void*));
+            CHECK(arena.statistics().block_count == pool.block_count());
+        }
+
+        auto count = pool.block_count();
+        {
+            // The second arena re-uses the blocks of the first one.
+            dryad::arena<dryad::block_pool_resource<>> arena(&pool);
+            for (auto i = 0; i != 1000; ++i)
+                arena.allocate(1024, alignof(void*));
+        }
+        CHECK(pool.block_count() == count);
+    }
+    SUBCASE("threads")
+    {
+        // Every task repeatedly allocates and frees blocks, all of them must be distinct.
+        std::vector<std::vector<void*>> blocks(8);
+        dryad::thread_executor(4)(blocks.size(), [&](std::size_t i) {
+            for (auto round = 0; round != 100; ++round)
+            {
+                for (auto j = 0; j != 10; ++j)
+                {
+                    auto block = pool.allocate(pool.block_size, alignof(void*));
+                    *static_cast<std::size_t*>(block) = i;
+                    blocks[i].push_back(block);
+                }
+                for (auto block : blocks[i])
+                    if (*static_cast<std::size_t*>(block) != i)
+                        blocks[i].front() = nullptr; // checked below
+
+                if (round != 99)
+                {
+                    for (auto block : blocks[i])
+                        pool.deallocate(block, pool.block_size, alignof(void*));
+                    blocks[i].clear();
+                }
+            }
+        });
+
+        std::set<void*> all;
+        for (auto& task : blocks)
+        {
+            CHECK(task.front() != nullptr);
+            all.insert(task.begin(), task.end());
+        }
+        CHECK(all.size() == 80);
+        CHECK(pool.block_count() <= 80);
+
+        for (auto block : all)
+            pool.deallocate(block, pool.block_size, alignof(void*));
+    }
+}
+
+TEST_CASE("monotonic_buffer_resource")
+{
+    alignas(std::max_align_t) unsigned char buffer[256];
+    dryad::monotonic_buffer_resource resource(buffer);
+    CHECK(resource == resource);
+    CHECK(resource.bytes_used() == 0);
+
+    SUBCASE("allocate")
+    {
+        auto a = resource.allocate(1, 1);
+        CHECK(a == buffer);
+        auto b = resource.allocate(8, 8);
+        CHECK(b == buffer + 8);
+        CHECK(resource.bytes_used() == 16);
+
+        // Not the latest allocation, so the memory isn't re-used.
+        resource.deallocate(a, 1, 1);
+        CHECK(resource.bytes_used() == 16);
+
+        resource.deallocate(b, 8, 8);
+        CHECK(resource.bytes_used() == 8);
+
+        resource.release();
+        CHECK(resource.bytes_used() == 0);
+        CHECK(resource.allocate(1, 1) == buffer);
+    }
+    SUBCASE("exhausted")
+    {
+        auto a = resource.allocate(200, 8);
+        CHECK(a == buffer);
+
+        auto b = resource.allocate(100, 8);
+        CHECK(b != nullptr);
+        CHECK((b < buffer || b >= buffer + 256));
+        CHECK(resource.bytes_used() == 200);
+
+        resource.deallocate(b, 100, 8);
+        resource.deallocate(a, 200, 8);
+        CHECK(resource.bytes_used() == 0);
+    }
+    SUBCASE("symbol_table")
+    {
+        dryad::symbol_interner<void>     symbols;
+        std::vector<dryad::symbol<void>> syms;
+        for (auto i = 0; i != 64; ++i)
+        {
+            auto str = std::to_string(i);
+            syms.push_back(symbols.intern(str.c_str(), str.size()));
+        }
+
+        alignas(std::max_align_t) unsigned char table_buffer[4096];
+        dryad::monotonic_buffer_resource        table_resource(table_buffer);
+        {
+            dryad::symbol_table<dryad::symbol<void>, const int*, dryad::monotonic_buffer_resource>
+                table(&table_resource);
+
+            int decls[64] = {};
+            for (auto i = 0; i != 64; ++i)
+                table.insert_or_shadow(syms[std::size_t(i)], &decls[i]);
+            for (auto i = 0; i != 64; ++i)
+                CHECK(table.lookup(syms[std::size_t(i)]) == &decls[i]);
+            CHECK(table_resource.bytes_used() > 0);
+        }
+    }
+}
+
@@ -47,6 +47,10 @@ struct container_node : dryad::basic_node<node_kind::container, dryad::container
     DRYAD_CHILD_NODE_GETTER(leaf_node, second, first())
     DRYAD_CHILD_NODE_GETTER(leaf_node, third, second())
 };
+
+// Two pointers plus kind and user data.
+static_assert(sizeof(node) == 2 * sizeof(void*) + 2 * sizeof(std::uint32_t));
+static_assert(sizeof(leaf_node) == sizeof(node));
 } // namespace
 
 TEST_CASE("node")
@@ -4,8 +4,10 @@
 #include <dryad/node_map.hpp>
 
 #include <doctest/doctest.h>
+#include <dryad/hash_algorithm.hpp>
 #include <dryad/tree.hpp>
 #include <string>
+#include <vector>
 
 namespace
 {
@@ -38,6 +40,7 @@ TEST_CASE("node_map")
     CHECK(map.empty());
     CHECK(map.size() == 0);
     CHECK(map.capacity() == 0);
+    CHECK(map.allocated_bytes() == 0);
 
     SUBCASE("initial rehash")
     {
@@ -45,6 +48,7 @@ TEST_CASE("node_map")
         CHECK(map.empty());
         CHECK(map.size() == 0);
         CHECK(map.capacity() >= 10);
+        CHECK(map.allocated_bytes() >= map.capacity() * (sizeof(node*) + sizeof(std::string)));
     }
     SUBCASE("move")
     {
@@ -125,6 +129,7 @@ TEST_CASE("node_set")
         CHECK(set.empty());
         CHECK(set.size() == 0);
         CHECK(set.capacity() >= 10);
+        CHECK(set.allocated_bytes() >= set.capacity() * sizeof(node*));
     }
     SUBCASE("move")
     {
@@ -156,3 +161,208 @@ TEST_CASE("node_set")
     CHECK(!set.contains(c));
 }
 
+TEST_CASE("node_map small mode")
+{
+    using map_type = dryad::node_map<node, int>;
+    static_assert(map_type::small_capacity > 0);
+    static_assert(dryad::node_map<node, std::string>::small_capacity == 0);
+
+    dryad::tree<node>  tree;
+    std::vector<node*> nodes;
+    for (auto i = std::size_t(0); i != map_type::small_capacity + 1; ++i)
+        nodes.push_back(tree.create<node>());
+
+    map_type map;
+    for (auto i = std::size_t(0); i != map_type::small_capacity; ++i)
+        CHECK(map.insert(nodes[i], int(i)));
+    CHECK(!map.insert(nodes[0], -1));
+    CHECK(map.size() == map_type::small_capacity);
+    CHECK(map.capacity() == 0);
+    CHECK(map.allocated_bytes() == 0);
+    CHECK(map.table_statistics().size == 0);
+
+    // Removing moves the last entry into the hole.
+    CHECK(map.remove(nodes[1]));
+    CHECK(!map.remove(nodes[1]));
+    CHECK(!map.contains(nodes[1]));
+    CHECK(*map.lookup(nodes[map_type::small_capacity - 1]) == int(map_type::small_capacity - 1));
+    CHECK(map.insert(nodes[1], 0));
+    CHECK(!map.insert_or_update(nodes[1], 1));
+    CHECK(map.lookup_entry(nodes[1]).value() == 1);
+    CHECK(map.capacity() == 0);
+
+    SUBCASE("move")
+    {
+        map_type other(DRYAD_MOV(map));
+        CHECK(map.empty());
+        map = DRYAD_MOV(other);
+    }
+
+    // One more entry switches to the hash table.
+    CHECK(map.insert(nodes.back(), int(nodes.size() - 1)));
+    CHECK(map.size() == nodes.size());
+    CHECK(map.capacity() > map_type::small_capacity);
+    CHECK(map.allocated_bytes() > 0);
+    CHECK(map.table_statistics().size == nodes.size());
+    CHECK(map.table_statistics().capacity == map.capacity());
+    for (auto i = std::size_t(0); i != nodes.size(); ++i)
+    {
+        REQUIRE(map.contains(nodes[i]));
+        CHECK(*map.lookup(nodes[i]) == int(i));
+    }
+
+    dryad::node_set<node> set;
+    for (auto n : nodes)
+        CHECK(set.insert(n));
+    CHECK(set.remove(nodes[0]));
+    CHECK(!set.contains(nodes[0]));
+    CHECK(set.size() == nodes.size() - 1);
+}
+
+TEST_CASE("node_map with custom hash algorithm")
+{
+    dryad::tree<node> tree;
+
+    dryad::node_map<const node, int, void, dryad::wyhash_algorithm> map;
+    std::vector<node*>                                               nodes;
+    for (auto i = 0; i != 1000; ++i)
+    {
+        nodes.push_back(tree.create<node>());
+        CHECK(map.insert(nodes.back(), i));
+    }
+
+    for (auto i = 0; i != 1000; ++i)
+    {
+        REQUIRE(map.contains(nodes[std::size_t(i)]));
+        CHECK(*map.lookup(nodes[std::size_t(i)]) == i);
+    }
+}
+
+namespace
+{
+template <typename Probing>
+void check_churn()
+{
+    dryad::tree<node>  tree;
+    std::vector<node*> nodes;
+    for (auto i = 0; i != 10 * 1000; ++i)
+        nodes.push_back(tree.create<node>());
+
+    // Keep a sliding window of 100 nodes in the map; the values need to follow moved entries.
+    dryad::node_map<node, std::string, void, dryad::wyhash_algorithm, Probing> map;
+    for (auto i = std::size_t(0); i != 100; ++i)
+        map.insert(nodes[i], std::to_string(i));
+    auto capacity = map.capacity();
+
+    for (auto i = std::size_t(0); i + 100 != nodes.size(); ++i)
+    {
+        CHECK(map.remove(nodes[i]));
+        CHECK(map.insert(nodes[i + 100], std::to_string(i + 100)));
+    }
+
+    // The group probing table might grow once if the window fills most of it; afterwards,
+    // removed slots are dropped by rehashing at the same capacity.
+    CHECK(map.size() == 100);
+    CHECK(map.capacity() <= 2 * capacity);
+    for (auto i = std::size_t(0); i != nodes.size(); ++i)
+    {
+        if (i < nodes.size() - 100)
+            CHECK(!map.contains(nodes[i]));
+        else
+        {
+            REQUIRE(map.contains(nodes[i]));
+            CHECK(*map.lookup(nodes[i]) == std::to_string(i));
+        }
+    }
+}
+} // namespace
+
+TEST_CASE("node_map churn")
+{
+    check_churn<dryad::linear_probing>();
+}
+TEST_CASE("node_map churn with group probing")
+{
+    check_churn<dryad::group_probing>();
+}
+
+namespace
+{
+// Removes every other node, the values need to follow moved entries.
+template <typename Map>
+void check_remove_if(std::size_t count)
+{
+    dryad::tree<node>  tree;
+    std::vector<node*> nodes;
+    Map                map;
+    for (auto i = std::size_t(0); i != count; ++i)
+    {
+        nodes.push_back(tree.create<node>());
+        map.insert(nodes.back(), std::to_string(i));
+    }
+
+    std::vector<int> visits(count);
+    auto             removed = map.remove_if([&](node* n, std::string& value) {
+        auto idx = std::size_t(std::stoi(value));
+        CHECK(nodes[idx] == n);
+        ++visits[idx];
+        return idx % 2 == 0;
+    });
+    CHECK(removed == (count + 1) / 2);
+    CHECK(map.size() == count - removed);
+
+    for (auto i = std::size_t(0); i != count; ++i)
+    {
+        CHECK(visits[i] == 1);
+        if (i % 2 == 0)
+            CHECK(!map.contains(nodes[i]));
+        else
+        {
+            REQUIRE(map.contains(nodes[i]));
+            CHECK(*map.lookup(nodes[i]) == std::to_string(i));
+        }
+    }
+}
+} // namespace
+
+TEST_CASE("node_map remove_if")
+{
+    check_remove_if<dryad::node_map<node, std::string>>(1000);
+    check_remove_if<dryad::node_map<node, std::string, void, void, dryad::group_probing>>(1000);
+
+    SUBCASE("small mode")
+    {
+        dryad::tree<node>          tree;
+        dryad::node_map<node, int> map;
+        std::vector<node*>         nodes;
+        for (auto i = 0; i != 5; ++i)
+        {
+            nodes.push_back(tree.create<node>());
+            map.insert(nodes.back(), i);
+        }
+
+        CHECK(map.remove_if([](node*, int value) { return value % 2 == 0; }) == 3);
+        CHECK(map.size() == 2);
+        CHECK(map.capacity() == 0);
+        for (auto i = std::size_t(0); i != nodes.size(); ++i)
+            CHECK(map.contains(nodes[i]) == (i % 2 == 1));
+    }
+    SUBCASE("node_set")
+    {
+        dryad::tree<node>     tree;
+        dryad::node_set<node> set;
+        std::vector<node*>    nodes;
+        for (auto i = 0; i != 100; ++i)
+        {
+            nodes.push_back(tree.create<node>());
+            set.insert(nodes.back());
+        }
+
+        CHECK(set.remove_if([&](node* n) { return n == nodes[0] || n == nodes[99]; }) == 2);
+        CHECK(set.size() == 98);
+        CHECK(!set.contains(nodes[0]));
+        CHECK(set.contains(nodes[1]));
+        CHECK(!set.contains(nodes[99]));
+    }
+}
+
@@ -0,0 +1,146 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/node_vector.hpp>
+
+#include <doctest/doctest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+enum class node_kind
+{
+    leaf,
+    container,
+};
+} // namespace
+
+template <>
+constexpr bool dryad::enable_node_numbering<node_kind> = true;
+
+namespace
+{
+using node = dryad::node<node_kind>;
+
+struct leaf_node : dryad::basic_node<node_kind::leaf>
+{
+    DRYAD_NODE_CTOR(leaf_node);
+};
+
+struct container_node : dryad::basic_node<node_kind::container, dryad::container_node<node>>
+{
+    DRYAD_NODE_CTOR(container_node);
+
+    void insert_front(node* n)
+    {
+        this->insert_child_after(nullptr, n);
+    }
+};
+
+template <typename Creator>
+container_node* make_tree(Creator& creator)
+{
+    auto inner = creator.template create<container_node>();
+    inner->insert_front(creator.template create<leaf_node>());
+    inner->insert_front(creator.template create<leaf_node>());
+
+    auto result = creator.template create<container_node>();
+    result->insert_front(creator.template create<leaf_node>());
+    result->insert_front(inner);
+    return result;
+}
+} // namespace
+
+TEST_CASE("number_nodes")
+{
+    SUBCASE("tree")
+    {
+        dryad::tree<container_node> tree;
+        CHECK(dryad::number_nodes(tree) == 0);
+        CHECK(dryad::number_nodes(tree, 3) == 3);
+
+        tree.set_root(make_tree(tree));
+        CHECK(dryad::number_nodes(tree) == 5);
+
+        auto expected = 0u;
+        for (auto [ev, n] : dryad::traverse(tree))
+            if (ev != dryad::traverse_event::exit)
+                CHECK(dryad::node_id(n) == expected++);
+
+        CHECK(dryad::number_nodes(tree, 10) == 15);
+        CHECK(dryad::node_id(tree.root()) == 10);
+
+        // The largest id is one less than the maximum, which is returned.
+        CHECK(dryad::number_nodes(tree, UINT32_MAX - 5) == UINT32_MAX);
+        CHECK(dryad::node_id(tree.root()) == UINT32_MAX - 5);
+    }
+    SUBCASE("forest")
+    {
+        dryad::forest<container_node> forest;
+        for (auto i = 0; i != 3; ++i)
+            forest.insert_root(make_tree(forest));
+        CHECK(dryad::number_nodes(forest) == 15);
+
+        auto expected = 0u;
+        for (auto root : forest.roots())
+        {
+            CHECK(dryad::node_id(root) == expected);
+            expected += 5;
+        }
+    }
+}
+
+TEST_CASE("node_vector")
+{
+    dryad::tree<container_node> tree;
+    tree.set_root(make_tree(tree));
+    auto count = dryad::number_nodes(tree);
+
+    dryad::node_vector<const node, std::string> vec;
+    CHECK(vec.empty());
+    CHECK(vec.size() == 0);
+    CHECK(vec.allocated_bytes() == 0);
+
+    vec.resize(count);
+    CHECK(vec.size() == count);
+    CHECK(vec.allocated_bytes() >= count * sizeof(std::string));
+
+    std::vector<const node*> nodes;
+    for (auto [ev, n] : dryad::traverse(tree))
+        if (ev != dryad::traverse_event::exit)
+        {
+            CHECK(vec[n].empty());
+            vec[n] = std::to_string(nodes.size());
+            nodes.push_back(n);
+        }
+
+    SUBCASE("move")
+    {
+        decltype(vec) other(DRYAD_MOV(vec));
+        CHECK(vec.empty());
+        vec = DRYAD_MOV(other);
+    }
+    SUBCASE("grow")
+    {
+        vec.resize(2 * count);
+        CHECK(vec.size() == 2 * count);
+        CHECK(vec.data()[count].empty());
+    }
+    for (auto i = std::size_t(0); i != nodes.size(); ++i)
+        CHECK(vec[nodes[i]] == std::to_string(i));
+
+    vec.resize(1);
+    CHECK(vec.size() == 1);
+    CHECK(vec[tree.root()] == "0");
+
+    vec.clear();
+    CHECK(vec.empty());
+    CHECK(vec.allocated_bytes() == 0);
+
+    dryad::node_vector<node, int> ints(count);
+    CHECK(ints.size() == count);
+    ints[tree.root()] = 42;
+    CHECK(ints.data()[0] == 42);
+}
+
@@ -0,0 +1,182 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/parallel_build.hpp>
+
+#include <doctest/doctest.h>
+#include <vector>
+
+namespace
+{
+enum class node_kind
+{
+    leaf,
+    container,
+};
+
+using node = dryad::node<node_kind>;
+
+struct leaf_node : dryad::basic_node<node_kind::leaf>
+{
+    int data;
+
+    leaf_node(dryad::node_ctor ctor, int i) : node_base(ctor), data(i) {}
+};
+
+struct container_node : dryad::basic_node<node_kind::container, dryad::container_node<node>>
+{
+    DRYAD_NODE_CTOR(container_node);
+
+    void insert_front(node* n)
+    {
+        this->insert_child_after(nullptr, n);
+    }
+};
+
+struct node_hasher : dryad::node_hasher_base<node_hasher, leaf_node, container_node>
+{
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, const leaf_node* n)
+    {
+        hasher.hash_scalar(n->data);
+    }
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm&, const container_node*)
+    {}
+
+    static bool is_equal(const leaf_node* lhs, const leaf_node* rhs)
+    {
+        return lhs->data == rhs->data;
+    }
+    static bool is_equal(const container_node*, const container_node*)
+    {
+        return true;
+    }
+};
+
+// Creates a container with `count` leaves whose data sum up to `count * (count - 1) / 2`.
+template <typename Creator>
+container_node* make_tree(Creator& creator, int count)
+{
+    auto result = creator.template create<container_node>();
+    for (auto i = 0; i != count; ++i)
+        result->insert_front(creator.template create<leaf_node>(i));
+    return result;
+}
+
+int sum(const node* root)
+{
+    auto result = 0;
+    dryad::visit_tree(root, [&](const leaf_node* n) { result += n->data; });
+    return result;
+}
+
+template <typename Executor>
+void check_parallel_build(Executor executor)
+{
+    SUBCASE("forest")
+    {
+        dryad::forest<container_node> forest;
+        forest.insert_root(make_tree(forest, 1));
+
+        dryad::parallel_build(forest, 100, executor,
+                              [](dryad::forest<container_node>& part, std::size_t i) {
+                                  // Two roots per task.
+                                  part.insert_root(make_tree(part, int(i)));
+                                  part.insert_root(make_tree(part, 2));
+                              });
+
+        std::vector<int> sums;
+        for (auto root : forest.roots())
+            sums.push_back(sum(root));
+        REQUIRE(sums.size() == 201);
+        CHECK(sums[0] == 0);
+        for (auto i = 0; i != 100; ++i)
+        {
+            CHECK(sums[std::size_t(2 * i + 1)] == i * (i - 1) / 2);
+            CHECK(sums[std::size_t(2 * i + 2)] == 1);
+        }
+        CHECK(forest.memory_statistics().block_count >= 100);
+    }
+    SUBCASE("hash_forest")
+    {
+        using forest_type = dryad::hash_forest<container_node, node_hasher>;
+        forest_type forest;
+        auto existing = forest.create<container_node>();
+
+        std::vector<container_node*> roots(100);
+        std::vector<int>             interned_count(100);
+        std::vector<char>            is_dup(100);
+        dryad::parallel_build(
+            forest, roots.size(), executor,
+            [&](forest_type& part, std::size_t i) {
+                roots[i] = part.build([&](auto creator) { return make_tree(creator, int(i % 10)); });
+                // A duplicate within the task.
+                auto dup = part.build([&](auto creator) { return make_tree(creator, int(i % 10)); });
+                is_dup[i] = dup == roots[i];
+            },
+            [&](std::size_t i, container_node* root, container_node* result) {
+                CHECK(root == roots[i]);
+                roots[i] = result;
+                ++interned_count[i];
+            });
+
+        // i % 10 == 0 produces an empty container, which already exists.
+        CHECK(forest.root_count() == 10);
+        CHECK(roots[0] == existing);
+        for (auto i = std::size_t(0); i != roots.size(); ++i)
+        {
+            CHECK(is_dup[i]);
+            CHECK(interned_count[i] == 1);
+            CHECK(roots[i] == roots[i % 10]);
+            CHECK(sum(roots[i]) == int(i % 10) * int(i % 10 - 1) / 2);
+        }
+    }
+    SUBCASE("block size")
+    {
+        // The parts allocate their blocks like the target forest.
+        std::vector<std::size_t> block_sizes(4);
+        std::vector<char>        is_geometric(4);
+
+        dryad::forest<container_node> forest(1024, dryad::arena_growth::geometric);
+        dryad::parallel_build(forest, 4, executor,
+                              [&](dryad::forest<container_node>& part, std::size_t i) {
+                                  block_sizes[i]  = part.block_size();
+                                  is_geometric[i] = part.growth() == dryad::arena_growth::geometric;
+                                  part.insert_root(make_tree(part, 2));
+                              });
+        CHECK(block_sizes == std::vector<std::size_t>(4, 1024));
+        CHECK(is_geometric == std::vector<char>(4, 1));
+        CHECK(forest.memory_statistics().bytes_reserved == 4 * 1024);
+
+        using forest_type = dryad::hash_forest<container_node, node_hasher>;
+        forest_type hash_forest(2048);
+        dryad::parallel_build(hash_forest, 4, executor, [&](forest_type& part, std::size_t i) {
+            block_sizes[i]  = part.block_size();
+            is_geometric[i] = part.growth() == dryad::arena_growth::geometric;
+        });
+        CHECK(block_sizes == std::vector<std::size_t>(4, 2048));
+        CHECK(is_geometric == std::vector<char>(4, 0));
+    }
+    SUBCASE("no tasks")
+    {
+        dryad::forest<container_node> forest;
+        dryad::parallel_build(forest, 0, executor,
+                              [](dryad::forest<container_node>&, std::size_t) {});
+        CHECK(forest.roots().begin() == forest.roots().end());
+    }
+}
+} // namespace
+
+TEST_CASE("parallel_build")
+{
+    SUBCASE("sequential_executor")
+    {
+        check_parallel_build(dryad::sequential_executor{});
+    }
+    SUBCASE("thread_executor")
+    {
+        check_parallel_build(dryad::thread_executor(4));
+    }
+}
+
@@ -0,0 +1,180 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/parallel_visit.hpp>
+
+#include <atomic>
+#include <doctest/doctest.h>
+#include <dryad/hash_forest.hpp>
+
+namespace
+{
+enum class node_kind
+{
+    leaf,
+    container,
+};
+
+using node = dryad::node<node_kind>;
+
+struct leaf_node : dryad::basic_node<node_kind::leaf>
+{
+    int data;
+
+    leaf_node(dryad::node_ctor ctor, int i) : node_base(ctor), data(i) {}
+};
+
+struct container_node : dryad::basic_node<node_kind::container, dryad::container_node<node>>
+{
+    DRYAD_NODE_CTOR(container_node);
+
+    void insert_front(node* n)
+    {
+        this->insert_child_after(nullptr, n);
+    }
+};
+
+struct node_hasher : dryad::node_hasher_base<node_hasher, leaf_node, container_node>
+{
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm& hasher, const leaf_node* n)
+    {
+        hasher.hash_scalar(n->data);
+    }
+    template <typename HashAlgorithm>
+    static void hash(HashAlgorithm&, const container_node*)
+    {}
+
+    static bool is_equal(const leaf_node* lhs, const leaf_node* rhs)
+    {
+        return lhs->data == rhs->data;
+    }
+    static bool is_equal(const container_node*, const container_node*)
+    {
+        return true;
+    }
+};
+
+struct counting_resource
+{
+    std::size_t allocation_count = 0;
+
+    void* allocate(std::size_t bytes, std::size_t alignment)
+    {
+        ++allocation_count;
+        return dryad::_detail::default_memory_resource::allocate(bytes, alignment);
+    }
+
+    void deallocate(void* ptr, std::size_t bytes, std::size_t alignment) noexcept
+    {
+        --allocation_count;
+        dryad::_detail::default_memory_resource::deallocate(ptr, bytes, alignment);
+    }
+};
+
+// Creates a container with `count` leaves whose data sum up to `count * (count - 1) / 2`.
+template <typename Creator>
+container_node* make_tree(Creator& creator, int count)
+{
+    auto result = creator.template create<container_node>();
+    for (auto i = 0; i != count; ++i)
+        result->insert_front(creator.template create<leaf_node>(i));
+    return result;
+}
+
+template <typename Executor>
+void check_parallel_visit(Executor executor)
+{
+    SUBCASE("forest")
+    {
+        dryad::forest<container_node> forest;
+        auto                          expected = 0;
+        for (auto i = 1; i <= 100; ++i)
+        {
+            forest.insert_root(make_tree(forest, i));
+            expected += i * (i - 1) / 2;
+        }
+
+        std::atomic<int> sum(0);
+        std::atomic<int> container_count(0);
+        dryad::parallel_visit_tree(
+            forest, executor, [&](leaf_node* n) { sum += n->data; },
+            [&](dryad::traverse_event_enter, container_node*) { ++container_count; });
+        CHECK(sum == expected);
+        CHECK(container_count == 100);
+
+        const auto& cforest = forest;
+        sum                 = 0;
+        dryad::parallel_visit_tree(cforest, executor, [&](const leaf_node* n) { sum += n->data; });
+        CHECK(sum == expected);
+    }
+    SUBCASE("empty forest")
+    {
+        dryad::forest<container_node> forest;
+        std::atomic<int>              count(0);
+        dryad::parallel_visit_tree(forest, executor, [&](const node*) { ++count; });
+        CHECK(count == 0);
+    }
+    SUBCASE("hash_forest")
+    {
+        dryad::hash_forest<node, node_hasher> forest;
+        for (auto i = 0; i != 100; ++i)
+            forest.create<leaf_node>(i % 50);
+        CHECK(forest.root_count() == 50);
+
+        std::atomic<int> sum(0);
+        dryad::parallel_visit_tree(forest, executor, [&](const leaf_node* n) { sum += n->data; });
+        CHECK(sum == 49 * 50 / 2);
+    }
+    SUBCASE("memory resource")
+    {
+        counting_resource                                resource;
+        dryad::forest<container_node, counting_resource> forest(&resource);
+        for (auto i = 0; i != 4; ++i)
+            forest.insert_root(make_tree(forest, 10));
+        auto forest_allocations = resource.allocation_count;
+
+        // The roots are collected in memory of the forest's resource, which is freed afterwards.
+        std::atomic<std::size_t> allocations(0);
+        dryad::parallel_visit_tree(forest, executor, [&](dryad::traverse_event_enter,
+                                                         const container_node*) {
+            allocations = resource.allocation_count;
+        });
+        CHECK(allocations == forest_allocations + 1);
+        CHECK(resource.allocation_count == forest_allocations);
+    }
+    SUBCASE("children")
+    {
+        dryad::tree<container_node> tree;
+        auto                        root = tree.create<container_node>();
+        for (auto i = 0; i != 100; ++i)
+            root->insert_front(make_tree(tree, 10));
+        tree.set_root(root);
+
+        std::atomic<int> sum(0);
+        std::atomic<int> container_count(0);
+        dryad::parallel_visit_children(
+            tree.root(), executor, [&](const leaf_node* n) { sum += n->data; },
+            [&](dryad::traverse_event_enter, const container_node*) { ++container_count; });
+        CHECK(sum == 100 * 45);
+        CHECK(container_count == 100); // the root itself isn't visited
+    }
+}
+} // namespace
+
+TEST_CASE("parallel_visit_tree")
+{
+    SUBCASE("sequential_executor")
+    {
+        check_parallel_visit(dryad::sequential_executor{});
+    }
+    SUBCASE("thread_executor")
+    {
+        check_parallel_visit(dryad::thread_executor(4));
+    }
+    SUBCASE("thread_executor with one thread")
+    {
+        check_parallel_visit(dryad::thread_executor(1));
+    }
+}
+
@@ -0,0 +1,86 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/parent_index.hpp>
+
+#include <doctest/doctest.h>
+#include <iterator>
+
+namespace
+{
+enum class node_kind
+{
+    leaf,
+    container,
+};
+
+using node = dryad::node<node_kind>;
+
+struct leaf_node : dryad::basic_node<node_kind::leaf>
+{
+    DRYAD_NODE_CTOR(leaf_node);
+};
+
+struct container_node : dryad::basic_node<node_kind::container, dryad::container_node<node>>
+{
+    DRYAD_NODE_CTOR(container_node);
+
+    void insert_front(node* n)
+    {
+        this->insert_child_after(nullptr, n);
+    }
+};
+} // namespace
+
+TEST_CASE("parent_index")
+{
+    dryad::tree<container_node> tree;
+
+    SUBCASE("empty")
+    {
+        dryad::parent_index<node_kind> index(tree);
+        CHECK(index.empty());
+        CHECK(index.size() == 0);
+    }
+
+    auto root = tree.create<container_node>();
+    for (auto i = 0; i != 100; ++i)
+    {
+        auto child = tree.create<container_node>();
+        child->insert_front(tree.create<leaf_node>());
+        child->insert_front(tree.create<leaf_node>());
+        root->insert_front(child);
+    }
+    root->insert_front(tree.create<container_node>()); // empty container
+    tree.set_root(root);
+
+    dryad::parent_index<node_kind> index(tree);
+    CHECK(!index.empty());
+    CHECK(index.size() == 1 + 101 + 200);
+    CHECK(index.allocated_bytes() > 0);
+
+    for (auto [ev, n] : dryad::traverse(tree))
+    {
+        REQUIRE(index.contains(n));
+        CHECK(index.parent(n) == n->parent());
+    }
+    CHECK(index.parent(root) == root);
+
+    dryad::tree<container_node> other;
+    CHECK(!index.contains(other.create<leaf_node>()));
+
+    SUBCASE("subtree")
+    {
+        auto                           child = *root->children().begin();
+        dryad::parent_index<node_kind> subtree_index(child);
+        CHECK(subtree_index.size() == 1);
+        CHECK(subtree_index.parent(child) == root);
+
+        auto last = *std::next(root->children().begin(), 100);
+        subtree_index.insert(last);
+        CHECK(subtree_index.size() == 4);
+        for (auto grand_child : last->children())
+            CHECK(subtree_index.parent(grand_child) == last);
+    }
+}
+
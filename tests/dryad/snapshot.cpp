@@ -0,0 +1,256 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/snapshot.hpp>
+
+#include <cstring>
+#include <doctest/doctest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+enum class node_kind
+{
+    leaf,
+    value,
+    container,
+};
+
+using node = dryad::node<node_kind>;
+
+struct leaf_node : dryad::basic_node<node_kind::leaf>
+{
+    DRYAD_NODE_CTOR(leaf_node);
+};
+
+struct value_node : dryad::basic_node<node_kind::value>
+{
+    int value;
+
+    value_node(dryad::node_ctor ctor, int value) : node_base(ctor), value(value) {}
+};
+
+struct container_node : dryad::basic_node<node_kind::container, dryad::container_node<node>>
+{
+    DRYAD_NODE_CTOR(container_node);
+
+    void insert_front(node* n)
+    {
+        this->insert_child_after(nullptr, n);
+    }
+};
+
+template <typename Creator>
+container_node* make_tree(Creator& creator, int count)
+{
+    auto result = creator.template create<container_node>();
+    result->insert_front(creator.template create<container_node>()); // empty container
+    for (auto i = 0; i != count; ++i)
+    {
+        auto child = creator.template create<container_node>();
+        child->insert_front(creator.template create<value_node>(i));
+        child->insert_front(creator.template create<leaf_node>());
+        result->insert_front(child);
+    }
+    result->insert_front(creator.template create<value_node>(-1));
+    return result;
+}
+
+// Describes the tree, including all links, as a string.
+std::string to_string(const node* root)
+{
+    std::string result;
+    for (auto [ev, n] : dryad::traverse(root))
+    {
+        if (ev == dryad::traverse_event::exit)
+        {
+            result += ")";
+            continue;
+        }
+
+        if (auto value = dryad::node_try_cast<value_node>(n))
+            result += std::to_string(value->value);
+        else if (ev == dryad::traverse_event::leaf)
+            result += "l";
+        result += std::to_string(int(n->color()));
+        if (ev == dryad::traverse_event::enter)
+            result += "(";
+        else if (n->parent() != root && n->parent()->children().front() != n)
+            result += ","; // checks the parent link
+    }
+    return result;
+}
+
+using buffer = std::vector<std::max_align_t>;
+
+template <typename Container>
+buffer write(const Container& container, std::size_t& size)
+{
+    size = dryad::snapshot_size<leaf_node, value_node, container_node>(container);
+    buffer result(size / sizeof(std::max_align_t) + 1);
+    auto   written = dryad::write_snapshot<leaf_node, value_node, container_node>(container,
+                                                                                result.data(),
+                                                                                size);
+    CHECK(written == size);
+    return result;
+}
+} // namespace
+
+TEST_CASE("tree snapshot")
+{
+    dryad::tree<container_node> tree;
+
+    SUBCASE("empty")
+    {
+        auto size  = std::size_t(0);
+        auto image = write(tree, size);
+
+        auto view = dryad::relocate_snapshot<container_node, leaf_node, value_node,
+                                             container_node>(image.data(), size);
+        REQUIRE(view);
+        CHECK(view.root_count() == 0);
+
+        dryad::tree<container_node> loaded;
+        loaded.set_root(loaded.create<container_node>());
+        CHECK(dryad::load_snapshot<leaf_node, value_node, container_node>(loaded, image.data(),
+                                                                          size));
+        CHECK(!loaded.has_root());
+    }
+
+    tree.set_root(make_tree(tree, 10));
+    tree.root()->children().front()->set_color(dryad::color::grey);
+    auto expected = to_string(tree.root());
+
+    auto size  = std::size_t(0);
+    auto image = write(tree, size);
+    CHECK(size < tree.memory_statistics().bytes_used + 128);
+
+    SUBCASE("relocate in place")
+    {
+        auto view = dryad::relocate_snapshot<container_node, leaf_node, value_node,
+                                             container_node>(image.data(), size);
+        REQUIRE(view);
+        REQUIRE(view.root_count() == 1);
+
+        auto root = view.root(0);
+        CHECK(root->parent() == root);
+        CHECK(to_string(root) == expected);
+
+        auto begin = reinterpret_cast<const char*>(image.data());
+        for (auto [ev, n] : dryad::traverse(root))
+        {
+            auto ptr = reinterpret_cast<const char*>(n);
+            CHECK(begin < ptr);
+            CHECK(ptr < begin + size);
+        }
+    }
+    SUBCASE("load into tree")
+    {
+        dryad::tree<container_node> loaded;
+        REQUIRE(dryad::load_snapshot<leaf_node, value_node, container_node>(loaded, image.data(),
+                                                                            size));
+        REQUIRE(loaded.has_root());
+        CHECK(to_string(loaded.root()) == expected);
+
+        // The loaded tree can be modified like any other.
+        loaded.root()->insert_front(loaded.create<leaf_node>());
+        CHECK(to_string(loaded.root()) == "0(l0" + expected.substr(2));
+    }
+    SUBCASE("invalid")
+    {
+        auto bytes = reinterpret_cast<unsigned char*>(image.data());
+        SUBCASE("size")
+        {
+            auto view = dryad::relocate_snapshot<container_node, leaf_node, value_node,
+                                                 container_node>(image.data(), size - 1);
+            CHECK(!view);
+        }
+        SUBCASE("magic")
+        {
+            bytes[0] ^= 0xFF;
+            auto view = dryad::relocate_snapshot<container_node, leaf_node, value_node,
+                                                 container_node>(image.data(), size);
+            CHECK(!view);
+        }
+        SUBCASE("node types")
+        {
+            auto view = dryad::relocate_snapshot<container_node, leaf_node, container_node>(
+                image.data(), size);
+            CHECK(!view);
+        }
+        SUBCASE("link out of bounds")
+        {
+            // The first node is the root, its link points to itself.
+            std::uint64_t root_offset;
+            std::memcpy(&root_offset, bytes + 32, sizeof(std::uint64_t));
+            auto big_offset = std::uintptr_t(size + 8) | 0b1;
+            std::memcpy(bytes + root_offset, &big_offset, sizeof(big_offset));
+
+            auto view = dryad::relocate_snapshot<container_node, leaf_node, value_node,
+                                                 container_node>(image.data(), size);
+            CHECK(!view);
+        }
+        SUBCASE("load")
+        {
+            bytes[0] ^= 0xFF;
+
+            dryad::tree<container_node> loaded;
+            CHECK(!dryad::load_snapshot<leaf_node, value_node, container_node>(loaded,
+                                                                               image.data(), size));
+            CHECK(!loaded.has_root());
+            CHECK(loaded.memory_statistics().bytes_used == 0);
+        }
+    }
+}
+
+TEST_CASE("forest snapshot")
+{
+    dryad::forest<container_node> forest;
+    std::vector<std::string>      expected;
+    for (auto i = 0; i != 5; ++i)
+    {
+        auto root = make_tree(forest, i);
+        forest.insert_root(root);
+        expected.push_back(to_string(root));
+    }
+
+    auto size  = std::size_t(0);
+    auto image = write(forest, size);
+
+    SUBCASE("relocate in place")
+    {
+        auto view = dryad::relocate_snapshot<container_node, leaf_node, value_node,
+                                             container_node>(image.data(), size);
+        REQUIRE(view);
+        REQUIRE(view.root_count() == 5);
+        for (auto i = 0u; i != 5; ++i)
+            CHECK(to_string(view.root(i)) == expected[i]);
+    }
+    SUBCASE("load into forest")
+    {
+        dryad::forest<container_node> loaded;
+        loaded.insert_root(make_tree(loaded, 3));
+        REQUIRE(dryad::load_snapshot<leaf_node, value_node, container_node>(loaded, image.data(),
+                                                                            size));
+
+        auto idx = 0u;
+        for (auto root : loaded.roots())
+        {
+            if (idx == 0)
+                CHECK(to_string(root) == expected[3]);
+            else
+                CHECK(to_string(root) == expected[idx - 1]);
+            ++idx;
+        }
+        CHECK(idx == 6);
+    }
+    SUBCASE("load into tree")
+    {
+        dryad::tree<container_node> loaded;
+        CHECK(!dryad::load_snapshot<leaf_node, value_node, container_node>(loaded, image.data(),
+                                                                           size));
+        CHECK(!loaded.has_root());
+    }
+}
+
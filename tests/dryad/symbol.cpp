@@ -5,21 +5,40 @@
 
 #include <doctest/doctest.h>
 #include <set>
+#include <string>
+#include <vector>
 
-TEST_CASE("symbol_interner")
+namespace
+{
+template <typename Interner>
+void check_interner()
 {
-    dryad::symbol_interner<void> symbols;
+    Interner symbols;
 
     SUBCASE("reserve")
     {
+        CHECK(symbols.allocated_bytes() == 0);
         symbols.reserve(10, 3);
+        CHECK(symbols.allocated_bytes() >= 30);
+    }
+    SUBCASE("table_statistics")
+    {
+        CHECK(symbols.table_statistics().capacity == 0);
+        symbols.intern("hello");
+        symbols.intern("world");
+        symbols.intern("hello");
+
+        auto stats = symbols.table_statistics();
+        CHECK(stats.size == 2);
+        CHECK(stats.removed == 0);
+        CHECK(stats.total_probe_length >= 2);
     }
     SUBCASE("move assign")
     {
         symbols.intern("hello");
         symbols.intern("world");
 
-        dryad::symbol_interner<void> other;
+        Interner other;
         other.reserve(10, 3);
         symbols = DRYAD_MOV(other);
     }
@@ -32,6 +51,12 @@ TEST_CASE("symbol_interner")
     auto abc3 = symbols.intern("abcd", 3);
     CHECK(abc1 == abc3);
 
+    auto abcd = symbols.intern("abcd");
+    CHECK(abcd != abc1);
+    CHECK(abcd.c_str(symbols) == doctest::String("abcd"));
+    CHECK(symbols.intern("abc", 3) == abc1);
+    CHECK(symbols.intern("ab") != abc1);
+
     SUBCASE("move construct")
     {
         auto other = DRYAD_MOV(symbols);
@@ -44,7 +69,7 @@ TEST_CASE("symbol_interner")
 
     SUBCASE("many symbols interned")
     {
-        std::set<decltype(symbols)::symbol> ids;
+        std::set<typename Interner::symbol> ids;
         for (auto i = 0u; i < 10 * 1024; ++i)
         {
             auto string = doctest::toString(std::uint64_t(-1) - i);
@@ -62,3 +87,274 @@ TEST_CASE("symbol_interner")
     }
 }
 
+template <typename Interner>
+void check_snapshot()
+{
+    Interner                 symbols;
+    std::vector<std::string> strings;
+    for (auto i = 0u; i != 1000; ++i)
+    {
+        strings.push_back("symbol" + std::to_string(i));
+        symbols.intern(strings.back().c_str(), strings.back().size());
+    }
+
+    std::vector<std::uint64_t> image(symbols.snapshot_size() / sizeof(std::uint64_t) + 1);
+    auto size = symbols.write_snapshot(image.data(), image.size() * sizeof(std::uint64_t));
+    CHECK(size == symbols.snapshot_size());
+
+    Interner loaded;
+    loaded.intern("other");
+    REQUIRE(loaded.load_snapshot(image.data(), size));
+    for (auto i = 0u; i != 1000; ++i)
+    {
+        auto expected = symbols.intern(strings[i].c_str(), strings[i].size());
+        auto sym      = loaded.intern(strings[i].c_str(), strings[i].size());
+        CHECK(sym == expected);
+        CHECK(sym.c_str(loaded) == doctest::String(strings[i].c_str()));
+    }
+    // The previous contents are gone, so both intern it as new symbol.
+    CHECK(loaded.intern("other") == symbols.intern("other"));
+
+    SUBCASE("empty")
+    {
+        Interner      empty;
+        std::uint64_t empty_image[8];
+        auto empty_size = empty.write_snapshot(empty_image, sizeof(empty_image));
+        REQUIRE(loaded.load_snapshot(empty_image, empty_size));
+        CHECK(loaded.intern("abc").id() == 0);
+
+        Interner borrowed;
+        REQUIRE(borrowed.borrow_snapshot(empty_image, empty_size));
+        CHECK(borrowed.is_borrowing_snapshot());
+        auto hello = borrowed.intern("hello");
+        CHECK(hello.id() == 0);
+        CHECK(!borrowed.is_borrowing_snapshot());
+        CHECK(hello.c_str(borrowed) == doctest::String("hello"));
+        CHECK(borrowed.intern("hello") == hello);
+        auto world = borrowed.intern("world");
+        CHECK(world != hello);
+        CHECK(world.c_str(borrowed) == doctest::String("world"));
+    }
+    SUBCASE("borrow")
+    {
+        Interner borrowed;
+        REQUIRE(borrowed.borrow_snapshot(image.data(), size));
+        CHECK(borrowed.is_borrowing_snapshot());
+        CHECK(borrowed.allocated_bytes() < 1024);
+
+        auto copy = image;
+        for (auto i = 0u; i != 1000; ++i)
+        {
+            auto expected = symbols.intern(strings[i].c_str(), strings[i].size());
+            auto sym      = borrowed.intern(strings[i].c_str(), strings[i].size());
+            CHECK(sym == expected);
+            CHECK(sym.c_str(borrowed) == doctest::String(strings[i].c_str()));
+        }
+        CHECK(borrowed.is_borrowing_snapshot());
+
+        auto other = borrowed.intern("other");
+        CHECK(!borrowed.is_borrowing_snapshot());
+        CHECK(borrowed.allocated_bytes() > 0);
+        CHECK(other.c_str(borrowed) == doctest::String("other"));
+        CHECK(borrowed.intern(strings[0].c_str(), strings[0].size()).c_str(borrowed)
+              == doctest::String(strings[0].c_str()));
+        CHECK(image == copy); // the snapshot was never written to
+
+        auto moved = DRYAD_MOV(borrowed);
+        CHECK(moved.intern("other") == other);
+    }
+    SUBCASE("invalid")
+    {
+        CHECK(!loaded.load_snapshot(image.data(), size - 1));
+        CHECK(!loaded.borrow_snapshot(image.data(), size - 1));
+
+        reinterpret_cast<unsigned char*>(image.data())[0] ^= 0xFF;
+        CHECK(!loaded.load_snapshot(image.data(), size));
+    }
+}
+
+
+using group_interner = dryad::symbol_interner<void, char, std::size_t, void,
+                                              dryad::default_hash_algorithm, dryad::group_probing>;
+using chunked_interner
+    = dryad::symbol_interner<void, char, std::size_t, void, dryad::default_hash_algorithm,
+                             dryad::linear_probing, dryad::chunked_symbol_storage>;
+} // namespace
+
+TEST_CASE("symbol_interner")
+{
+    check_interner<dryad::symbol_interner<void>>();
+}
+TEST_CASE("symbol_interner with group probing")
+{
+    check_interner<group_interner>();
+}
+TEST_CASE("symbol_interner with chunked storage")
+{
+    check_interner<chunked_interner>();
+}
+
+TEST_CASE("symbol_interner snapshot")
+{
+    check_snapshot<dryad::symbol_interner<void>>();
+}
+TEST_CASE("symbol_interner snapshot with chunked storage")
+{
+    check_snapshot<chunked_interner>();
+}
+TEST_CASE("symbol_interner snapshot with group probing")
+{
+    check_snapshot<group_interner>();
+
+    // The layout of the hash table is different, so it can't load the snapshot of the default.
+    dryad::symbol_interner<void> linear;
+    linear.intern("hello");
+    std::vector<std::uint64_t> image(linear.snapshot_size() / sizeof(std::uint64_t) + 1);
+    auto size = linear.write_snapshot(image.data(), image.size() * sizeof(std::uint64_t));
+
+    group_interner symbols;
+    CHECK(!symbols.load_snapshot(image.data(), size));
+    CHECK(!symbols.borrow_snapshot(image.data(), size));
+}
+
+namespace
+{
+template <typename Interner>
+void check_long_strings(bool is_stable)
+{
+    Interner symbols;
+    auto     first     = symbols.intern("first");
+    auto     first_ptr = first.c_str(symbols);
+
+    std::vector<std::string>         strings;
+    std::vector<dryad::symbol<void>> syms;
+    for (auto length : {10u, 20u * 1024u, 5u, 100u * 1024u, 16u * 1024u - 1u, 16u * 1024u, 7u})
+    {
+        strings.push_back(std::string(length, char('a' + strings.size())));
+        syms.push_back(symbols.intern(strings.back().c_str(), strings.back().size()));
+    }
+
+    for (auto i = 0u; i != strings.size(); ++i)
+    {
+        CHECK(syms[i].c_str(symbols) == doctest::String(strings[i].c_str()));
+        CHECK(symbols.intern(strings[i].c_str(), strings[i].size()) == syms[i]);
+    }
+    CHECK(symbols.intern("first") == first);
+    if (is_stable)
+        // Existing strings are never moved.
+        CHECK(first.c_str(symbols) == first_ptr);
+
+    std::vector<std::uint64_t> image(symbols.snapshot_size() / sizeof(std::uint64_t) + 1);
+    auto size = symbols.write_snapshot(image.data(), image.size() * sizeof(std::uint64_t));
+
+    Interner loaded;
+    REQUIRE(loaded.load_snapshot(image.data(), size));
+    for (auto i = 0u; i != strings.size(); ++i)
+        CHECK(syms[i].c_str(loaded) == doctest::String(strings[i].c_str()));
+
+    Interner borrowed;
+    REQUIRE(borrowed.borrow_snapshot(image.data(), size));
+    auto new_symbol = borrowed.intern(std::string(30u * 1024u, 'x').c_str(), 30u * 1024u);
+    for (auto i = 0u; i != strings.size(); ++i)
+        CHECK(syms[i].c_str(borrowed) == doctest::String(strings[i].c_str()));
+    CHECK(new_symbol.c_str(borrowed) == doctest::String(std::string(30u * 1024u, 'x').c_str()));
+}
+} // namespace
+
+TEST_CASE("symbol_interner with long strings")
+{
+    check_long_strings<dryad::symbol_interner<void>>(false);
+}
+TEST_CASE("symbol_interner with long strings and chunked storage")
+{
+    check_long_strings<chunked_interner>(true);
+}
+
+TEST_CASE("symbol_interner with custom hash algorithm")
+{
+    dryad::symbol_interner<void, char, std::uint32_t, void, dryad::wyhash_algorithm> symbols;
+
+    std::set<decltype(symbols)::symbol> ids;
+    for (auto i = 0u; i < 10 * 1024; ++i)
+    {
+        auto string = doctest::toString(i);
+        auto id     = symbols.intern(string.c_str(), string.size());
+        CHECK(ids.insert(id).second);
+        CHECK(id.c_str(symbols) == string);
+    }
+    for (auto i = 0u; i < 10 * 1024; ++i)
+    {
+        auto string = doctest::toString(i);
+        auto id     = symbols.intern(string.c_str(), string.size());
+        CHECK(!ids.insert(id).second);
+    }
+}
+namespace
+{
+constexpr auto keywords = dryad::make_symbol_seed("if", "else", "while", "for", "return", "int",
+                                                  "i", "whilst", "");
+static_assert(keywords.size() == 9);
+static_assert(keywords.index(0) == 0);
+static_assert(keywords.index(1) == 3);
+static_assert(keywords.index(2) == 8);
+static_assert(keywords.lookup("while") == 2);
+static_assert(keywords.lookup("whil") == keywords.npos);
+static_assert(keywords.lookup("whilst") == 7);
+static_assert(keywords.lookup("") == 8);
+static_assert(keywords.lookup("foo") == keywords.npos);
+
+constexpr auto no_keywords = dryad::symbol_seed<char, 0, 0>();
+static_assert(no_keywords.lookup("if") == no_keywords.npos);
+} // namespace
+
+TEST_CASE("symbol_seed")
+{
+    using interner = dryad::symbol_interner<void>;
+    constexpr auto if_symbol    = keywords.symbol<interner::symbol>(0);
+    constexpr auto while_symbol = keywords.symbol<interner::symbol>(2);
+
+    interner symbols;
+    symbols.seed(keywords);
+    CHECK(symbols.intern("if") == if_symbol);
+    CHECK(symbols.intern("while") == while_symbol);
+    CHECK(while_symbol.c_str(symbols) == doctest::String("while"));
+    for (auto pos = std::size_t(0); pos != keywords.size(); ++pos)
+    {
+        auto sym = keywords.symbol<interner::symbol>(pos);
+        CHECK(symbols.intern(keywords.c_str(pos), keywords.length(pos)) == sym);
+        CHECK(keywords.lookup(sym.c_str(symbols), keywords.length(pos)) == pos);
+    }
+
+    auto ident = symbols.intern("identifier");
+    CHECK(ident.id() >= keywords.index(keywords.size() - 1));
+    CHECK(keywords.lookup("identifier") == keywords.npos);
+
+    SUBCASE("many strings")
+    {
+        constexpr auto seed = dryad::make_symbol_seed(
+            "alignas", "alignof", "and", "and_eq", "asm", "atomic_cancel", "atomic_commit",
+            "atomic_noexcept", "auto", "bitand", "bitor", "bool", "break", "case", "catch", "char",
+            "char8_t", "char16_t", "char32_t", "class", "compl", "concept", "const", "consteval",
+            "constexpr", "constinit", "const_cast", "continue", "co_await", "co_return",
+            "co_yield", "decltype", "default", "delete", "do", "double", "dynamic_cast", "else",
+            "enum", "explicit", "export", "extern", "false", "float", "for", "friend", "goto", "if",
+            "inline", "int", "long", "mutable", "namespace", "new", "noexcept", "not", "not_eq",
+            "nullptr", "operator", "or", "or_eq", "private", "protected", "public", "reflexpr",
+            "register", "reinterpret_cast", "requires", "return", "short", "signed", "sizeof",
+            "static", "static_assert", "static_cast", "struct", "switch", "synchronized",
+            "template", "this", "thread_local", "throw", "true", "try", "typedef", "typeid",
+            "typename", "union", "unsigned", "using", "virtual", "void", "volatile", "wchar_t",
+            "while", "xor", "xor_eq");
+        static_assert(seed.size() == 97);
+
+        for (auto pos = std::size_t(0); pos != seed.size(); ++pos)
+        {
+            std::string str(seed.c_str(pos));
+            REQUIRE(seed.lookup(str.c_str(), str.size()) == pos);
+
+            str += "_";
+            REQUIRE(seed.lookup(str.c_str(), str.size()) == seed.npos);
+        }
+    }
+}
+
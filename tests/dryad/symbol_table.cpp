@@ -3,8 +3,11 @@
 
 #include <dryad/symbol_table.hpp>
 
+#include <algorithm>
 #include <doctest/doctest.h>
 #include <set>
+#include <string>
+#include <vector>
 
 namespace
 {
@@ -43,6 +46,7 @@ TEST_CASE("symbol_table")
         CHECK(table.empty());
         CHECK(table.size() == 0);
         CHECK(table.capacity() >= 10);
+        CHECK(table.allocated_bytes() >= table.capacity() * 2 * sizeof(void*));
         CHECK(table.begin() == table.end());
     }
     SUBCASE("move")
@@ -102,3 +106,205 @@ TEST_CASE("symbol_table")
     check_iter(table, a, c);
 }
 
+namespace
+{
+using symbol = dryad::symbol_interner<void>::symbol;
+
+template <typename Table>
+void check_remove()
+{
+    dryad::symbol_interner<void> symbols;
+
+    std::vector<symbol> syms;
+    for (auto i = 0; i != 100; ++i)
+    {
+        auto str = std::to_string(i);
+        syms.push_back(symbols.intern(str.c_str(), str.size()));
+    }
+
+    Table            table;
+    std::vector<int> decls(syms.size());
+    for (auto i = std::size_t(0); i != syms.size(); ++i)
+        table.insert_or_shadow(syms[i], &decls[i]);
+
+    // Removing and re-inserting doesn't lose any declaration.
+    for (auto round = 0; round != 10; ++round)
+    {
+        for (auto i = std::size_t(0); i < syms.size(); i += 3)
+            CHECK(table.remove(syms[i]) == &decls[i]);
+        for (auto i = std::size_t(0); i != syms.size(); ++i)
+            REQUIRE(table.lookup(syms[i]) == (i % 3 == 0 ? nullptr : &decls[i]));
+
+        for (auto i = std::size_t(0); i < syms.size(); i += 3)
+            table.insert_or_shadow(syms[i], &decls[i]);
+        for (auto i = std::size_t(0); i != syms.size(); ++i)
+            REQUIRE(table.lookup(syms[i]) == &decls[i]);
+    }
+    CHECK(table.size() == syms.size());
+}
+
+// Removes every other declaration while iterating over all of them.
+template <typename Table>
+void check_remove_if(std::size_t count)
+{
+    dryad::symbol_interner<void> symbols;
+
+    Table            table;
+    std::vector<int> decls(count);
+    for (auto i = std::size_t(0); i != count; ++i)
+    {
+        auto str = std::to_string(i);
+        table.insert_or_shadow(symbols.intern(str.c_str(), str.size()), &decls[i]);
+    }
+
+    std::vector<int> visits(count);
+    auto             removed = table.remove_if([&](auto entry) {
+        auto idx = std::size_t(entry.decl - decls.data());
+        ++visits[idx];
+        return idx % 2 == 0;
+    });
+    CHECK(removed == (count + 1) / 2);
+    CHECK(table.size() == count - removed);
+    CHECK(std::all_of(visits.begin(), visits.end(), [](int v) { return v == 1; }));
+
+    std::vector<int> remaining(count);
+    for (auto [sym, decl] : table)
+    {
+        CHECK(table.lookup(sym) == decl);
+        ++remaining[std::size_t(decl - decls.data())];
+    }
+    for (auto i = std::size_t(0); i != count; ++i)
+        CHECK(remaining[i] == (i % 2 == 0 ? 0 : 1));
+}
+} // namespace
+
+TEST_CASE("symbol_table remove")
+{
+    check_remove<dryad::symbol_table<symbol, int*>>();
+}
+TEST_CASE("symbol_table remove with group probing")
+{
+    check_remove<dryad::symbol_table<symbol, int*, void, dryad::group_probing>>();
+}
+
+TEST_CASE("symbol_table remove_if")
+{
+    using table = dryad::symbol_table<symbol, int*>;
+    check_remove_if<table>(table::small_capacity);
+    check_remove_if<table>(1000);
+}
+TEST_CASE("symbol_table remove_if with group probing")
+{
+    using table = dryad::symbol_table<symbol, int*, void, dryad::group_probing>;
+    check_remove_if<table>(table::small_capacity);
+    check_remove_if<table>(1000);
+}
+
+TEST_CASE("symbol_table small mode")
+{
+    dryad::symbol_interner<void> symbols;
+
+    using table_type = dryad::symbol_table<dryad::symbol_interner<void>::symbol, int*>;
+    std::vector<dryad::symbol_interner<void>::symbol> syms;
+    for (auto i = std::size_t(0); i != table_type::small_capacity + 1; ++i)
+    {
+        auto str = std::to_string(i);
+        syms.push_back(symbols.intern(str.c_str(), str.size()));
+    }
+
+    table_type       table;
+    std::vector<int> decls(syms.size());
+    for (auto i = std::size_t(0); i != table_type::small_capacity; ++i)
+        table.insert_or_shadow(syms[i], &decls[i]);
+    CHECK(table.size() == table_type::small_capacity);
+    CHECK(table.capacity() == 0);
+    CHECK(table.allocated_bytes() == 0);
+
+    // Removing moves the last declaration into the hole.
+    CHECK(table.remove(syms[1]) == &decls[1]);
+    CHECK(table.remove(syms[1]) == nullptr);
+    CHECK(table.lookup(syms[1]) == nullptr);
+    CHECK(table.lookup(syms[table_type::small_capacity - 1])
+          == &decls[table_type::small_capacity - 1]);
+    CHECK(table.insert_or_shadow(syms[1], &decls[1]) == nullptr);
+    CHECK(table.insert_or_shadow(syms[1], &decls[0]) == &decls[1]);
+    CHECK(table.insert_or_shadow(syms[1], &decls[1]) == &decls[0]);
+    CHECK(table.capacity() == 0);
+
+    SUBCASE("move")
+    {
+        table_type other(DRYAD_MOV(table));
+        CHECK(table.empty());
+        table = DRYAD_MOV(other);
+    }
+
+    // One more declaration switches to the hash table.
+    table.insert_or_shadow(syms.back(), &decls.back());
+    CHECK(table.size() == syms.size());
+    CHECK(table.capacity() > table_type::small_capacity);
+    CHECK(table.allocated_bytes() > 0);
+    CHECK(table.table_statistics().size == syms.size());
+    CHECK(table.table_statistics().max_probe_length >= 1);
+
+    auto count = std::size_t(0);
+    for (auto [sym, decl] : table)
+    {
+        auto idx = std::size_t(std::find(syms.begin(), syms.end(), sym) - syms.begin());
+        REQUIRE(idx < syms.size());
+        CHECK(decl == &decls[idx]);
+        ++count;
+    }
+    CHECK(count == syms.size());
+    for (auto i = std::size_t(0); i != syms.size(); ++i)
+        CHECK(table.lookup(syms[i]) == &decls[i]);
+}
+
+TEST_CASE("scoped_symbol_table")
+{
+    dryad::symbol_interner<void> symbols;
+    auto                         a = symbols.intern("a");
+    auto                         b = symbols.intern("b");
+    auto                         c = symbols.intern("c");
+
+    int global_a, outer_a, outer_b, inner_a, inner_a2, inner_c;
+
+    dryad::scoped_symbol_table<decltype(a), int*> table;
+    CHECK(table.empty());
+    CHECK(table.scope_depth() == 0);
+
+    CHECK(table.insert_or_shadow(a, &global_a) == nullptr);
+
+    table.push_scope();
+    CHECK(table.scope_depth() == 1);
+    CHECK(table.insert_or_shadow(a, &outer_a) == &global_a);
+    CHECK(table.insert_or_shadow(b, &outer_b) == nullptr);
+    CHECK(table.lookup(a) == &outer_a);
+    CHECK(table.lookup(b) == &outer_b);
+
+    for (auto round = 0; round != 3; ++round)
+    {
+        table.push_scope();
+        CHECK(table.scope_depth() == 2);
+        CHECK(table.insert_or_shadow(a, &inner_a) == &outer_a);
+        CHECK(table.insert_or_shadow(c, &inner_c) == nullptr);
+        CHECK(table.insert_or_shadow(a, &inner_a2) == &inner_a);
+        CHECK(table.lookup(a) == &inner_a2);
+        CHECK(table.lookup(b) == &outer_b);
+        CHECK(table.lookup(c) == &inner_c);
+        check_iter(table, a, b, c);
+
+        table.pop_scope();
+        CHECK(table.scope_depth() == 1);
+        CHECK(table.lookup(a) == &outer_a);
+        CHECK(table.lookup(b) == &outer_b);
+        CHECK(table.lookup(c) == nullptr);
+        check_iter(table, a, b);
+    }
+
+    table.pop_scope();
+    CHECK(table.scope_depth() == 0);
+    CHECK(table.size() == 1);
+    CHECK(table.lookup(a) == &global_a);
+    CHECK(table.lookup(b) == nullptr);
+}
+
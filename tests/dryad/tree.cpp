@@ -4,7 +4,10 @@
 #include <dryad/tree.hpp>
 
 #include <doctest/doctest.h>
+#include <dryad/abstract_node.hpp>
+#include <dryad/node_map.hpp>
 #include <iterator>
+#include <string>
 
 namespace
 {
@@ -12,6 +15,7 @@ enum class node_kind
 {
     leaf,
     container,
+    value,
 };
 
 using node = dryad::node<node_kind>;
@@ -21,6 +25,13 @@ struct leaf_node : dryad::basic_node<node_kind::leaf>
     DRYAD_NODE_CTOR(leaf_node);
 };
 
+struct value_node : dryad::basic_node<node_kind::value>
+{
+    int value;
+
+    value_node(dryad::node_ctor ctor, int value) : node_base(ctor), value(value) {}
+};
+
 struct container_node : dryad::basic_node<node_kind::container, dryad::container_node<node>>
 {
     DRYAD_NODE_CTOR(container_node);
@@ -42,6 +53,23 @@ TEST_CASE("tree")
     {
         tree.clear();
     }
+    SUBCASE("memory statistics")
+    {
+        tree.create<leaf_node>();
+        auto stats = tree.memory_statistics();
+        CHECK(stats.block_count == 1);
+        CHECK(stats.bytes_used == sizeof(leaf_node));
+    }
+    SUBCASE("clear with budget")
+    {
+        tree.create<leaf_node>();
+        tree.clear(0);
+        CHECK(tree.memory_statistics().block_count == 0);
+
+        tree.create<leaf_node>();
+        tree.shrink_to_fit();
+        CHECK(tree.memory_statistics().block_count == 1);
+    }
 
     auto a = tree.create<leaf_node>();
     auto b = tree.create<leaf_node>();
@@ -123,6 +151,188 @@ TEST_CASE("forest")
     dryad::visit_tree(root2, [&](node* ptr) { CHECK((ptr == root2 || ptr == d)); });
 }
 
+TEST_CASE("tree compact")
+{
+    dryad::tree<container_node> tree;
+
+    SUBCASE("empty")
+    {
+        tree.create<leaf_node>();
+        tree.compact<leaf_node, container_node>();
+        CHECK(!tree.has_root());
+        CHECK(tree.memory_statistics().block_count == 0);
+    }
+
+    // Nodes are created bottom-up and interleaved with garbage.
+    auto root = tree.create<container_node>();
+    for (auto i = 0; i != 100; ++i)
+    {
+        auto child = tree.create<container_node>();
+        tree.create<value_node>(-1);
+        child->insert_front(tree.create<value_node>(i));
+        child->insert_front(tree.create<leaf_node>());
+        tree.create<value_node>(-1);
+        root->insert_front(child);
+    }
+    root->insert_front(tree.create<container_node>()); // empty container
+    tree.set_root(root);
+
+    auto bytes_used = tree.memory_statistics().bytes_used;
+
+    dryad::node_map<const node, node*> remap;
+    tree.compact<leaf_node, value_node, container_node>(
+        [&](const node* old, node* copy) { remap.insert(old, copy); });
+    CHECK(remap.size() == 1 + 101 + 200);
+    CHECK(tree.root() == *remap.lookup(root));
+    CHECK(tree.root()->parent() == tree.root());
+    CHECK(tree.memory_statistics().bytes_used < bytes_used);
+
+    // The tree is stored in pre-order.
+    auto prev  = static_cast<const node*>(nullptr);
+    auto index = 100;
+    for (auto [ev, n] : dryad::traverse(tree))
+    {
+        if (ev == dryad::traverse_event::exit)
+            continue;
+
+        CHECK(prev < n);
+        prev = n;
+
+        if (n != tree.root())
+            CHECK(n->parent()->kind() == node_kind::container);
+        if (auto value = dryad::node_try_cast<value_node>(n))
+        {
+            --index;
+            CHECK(value->value == index);
+            CHECK(n->parent()->parent() == tree.root());
+        }
+    }
+    CHECK(index == 0);
+}
+
+TEST_CASE("forest compact")
+{
+    dryad::forest<container_node> forest;
+    for (auto i = 0; i != 3; ++i)
+    {
+        auto root = forest.create<container_node>();
+        forest.create<leaf_node>();
+        root->insert_front(forest.create<value_node>(i));
+        forest.insert_root(root);
+    }
+
+    auto bytes_used = forest.memory_statistics().bytes_used;
+    forest.compact<leaf_node, value_node, container_node>();
+    CHECK(forest.memory_statistics().bytes_used < bytes_used);
+
+    for (auto i = 0; i != 3; ++i)
+    {
+        auto root = *std::next(forest.roots().begin(), i);
+        CHECK(root->parent() == root);
+
+        auto child = dryad::node_cast<value_node>(*root->children().begin());
+        CHECK(child->value == i);
+        CHECK(child->parent() == root);
+    }
+    CHECK(std::distance(forest.roots().begin(), forest.roots().end()) == 3);
+}
+
+TEST_CASE("tree clone")
+{
+    dryad::tree<container_node> tree;
+
+    SUBCASE("empty")
+    {
+        auto copy = tree.clone<leaf_node, value_node, container_node>();
+        CHECK(!copy.has_root());
+        CHECK(copy.memory_statistics().block_count == 0);
+    }
+
+    auto        root       = tree.create<container_node>();
+    value_node* last_value = nullptr;
+    for (auto i = 0; i != 100; ++i)
+    {
+        auto child = tree.create<container_node>();
+        last_value = tree.create<value_node>(i);
+        child->insert_front(last_value);
+        child->insert_front(tree.create<leaf_node>());
+        root->insert_front(child);
+    }
+    root->insert_front(tree.create<container_node>()); // empty container
+    tree.set_root(root);
+
+    dryad::node_map<const node, node*> remap;
+    auto copy = tree.clone<leaf_node, value_node, container_node>(
+        [&](const node* old, node* copy) { remap.insert(old, copy); });
+    CHECK(remap.size() == 1 + 101 + 200);
+    CHECK(copy.root() == *remap.lookup(root));
+    CHECK(copy.root()->parent() == copy.root());
+    CHECK(copy.memory_statistics().block_count == 1);
+
+    // The copy has the same structure, but shares no nodes.
+    auto cur = dryad::traverse(copy).begin();
+    for (auto [ev, n] : dryad::traverse(tree))
+    {
+        REQUIRE(cur != dryad::traverse(copy).end());
+        CHECK(cur->event == ev);
+        CHECK(cur->node->kind() == n->kind());
+        if (ev != dryad::traverse_event::exit)
+            CHECK(cur->node == *remap.lookup(n));
+        if (auto value = dryad::node_try_cast<value_node>(n))
+            CHECK(dryad::node_cast<value_node>(cur->node)->value == value->value);
+        ++cur;
+    }
+    CHECK(cur == dryad::traverse(copy).end());
+
+    // Modifying the copy doesn't affect the original.
+    auto value = dryad::node_cast<value_node>(*remap.lookup(last_value));
+    CHECK(value->value == 99);
+    value->value = -1;
+    CHECK(last_value->value == 99);
+
+    SUBCASE("clone_subtree")
+    {
+        auto child = dryad::node_cast<container_node>(*std::next(root->children().begin(), 2));
+
+        dryad::forest<container_node> forest;
+        forest.creator().reserve(1024);
+        auto subtree = dryad::clone_subtree<leaf_node, value_node, container_node>(
+            child, forest.creator());
+        CHECK(!subtree->is_linked_in_tree());
+        CHECK(forest.memory_statistics().block_count == 1);
+
+        forest.insert_root(subtree);
+        CHECK(subtree->parent() == subtree);
+        auto children = subtree->children();
+        CHECK(std::distance(children.begin(), children.end()) == 2);
+        CHECK(children.front()->kind() == node_kind::leaf);
+        CHECK(children.front()->parent() == subtree);
+        CHECK(dryad::node_cast<value_node>(*std::next(children.begin()))->value == 98);
+
+        auto leaf = dryad::clone_subtree<leaf_node>(children.front(), forest.creator());
+        CHECK(leaf != children.front());
+        CHECK(leaf->kind() == node_kind::leaf);
+        CHECK(!leaf->is_linked_in_tree());
+    }
+    SUBCASE("after absorb")
+    {
+        // The new version keeps the old nodes alive, but only its own nodes are copied.
+        dryad::tree<container_node> next(1024);
+        next.absorb(DRYAD_MOV(tree));
+        auto next_root = next.create<container_node>();
+        next_root->insert_front(next.create<leaf_node>());
+        next.set_root(next_root);
+        REQUIRE(next.memory_statistics().bytes_used > 1024);
+
+        auto next_copy = next.clone<leaf_node, value_node, container_node>();
+        CHECK(next_copy.memory_statistics().bytes_used
+              == sizeof(container_node) + sizeof(leaf_node));
+        // It uses the block size of next, which fits both nodes.
+        CHECK(next_copy.memory_statistics().block_count == 1);
+        CHECK(next_copy.memory_statistics().bytes_reserved == 1024);
+    }
+}
+
 TEST_CASE("visit_tree")
 {
     dryad::tree<node> tree;
@@ -285,3 +495,97 @@ TEST_CASE("visit_tree")
     }
 }
 
+namespace wide
+{
+// Enough node types that visitors use a dispatch table.
+enum class wide_kind
+{
+    root,
+    leaf1,
+    leaf2,
+    leaf3,
+    leaf4,
+    leaf5,
+    leaf6,
+    leaf7,
+    leaf8,
+    leaf9,
+    unlisted, // bigger than all kinds of the visitor lambdas
+};
+
+using wide_node = dryad::node<wide_kind>;
+
+template <wide_kind Kind>
+struct leaf : dryad::basic_node<Kind>
+{
+    explicit leaf(dryad::node_ctor ctor) : dryad::basic_node<Kind>(ctor) {}
+};
+
+struct odd_leaf : dryad::abstract_node_range<wide_node, wide_kind::leaf5, wide_kind::unlisted>
+{
+    DRYAD_ABSTRACT_NODE_CTOR(odd_leaf);
+};
+
+struct root_node : dryad::basic_node<wide_kind::root, dryad::container_node<wide_node>>
+{
+    DRYAD_NODE_CTOR(root_node);
+
+    void insert_front(wide_node* n)
+    {
+        this->insert_child_after(nullptr, n);
+    }
+};
+} // namespace wide
+
+TEST_CASE("visitors with many node types")
+{
+    using namespace wide;
+
+    dryad::tree<root_node> tree;
+    auto                   root = tree.create<root_node>();
+    root->insert_front(tree.create<leaf<wide_kind::unlisted>>());
+    root->insert_front(tree.create<leaf<wide_kind::leaf9>>());
+    root->insert_front(tree.create<leaf<wide_kind::leaf5>>());
+    root->insert_front(tree.create<leaf<wide_kind::leaf2>>());
+    root->insert_front(tree.create<leaf<wide_kind::leaf1>>());
+    tree.set_root(root);
+
+    std::string result;
+    auto        visit = [&](auto&& visitor) {
+        visitor([&](const odd_leaf*) { result += 'o'; },
+                [&](const leaf<wide_kind::leaf1>*) { result += '1'; },
+                [&](const leaf<wide_kind::leaf2>*) { result += '2'; },
+                [&](const leaf<wide_kind::leaf3>*) { result += '3'; },
+                [&](const leaf<wide_kind::leaf4>*) { result += '4'; },
+                [&](const leaf<wide_kind::leaf5>*) { result += '5'; },
+                [&](const leaf<wide_kind::leaf6>*) { result += '6'; },
+                [&](const leaf<wide_kind::leaf7>*) { result += '7'; },
+                [&](const leaf<wide_kind::leaf8>*) { result += '8'; });
+    };
+
+    SUBCASE("visit_tree")
+    {
+        // Abstract lambdas fall through, the first concrete one wins.
+        visit([&](auto... lambdas) {
+            dryad::visit_tree(
+                tree, lambdas..., [&](const wide_node*) { result += '-'; },
+                [&](const leaf<wide_kind::leaf1>*) { result += 'x'; });
+        });
+        CHECK(result == "-12o5o-o-");
+    }
+    SUBCASE("visit_node")
+    {
+        for (auto child : DRYAD_AS_CONST(root)->children())
+            visit([&](auto... lambdas) { dryad::visit_node(child, lambdas...); });
+        CHECK(result == "12ooo"); // abstract lambdas swallow all matching nodes
+    }
+    SUBCASE("visit_node_all")
+    {
+        for (auto child : DRYAD_AS_CONST(root)->children())
+            visit([&](auto... lambdas) {
+                dryad::visit_node_all(child, lambdas..., [&](const wide_node*) { result += '-'; });
+            });
+        CHECK(result == "12ooo"); // abstract lambdas swallow all matching nodes
+    }
+}
+
@@ -0,0 +1,173 @@
+// Copyright (C) 2022 Jonathan Müller and dryad contributors
+// SPDX-License-Identifier: BSL-1.0
+
+#include <dryad/tree_builder.hpp>
+
+#include <doctest/doctest.h>
+#include <string>
+#include <vector>
+
+namespace
+{
+enum class node_kind
+{
+    leaf,
+    container,
+};
+
+using node = dryad::node<node_kind>;
+
+struct leaf_node : dryad::basic_node<node_kind::leaf>
+{
+    int value;
+
+    leaf_node(dryad::node_ctor ctor, int value) : node_base(ctor), value(value) {}
+};
+
+struct container_node : dryad::basic_node<node_kind::container, dryad::container_node<node>>
+{
+    DRYAD_NODE_CTOR(container_node);
+};
+
+// Describes the tree as a string and checks the parent links.
+std::string to_string(const node* root)
+{
+    std::string result;
+    for (auto [ev, n] : dryad::traverse(root))
+    {
+        if (ev == dryad::traverse_event::exit)
+            result += ")";
+        else if (auto leaf = dryad::node_try_cast<leaf_node>(n))
+            result += std::to_string(leaf->value);
+        else
+            result += "(";
+
+        if (ev == dryad::traverse_event::enter)
+            for (auto child : n->children())
+                CHECK(child->parent() == n);
+    }
+    return result;
+}
+} // namespace
+
+TEST_CASE("tree_builder")
+{
+    dryad::tree<container_node> tree;
+
+    SUBCASE("nested")
+    {
+        dryad::tree_builder<container_node> builder(tree);
+        builder.reserve(8, sizeof(leaf_node));
+        CHECK(builder.stack_size() == 0);
+
+        auto root = builder.start();
+        builder.create<leaf_node>(1);
+        {
+            auto inner = builder.start();
+            builder.create<leaf_node>(2);
+            builder.create<leaf_node>(3);
+            builder.finish<container_node>(inner);
+        }
+        {
+            auto empty = builder.start();
+            builder.finish<container_node>(empty);
+        }
+        builder.push(tree.create<leaf_node>(4));
+        CHECK(builder.stack_size() == 4);
+
+        builder.finish<container_node>(root);
+        CHECK(builder.stack_size() == 1);
+        CHECK(builder.set_root() == tree.root());
+        CHECK(builder.stack_size() == 0);
+
+        CHECK(tree.root()->parent() == tree.root());
+        CHECK(to_string(tree.root()) == "(1(23)()4)");
+    }
+    SUBCASE("single node")
+    {
+        dryad::tree_builder<container_node> builder(tree);
+        builder.finish<container_node>(builder.start());
+        builder.set_root();
+        CHECK(to_string(tree.root()) == "()");
+    }
+    SUBCASE("deep")
+    {
+        dryad::tree_builder<container_node> builder(tree);
+        for (auto i = 0; i != 1000; ++i)
+            builder.create<leaf_node>(i);
+        for (auto i = 0; i != 1000; ++i)
+            builder.finish<container_node>(builder.start()); // stack grows beyond its capacity
+        CHECK(builder.stack_size() == 2000);
+
+        builder.finish<container_node>({0});
+        builder.set_root();
+
+        auto count = 0;
+        for (auto child : tree.root()->children())
+        {
+            if (auto leaf = dryad::node_try_cast<leaf_node>(child))
+                CHECK(leaf->value == count);
+            CHECK(child->parent() == tree.root());
+            ++count;
+        }
+        CHECK(count == 2000);
+    }
+}
+
+TEST_CASE("tree_builder reuse")
+{
+    dryad::tree<container_node> old_tree;
+    {
+        dryad::tree_builder<container_node> builder(old_tree);
+        auto                                root = builder.start();
+        for (auto i = 0; i != 3; ++i)
+        {
+            auto child = builder.start();
+            builder.create<leaf_node>(i);
+            builder.create<leaf_node>(10 + i);
+            builder.finish<container_node>(child);
+        }
+        builder.finish<container_node>(root);
+        builder.set_root();
+    }
+    REQUIRE(to_string(old_tree.root()) == "((010)(111)(212))");
+
+    // Build a new version where the second child changed.
+    dryad::tree<container_node> tree;
+    auto                        old_root = tree.absorb(DRYAD_MOV(old_tree));
+    CHECK(!old_tree.has_root());
+    CHECK(old_tree.memory_statistics().bytes_used == 0);
+
+    std::vector<node*> old_children;
+    for (auto child : old_root->children())
+        old_children.push_back(child);
+
+    dryad::tree_builder<container_node> builder(tree);
+    auto                                root = builder.start();
+    builder.reuse(old_children[0]);
+    builder.create<leaf_node>(42);
+    builder.reuse(old_children[2]);
+    builder.finish<container_node>(root);
+    builder.set_root();
+    CHECK(to_string(tree.root()) == "((010)42(212))");
+
+    SUBCASE("reuse the root")
+    {
+        dryad::tree<container_node> next;
+        auto                        prev = next.absorb(DRYAD_MOV(tree));
+
+        dryad::tree_builder<container_node> next_builder(next);
+        next_builder.reuse(prev);
+        next_builder.set_root();
+        CHECK(next.root() == prev);
+        CHECK(to_string(next.root()) == "((010)42(212))");
+    }
+    SUBCASE("compact")
+    {
+        auto before = tree.memory_statistics().bytes_used;
+        tree.compact<leaf_node, container_node>();
+        CHECK(tree.memory_statistics().bytes_used < before);
+        CHECK(to_string(tree.root()) == "((010)42(212))");
+    }
+}
+